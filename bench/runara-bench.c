@@ -0,0 +1,1758 @@
+/*
+ * runara-bench: Headless benchmarks of the runara renderer.
+ *
+ * Creates a surfaceless EGL context (Mesa's surfaceless platform
+ * if available, so it runs on llvmpipe without any display),
+ * renders into an offscreen framebuffer and prints the median &
+ * p99 timings of every benchmark as JSON. All generated scenes
+ * are seeded, so two runs with the same arguments render exactly
+ * the same content.
+ *
+ * The startup benchmarks measure 'rn_init_ex()' with an empty 
+ * (init_cold) and a populated (init_warm) program binary cache. 
+ * Mesa's shader cache is kept in a private directory that is 
+ * emptied with the program binary cache, so init_cold compiles 
+ * the shaders and init_warm loads the program binaries.
+ *
+ * Usage: runara-bench [--font <path>] [--iterations <n>] [--warmup <n>]
+ *                     [--seed <n>] [--filter <substr>] [--compact]
+ *                     [--no-streaming] [--output <file>]
+ * */
+#define _GNU_SOURCE
+
+#include <runara/runara.h>
+#include <glad/glad.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <ftw.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+
+#define BENCH_NUM_RECTS 20000
+#define BENCH_NUM_STREAM_RECTS 1000000
+#define BENCH_NUM_FILL_RECTS 16
+#define BENCH_NUM_TEXTURES 48
+#define BENCH_NUM_ROWS 10000
+#define BENCH_NUM_GLYPH_LOOKUPS 1000000
+#define BENCH_MAX_LOOKUP_FONTS 64
+#define BENCH_NUM_BATCHES 500
+#define BENCH_NUM_RECORDERS 4
+#define BENCH_NUM_MT_PRIMITIVES 100000
+#define BENCH_MAX_THREADS 64
+#define BENCH_NUM_PANELS 12
+#define BENCH_PANEL_ROWS 40
+#define BENCH_NUM_LAYER_PANELS 16
+#define BENCH_NUM_SEGMENTS 1000000
+#define BENCH_NUM_POLYLINES 1000
+#define BENCH_NUM_SPINNERS 100000
+#define BENCH_NUM_PAINTS 8
+#define BENCH_NUM_WINDOWS 200
+#define BENCH_NUM_BLUR_PANELS 8
+#define BENCH_NUM_SURFACES 4
+#define BENCH_SURFACE_WIDTH 1280
+#define BENCH_SURFACE_HEIGHT 720
+#define BENCH_NUM_DAMAGE_RECTS 64
+
+#define BENCH_DEFAULT_FONT "/usr/share/fonts/truetype/dejavu/DejaVuSans.ttf"
+
+/**
+ * @struct RnBench
+ * @brief The shared state of all benchmarks
+ */
+typedef struct RnBench RnBench;
+
+/**
+ * @struct RnBenchCase
+ * @brief A single benchmark
+ *
+ * 'setup' and 'teardown' run once around all iterations,
+ * 'iter_setup' and 'iter_teardown' around every iteration.
+ * Only 'run' is timed.
+ */
+typedef struct {
+  // The name of the benchmark in the JSON output
+  const char* name;
+  // Whether 'run' renders a frame. The frame time
+  // is only measured for rendering benchmarks.
+  bool frame;
+  void (*setup)(RnBench* b);
+  void (*iter_setup)(RnBench* b);
+  // Runs the benchmark once and returns the number of
+  // processed items (rects, glyphs, bytes...)
+  uint32_t (*run)(RnBench* b);
+  void (*iter_teardown)(RnBench* b);
+  void (*teardown)(RnBench* b);
+} RnBenchCase;
+
+struct RnBench {
+  RnState* state;
+  // The configuration the state was initialized with
+  RnInitConfig config;
+  // A state that is initialized per iteration
+  RnState* init_state;
+  // The shared state while a benchmark renders 
+  // with a state of it's own
+  RnState* main_state;
+  // The program binary cache of the startup benchmarks
+  char cache_dir[64];
+  // The private shader cache of the driver (MESA_SHADER_CACHE_DIR)
+  char driver_cache_dir[64];
+  // The font that is shared by the text benchmarks
+  RnFont* font;
+  // A font that is loaded per iteration
+  RnFont* iter_font;
+  // The fonts whose glyphs fill the glyph cache for the lookup 
+  // benchmarks and the looked up glyphs (font index << 24 | glyph)
+  RnFont* lookup_fonts[BENCH_MAX_LOOKUP_FONTS];
+  uint32_t n_lookup_fonts;
+  uint32_t* lookups;
+  const char* font_path;
+
+  RnTexture textures[BENCH_NUM_TEXTURES];
+  // The textures that are created and freed per 
+  // iteration of the bindless texture benchmark
+  RnTexture iter_textures[BENCH_NUM_TEXTURES];
+
+  // Seeded scene data, regenerated for every benchmark
+  uint64_t seed, rng;
+  vec2s* positions;
+  vec2s* sizes;
+  RnColor* colors;
+  // The points of the polylines (one more per polyline than segments)
+  vec2s* points;
+
+  // Random words of the text benchmarks
+  char* text;
+  char* paragraph;
+  char** rows;
+
+  RnStaticBatch* batch;
+  RnRecorder* recorders[BENCH_NUM_RECORDERS];
+  // The recorders of the threaded recording benchmarks 
+  // (one per thread) and the number of threads
+  RnRecorder* thread_recorders[BENCH_MAX_THREADS];
+  uint32_t n_threads;
+  // The name of an additional timing that 'setup' can enable 
+  // (NULL if there is none) and it's value in the last iteration, 
+  // which is reported by 'iter_teardown'
+  const char* aux_name;
+  double aux_ms;
+
+  // Whether the scroll views are clipped with scissor rectangles 
+  // instead of clips, and the stack of scissor rectangles
+  bool scissor;
+  vec4s scissors[4];
+  uint32_t n_scissors;
+
+  // The cached panels and the number of rendered frames, 
+  // which selects the panel that changes every frame
+  RnLayer* layers[BENCH_NUM_LAYER_PANELS];
+  uint32_t frame;
+
+  // The gradients of the gradient benchmark
+  uint32_t paints[BENCH_NUM_PAINTS];
+
+  // The client surfaces of the texture update benchmarks and 
+  // the mapped memfd that holds their pixels (like a wl_shm pool)
+  RnTexture surfaces[BENCH_NUM_SURFACES];
+  uint8_t* shm;
+  size_t shm_size;
+};
+
+static uint64_t
+rng_next(RnBench* b) {
+  // xorshift64*
+  b->rng ^= b->rng >> 12;
+  b->rng ^= b->rng << 25;
+  b->rng ^= b->rng >> 27;
+  return b->rng * 0x2545F4914F6CDD1DULL;
+}
+
+static float
+rng_float(RnBench* b, float min, float max) {
+  return min + (float)(rng_next(b) >> 40) / (float)(1 << 24) * (max - min);
+}
+
+static double
+time_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static char*
+random_words(RnBench* b, uint32_t n_words, uint32_t line_words) {
+  char* text = malloc(n_words * 10 + 1);
+  if(!text) {
+    fprintf(stderr, "runara-bench: failed to allocate text.\n");
+    exit(EXIT_FAILURE);
+  }
+  uint32_t len = 0;
+  for(uint32_t i = 0; i < n_words; i++) {
+    uint32_t word_len = 2 + rng_next(b) % 8;
+    for(uint32_t j = 0; j < word_len; j++) {
+      text[len++] = 'a' + rng_next(b) % 26;
+    }
+    text[len++] = (line_words && (i + 1) % line_words == 0) ? '\n' : ' ';
+  }
+  text[len - 1] = '\0';
+  return text;
+}
+
+static uint32_t
+count_glyphs(const char* text) {
+  uint32_t n = 0;
+  for(const char* c = text; *c; c++) {
+    // Count UTF-8 lead bytes that are not whitespace
+    if(*c != ' ' && *c != '\n' && (*c & 0xC0) != 0x80) n++;
+  }
+  return n;
+}
+
+// All printable codepoints of ASCII & Latin-1
+static char*
+charset_text(void) {
+  char* text = malloc(512);
+  if(!text) {
+    fprintf(stderr, "runara-bench: failed to allocate text.\n");
+    exit(EXIT_FAILURE);
+  }
+  uint32_t len = 0;
+  for(uint32_t cp = 0x21; cp <= 0xFF; cp++) {
+    if(cp >= 0x7F && cp <= 0xA0) continue;
+    if(cp < 0x80) {
+      text[len++] = cp;
+    } else {
+      text[len++] = 0xC0 | (cp >> 6);
+      text[len++] = 0x80 | (cp & 0x3F);
+    }
+    if(len % 64 == 0) text[len++] = '\n';
+  }
+  text[len] = '\0';
+  return text;
+}
+
+static void
+gen_n_rects(RnBench* b, uint32_t n) {
+  b->positions = malloc(sizeof(*b->positions) * n);
+  b->sizes = malloc(sizeof(*b->sizes) * n);
+  b->colors = malloc(sizeof(*b->colors) * n);
+  if(!b->positions || !b->sizes || !b->colors) {
+    fprintf(stderr, "runara-bench: failed to allocate scene.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < n; i++) {
+    b->sizes[i] = (vec2s){rng_float(b, 4, 64), rng_float(b, 4, 64)};
+    b->positions[i] = (vec2s){
+      rng_float(b, 0, BENCH_WIDTH - b->sizes[i].x),
+      rng_float(b, 0, BENCH_HEIGHT - b->sizes[i].y)};
+    uint64_t c = rng_next(b);
+    b->colors[i] = (RnColor){c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, 128 + ((c >> 24) & 0x7F)};
+  }
+}
+
+static void
+gen_rects(RnBench* b) {
+  gen_n_rects(b, BENCH_NUM_RECTS);
+}
+
+static void
+free_rects(RnBench* b) {
+  free(b->positions);
+  free(b->sizes);
+  free(b->colors);
+  b->positions = NULL;
+  b->sizes = NULL;
+  b->colors = NULL;
+}
+
+static void
+free_text(RnBench* b) {
+  free(b->text);
+  b->text = NULL;
+}
+
+static uint32_t
+render_rects(RnBench* b, float border_width, float corner_radius) {
+  for(uint32_t i = 0; i < BENCH_NUM_RECTS; i++) {
+    rn_rect_render_ex(b->state, b->positions[i], b->sizes[i], 0.0f,
+                      b->colors[i], RN_WHITE, border_width, corner_radius);
+  }
+  return BENCH_NUM_RECTS;
+}
+
+// ==== Plain & rounded rectangles ====
+static uint32_t
+run_rects(RnBench* b) {
+  rn_begin(b->state);
+  uint32_t n = render_rects(b, 0.0f, 0.0f);
+  rn_end(b->state);
+  return n;
+}
+
+static uint32_t
+run_rounded_rects(RnBench* b) {
+  rn_begin(b->state);
+  uint32_t n = render_rects(b, 1.0f, 4.0f);
+  rn_end(b->state);
+  return n;
+}
+
+// A rounded rect made of plain quads, as it had to be drawn before 
+// rects had corner radii: three bands plus a strip per row of 
+// every corner that approximates the quarter circle
+static void
+render_quad_rounded_rect(RnBench* b, vec2s pos, vec2s size, float radius, RnColor color) {
+  float r = floorf(fminf(radius, fminf(size.x, size.y) / 2.0f));
+  rn_rect_render(b->state, (vec2s){pos.x, pos.y + r}, (vec2s){size.x, size.y - 2 * r}, color);
+  rn_rect_render(b->state, (vec2s){pos.x + r, pos.y}, (vec2s){size.x - 2 * r, r}, color);
+  rn_rect_render(b->state, (vec2s){pos.x + r, pos.y + size.y - r}, (vec2s){size.x - 2 * r, r}, color);
+  for(float row = 0.0f; row < r; row++) {
+    float dy = r - row - 0.5f;
+    float dx = r - sqrtf(r * r - dy * dy);
+    vec2s strip = {r - dx, 1.0f};
+    float top = pos.y + row, bottom = pos.y + size.y - row - 1.0f;
+    rn_rect_render(b->state, (vec2s){pos.x + dx, top}, strip, color);
+    rn_rect_render(b->state, (vec2s){pos.x + size.x - r, top}, strip, color);
+    rn_rect_render(b->state, (vec2s){pos.x + dx, bottom}, strip, color);
+    rn_rect_render(b->state, (vec2s){pos.x + size.x - r, bottom}, strip, color);
+  }
+}
+
+static uint32_t
+run_rounded_rects_quads(RnBench* b) {
+  // The same rects as 'rounded_rects', the border is an 
+  // extra pass below the fill
+  const float border_width = 1.0f, corner_radius = 4.0f;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_RECTS; i++) {
+    vec2s pos = b->positions[i], size = b->sizes[i];
+    render_quad_rounded_rect(b, pos, size, corner_radius, RN_WHITE);
+    render_quad_rounded_rect(b, (vec2s){pos.x + border_width, pos.y + border_width},
+                             (vec2s){size.x - 2 * border_width, size.y - 2 * border_width}, 
+                             corner_radius - border_width, b->colors[i]);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+static void
+setup_gradient_rects(RnBench* b) {
+  gen_rects(b);
+  for(uint32_t i = 0; i < BENCH_NUM_PAINTS; i++) {
+    RnGradientStop stops[3];
+    for(uint32_t j = 0; j < 3; j++) {
+      uint64_t c = rng_next(b);
+      stops[j] = (RnGradientStop){{c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, 255}, j * 0.5f};
+    }
+    b->paints[i] = i % 2 ? 
+      rn_paint_create_radial(b->state, (vec2s){0.5f, 0.5f}, (vec2s){0.5f, 0.5f}, stops, 3) :
+      rn_paint_create_linear(b->state, (vec2s){0.0f, 0.0f}, (vec2s){1.0f, 1.0f}, stops, 3);
+  }
+}
+
+static void
+teardown_gradient_rects(RnBench* b) {
+  for(uint32_t i = 0; i < BENCH_NUM_PAINTS; i++) {
+    rn_paint_free(b->state, b->paints[i]);
+  }
+  free_rects(b);
+}
+
+static uint32_t
+run_gradient_rects(RnBench* b) {
+  // Every other rect is filled with a gradient, 
+  // all of them are drawn with a single batch
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_RECTS; i++) {
+    if(i % 2) {
+      rn_rect_render_paint(b->state, b->positions[i], b->sizes[i], 0.0f, 
+                           b->paints[i / 2 % BENCH_NUM_PAINTS], RN_NO_COLOR, 0.0f, 0.0f);
+    } else {
+      rn_rect_render(b->state, b->positions[i], b->sizes[i], b->colors[i]);
+    }
+  }
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+// ==== Instance upload paths ====
+// Renders with a state of it's own that streams instances through 
+// the persistently mapped ring or uploads them with glBufferSubData, 
+// so that both paths are measured in the same run
+static void
+setup_upload_path(RnBench* b, bool streaming) {
+  gen_n_rects(b, BENCH_NUM_STREAM_RECTS);
+  RnInitConfig config = b->config;
+  config.disable_streaming = !streaming;
+  b->main_state = b->state;
+  b->state = rn_init_ex(BENCH_WIDTH, BENCH_HEIGHT, NULL, config);
+}
+
+static void
+setup_rects_streamed(RnBench* b) {
+  setup_upload_path(b, true);
+}
+
+static void
+setup_rects_buffered(RnBench* b) {
+  setup_upload_path(b, false);
+}
+
+static void
+teardown_upload_path(RnBench* b) {
+  rn_terminate(b->state);
+  b->state = b->main_state;
+  b->main_state = NULL;
+  free_rects(b);
+}
+
+static uint32_t
+run_upload_path(RnBench* b) {
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_STREAM_RECTS; i++) {
+    rn_rect_render(b->state, b->positions[i], b->sizes[i], b->colors[i]);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_STREAM_RECTS;
+}
+
+// Full-screen rectangles, bound by fill rate
+static uint32_t
+run_fill_rects(RnBench* b) {
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_FILL_RECTS; i++) {
+    rn_rect_render(b->state, (vec2s){0, 0}, (vec2s){BENCH_WIDTH, BENCH_HEIGHT}, 
+                   (RnColor){i * 10, 80, 160, 32});
+  }
+  rn_end(b->state);
+  return BENCH_NUM_FILL_RECTS;
+}
+
+// ==== Textured rectangles ====
+static uint32_t
+run_textured_rects(RnBench* b) {
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_RECTS; i++) {
+    RnTexture tex = b->textures[i % BENCH_NUM_TEXTURES];
+    tex.width = b->sizes[i].x;
+    tex.height = b->sizes[i].y;
+    rn_image_render(b->state, b->positions[i], RN_WHITE, tex);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+// ==== Glyphs ====
+static void
+setup_cached_glyphs(RnBench* b) {
+  b->text = random_words(b, 2000, 16);
+  // Warm the glyph & shaping caches
+  rn_text_render_ex(b->state, b->text, b->font, (vec2s){0, 0}, RN_WHITE, 0.0f, false);
+}
+
+static uint32_t
+run_cached_glyphs(RnBench* b) {
+  rn_begin(b->state);
+  rn_text_render_ex(b->state, b->text, b->font, (vec2s){0, 16}, RN_WHITE, 0.0f, true);
+  rn_end(b->state);
+  return count_glyphs(b->text);
+}
+
+static void
+setup_charset(RnBench* b) {
+  b->text = charset_text();
+}
+
+static void
+iter_setup_uncached_glyphs(RnBench* b) {
+  b->iter_font = rn_load_font(b->state, b->font_path, 24);
+}
+
+static void
+iter_setup_atlas_growth(RnBench* b) {
+  // Start with a tiny atlas so rendering the charset
+  // has to grow it several times
+  b->iter_font = rn_load_font_ex(b->state, b->font_path, 48,
+                                 128, 128, 4, RN_TEX_FILTER_LINEAR, 0);
+}
+
+static void
+iter_teardown_font(RnBench* b) {
+  rn_free_font(b->state, b->iter_font);
+  b->iter_font = NULL;
+}
+
+static uint32_t
+run_charset(RnBench* b) {
+  rn_begin(b->state);
+  rn_text_render_ex(b->state, b->text, b->iter_font, (vec2s){0, 48}, RN_WHITE, 0.0f, true);
+  rn_end(b->state);
+  return count_glyphs(b->text);
+}
+
+// Fills the glyph cache with (at least) 'n' glyphs, loading 
+// all glyphs of copies of the font until there are enough
+static void
+setup_glyph_lookup(RnBench* b, uint32_t n) {
+  uint32_t per_font[BENCH_MAX_LOOKUP_FONTS];
+  uint32_t filled = 0;
+  b->n_lookup_fonts = 0;
+  while(filled < n && b->n_lookup_fonts < BENCH_MAX_LOOKUP_FONTS) {
+    // Tiny glyphs on a small atlas keep rasterizing them cheap
+    RnFont* font = rn_load_font_ex(b->state, b->font_path, 2, 128, 128, 4, 
+                                   RN_TEX_FILTER_LINEAR, 0);
+    uint32_t count = (uint32_t)font->face->num_glyphs;
+    if(count > n - filled) count = n - filled;
+    for(uint32_t i = 0; i < count; i++) {
+      rn_glyph_from_codepoint(b->state, font, i);
+    }
+    per_font[b->n_lookup_fonts] = count;
+    b->lookup_fonts[b->n_lookup_fonts++] = font;
+    filled += count;
+  }
+
+  b->lookups = malloc(sizeof(*b->lookups) * BENCH_NUM_GLYPH_LOOKUPS);
+  if(!b->lookups) {
+    fprintf(stderr, "runara-bench: failed to allocate lookups.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_GLYPH_LOOKUPS; i++) {
+    uint32_t glyph = (uint32_t)(rng_next(b) % filled), font = 0;
+    while(glyph >= per_font[font]) {
+      glyph -= per_font[font++];
+    }
+    b->lookups[i] = font << 24 | glyph;
+  }
+}
+
+static void
+setup_glyph_lookup_100(RnBench* b) {
+  setup_glyph_lookup(b, 100);
+}
+
+static void
+setup_glyph_lookup_1k(RnBench* b) {
+  setup_glyph_lookup(b, 1000);
+}
+
+static void
+setup_glyph_lookup_10k(RnBench* b) {
+  setup_glyph_lookup(b, 10000);
+}
+
+static void
+setup_glyph_lookup_100k(RnBench* b) {
+  setup_glyph_lookup(b, 100000);
+}
+
+static void
+teardown_glyph_lookup(RnBench* b) {
+  for(uint32_t i = 0; i < b->n_lookup_fonts; i++) {
+    rn_free_font(b->state, b->lookup_fonts[i]);
+    b->lookup_fonts[i] = NULL;
+  }
+  b->n_lookup_fonts = 0;
+  free(b->lookups);
+  b->lookups = NULL;
+}
+
+static uint32_t
+run_glyph_lookup(RnBench* b) {
+  // Random lookups of cached glyphs, the time per lookup 
+  // should not depend on the number of cached glyphs
+  uint32_t sum = 0;
+  for(uint32_t i = 0; i < BENCH_NUM_GLYPH_LOOKUPS; i++) {
+    uint32_t key = b->lookups[i];
+    RnGlyph glyph = rn_glyph_from_codepoint(b->state, b->lookup_fonts[key >> 24], key & 0xFFFFFF);
+    sum += glyph.width;
+  }
+  // Keep the lookups from being optimized out
+  volatile uint32_t sink = sum;
+  (void)sink;
+  return BENCH_NUM_GLYPH_LOOKUPS;
+}
+
+// ==== Paragraph layout ====
+static void
+setup_paragraph(RnBench* b) {
+  b->paragraph = random_words(b, 1500, 0);
+  // Layout only, shaping is measured by the glyph benchmarks
+  rn_text_render_paragraph_ex(b->state, b->paragraph, b->font, (vec2s){0, 0}, RN_WHITE,
+                              (RnParagraphProps){.align = RN_PARAGRAPH_ALIGNMENT_LEFT, .wrap = 800},
+                              false);
+}
+
+static uint32_t
+run_paragraph(RnBench* b) {
+  RnParagraphProps props = (RnParagraphProps){
+    .align = RN_PARAGRAPH_ALIGNMENT_CENTER, .wrap = 800};
+  rn_text_render_paragraph_ex(b->state, b->paragraph, b->font,
+                              (vec2s){0, 0}, RN_WHITE, props, false);
+  return strlen(b->paragraph);
+}
+
+static void
+teardown_paragraph(RnBench* b) {
+  free(b->paragraph);
+  b->paragraph = NULL;
+}
+
+// ==== Font loading ====
+static uint32_t
+run_font_load(RnBench* b) {
+  b->iter_font = rn_load_font(b->state, b->font_path, 24);
+  return 1;
+}
+
+// ==== Static batch ====
+static void
+setup_static_batch(RnBench* b) {
+  gen_rects(b);
+  b->batch = rn_batch_create();
+  rn_begin(b->state);
+  rn_batch_record_begin(b->state, b->batch);
+  render_rects(b, 1.0f, 4.0f);
+  rn_batch_record_end(b->state, b->batch);
+  rn_end(b->state);
+}
+
+static uint32_t
+run_static_batch(RnBench* b) {
+  rn_begin(b->state);
+  rn_batch_draw(b->state, b->batch, (vec2s){0, 0});
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+static void
+teardown_static_batch(RnBench* b) {
+  rn_batch_free(b->batch);
+  b->batch = NULL;
+  free_rects(b);
+}
+
+// ==== Culled list ====
+static void
+setup_list(RnBench* b) {
+  b->rows = malloc(sizeof(*b->rows) * BENCH_NUM_ROWS);
+  if(!b->rows) {
+    fprintf(stderr, "runara-bench: failed to allocate rows.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_ROWS; i++) {
+    b->rows[i] = random_words(b, 1 + rng_next(b) % 4, 0);
+  }
+}
+
+static uint32_t
+run_list(RnBench* b) {
+  const float row_h = 24.0f;
+  // Scroll to the middle of the list
+  float scroll = -row_h * (BENCH_NUM_ROWS / 2);
+  rn_begin(b->state);
+  rn_set_cull_start_y(b->state, 0);
+  rn_set_cull_end_y(b->state, BENCH_HEIGHT);
+  for(uint32_t i = 0; i < BENCH_NUM_ROWS; i++) {
+    float y = scroll + i * row_h;
+    rn_rect_render(b->state, (vec2s){0, y}, (vec2s){BENCH_WIDTH, row_h - 2},
+                   (RnColor){30, 30, 30, 255});
+    rn_text_render(b->state, b->rows[i], b->font, (vec2s){8, y + 4}, RN_WHITE);
+  }
+  rn_unset_cull_start_y(b->state);
+  rn_unset_cull_end_y(b->state);
+  rn_end(b->state);
+  return BENCH_NUM_ROWS;
+}
+
+static void
+teardown_list(RnBench* b) {
+  for(uint32_t i = 0; i < BENCH_NUM_ROWS; i++) {
+    free(b->rows[i]);
+  }
+  free(b->rows);
+  b->rows = NULL;
+}
+
+// ==== Nested scroll views ====
+static void
+setup_scroll_views_scissor(RnBench* b) {
+  setup_list(b);
+  b->scissor = true;
+}
+
+static void
+teardown_scroll_views(RnBench* b) {
+  b->scissor = false;
+  teardown_list(b);
+}
+
+// Clips to a rounded rect, or to the intersection of the scissor 
+// rectangles, which has to end the batch before and after
+static void
+scroll_clip_push(RnBench* b, vec2s pos, vec2s size, float radius) {
+  if(!b->scissor) {
+    rn_push_clip(b->state, pos, size, radius);
+    return;
+  }
+  vec4s r = {pos.x, pos.y, pos.x + size.x, pos.y + size.y};
+  if(b->n_scissors) {
+    vec4s p = b->scissors[b->n_scissors - 1];
+    r = (vec4s){fmaxf(r.x, p.x), fmaxf(r.y, p.y), fminf(r.z, p.z), fminf(r.w, p.w)};
+  }
+  b->scissors[b->n_scissors++] = r;
+  rn_next_batch(b->state);
+  rn_begin_scissor((vec2s){r.x, r.y}, (vec2s){r.z - r.x, r.w - r.y}, BENCH_HEIGHT);
+}
+
+static void
+scroll_clip_pop(RnBench* b) {
+  if(!b->scissor) {
+    rn_pop_clip(b->state);
+    return;
+  }
+  rn_next_batch(b->state);
+  if(--b->n_scissors) {
+    vec4s r = b->scissors[b->n_scissors - 1];
+    rn_begin_scissor((vec2s){r.x, r.y}, (vec2s){r.z - r.x, r.w - r.y}, BENCH_HEIGHT);
+  } else {
+    rn_end_scissor();
+  }
+}
+
+static uint32_t
+scroll_view_rows(RnBench* b, vec2s pos, vec2s size, uint32_t first, float scroll) {
+  const float row_h = 22.0f;
+  for(uint32_t i = 0; i < BENCH_PANEL_ROWS; i++) {
+    float y = pos.y + i * row_h - scroll;
+    rn_rect_render_ex(b->state, (vec2s){pos.x + 4, y}, (vec2s){size.x - 8, row_h - 2}, 0.0f,
+                      (RnColor){40, 40, 48, 255}, RN_NO_COLOR, 0.0f, 4.0f);
+    rn_text_render(b->state, b->rows[first + i], b->font, (vec2s){pos.x + 10, y + 15}, RN_WHITE);
+  }
+  return BENCH_PANEL_ROWS;
+}
+
+static uint32_t
+run_scroll_views(RnBench* b) {
+  // Rounded windows, each with a scroll view that 
+  // contains another scroll view
+  const vec2s panel = {300, 220};
+  uint32_t rows = 0;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_PANELS; i++) {
+    vec2s pos = {16 + (i % 4) * (panel.x + 16), 16 + (i / 4) * (panel.y + 16)};
+    scroll_clip_push(b, pos, panel, 12.0f);
+    rn_rect_render(b->state, pos, panel, (RnColor){24, 24, 28, 255});
+    rn_text_render(b->state, "Scroll view", b->font, (vec2s){pos.x + 10, pos.y + 18}, RN_WHITE);
+
+    vec2s list = {pos.x, pos.y + 28}, list_size = {panel.x, panel.y - 28};
+    scroll_clip_push(b, list, list_size, 0.0f);
+    rows += scroll_view_rows(b, list, list_size, i * 2 * BENCH_PANEL_ROWS, 13.0f * i);
+
+    vec2s inner = {list.x + 40, list.y + 60}, inner_size = {list_size.x - 80, 90};
+    scroll_clip_push(b, inner, inner_size, 8.0f);
+    rn_rect_render(b->state, inner, inner_size, (RnColor){10, 10, 12, 255});
+    rows += scroll_view_rows(b, inner, inner_size, (i * 2 + 1) * BENCH_PANEL_ROWS, 7.0f * i);
+    scroll_clip_pop(b);
+
+    scroll_clip_pop(b);
+    scroll_clip_pop(b);
+  }
+  rn_end(b->state);
+  return rows;
+}
+
+// ==== Cached layers ====
+static void
+setup_layers(RnBench* b) {
+  setup_list(b);
+  for(uint32_t i = 0; i < BENCH_NUM_LAYER_PANELS; i++) {
+    b->layers[i] = rn_layer_create();
+  }
+  b->frame = 0;
+}
+
+static void
+teardown_layers(RnBench* b) {
+  for(uint32_t i = 0; i < BENCH_NUM_LAYER_PANELS; i++) {
+    rn_layer_free(b->state, b->layers[i]);
+    b->layers[i] = NULL;
+  }
+  teardown_list(b);
+}
+
+// A panel with a title and rows of text, like 
+// the notifications or docks of a compositor
+static void
+render_panel(RnBench* b, vec2s pos, vec2s size, uint32_t i) {
+  const float row_h = 22.0f;
+  rn_rect_render_ex(b->state, pos, size, 0.0f, (RnColor){24, 24, 28, 255}, 
+                    RN_NO_COLOR, 0.0f, 12.0f);
+  rn_text_render(b->state, "Panel", b->font, (vec2s){pos.x + 10, pos.y + 18}, RN_WHITE);
+  uint32_t rows = (uint32_t)((size.y - 36) / row_h);
+  for(uint32_t r = 0; r < rows; r++) {
+    float y = pos.y + 30 + r * row_h;
+    rn_rect_render_ex(b->state, (vec2s){pos.x + 4, y}, (vec2s){size.x - 8, row_h - 2}, 0.0f,
+                      (RnColor){40, 40, 48, 255}, RN_NO_COLOR, 0.0f, 4.0f);
+    rn_text_render(b->state, b->rows[i * rows + r], b->font, (vec2s){pos.x + 10, y + 15}, RN_WHITE);
+  }
+}
+
+static vec2s
+panel_pos(uint32_t i, vec2s size) {
+  return (vec2s){8 + (i % 4) * (size.x + 8), 8 + (i / 4) * (size.y + 8)};
+}
+
+static uint32_t
+run_panels(RnBench* b) {
+  const vec2s size = {308, 168};
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_LAYER_PANELS; i++) {
+    render_panel(b, panel_pos(i, size), size, i);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_LAYER_PANELS;
+}
+
+static uint32_t
+run_panels_layers(RnBench* b) {
+  // The panels are rendered into layers once and one 
+  // of them changes every frame, the others are composited
+  const vec2s size = {308, 168};
+  rn_layer_mark_dirty(b->layers[b->frame++ % BENCH_NUM_LAYER_PANELS]);
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_LAYER_PANELS; i++) {
+    RnLayer* layer = b->layers[i];
+    if(layer->dirty) {
+      rn_begin_layer(b->state, layer, size.x, size.y);
+      render_panel(b, (vec2s){0, 0}, size, i);
+      rn_end_layer(b->state, layer);
+    }
+    rn_layer_render(b->state, layer, panel_pos(i, size), RN_WHITE);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_LAYER_PANELS;
+}
+
+// ==== Lines ====
+static void
+setup_lines(RnBench* b) {
+  // Graphs across the whole width, each a random walk
+  const uint32_t per_line = BENCH_NUM_SEGMENTS / BENCH_NUM_POLYLINES + 1;
+  b->points = malloc(sizeof(*b->points) * per_line * BENCH_NUM_POLYLINES);
+  if(!b->points) {
+    fprintf(stderr, "runara-bench: failed to allocate points.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_POLYLINES; i++) {
+    float y = rng_float(b, 0, BENCH_HEIGHT);
+    for(uint32_t j = 0; j < per_line; j++) {
+      y = fminf(fmaxf(y + rng_float(b, -4, 4), 0), BENCH_HEIGHT);
+      b->points[i * per_line + j] = (vec2s){(float)j * BENCH_WIDTH / (per_line - 1), y};
+    }
+  }
+}
+
+static void
+teardown_lines(RnBench* b) {
+  free(b->points);
+  b->points = NULL;
+}
+
+static uint32_t
+run_lines(RnBench* b) {
+  const uint32_t per_line = BENCH_NUM_SEGMENTS / BENCH_NUM_POLYLINES + 1;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_POLYLINES; i++) {
+    RnColor color = {(uint8_t)(i * 37), (uint8_t)(i * 91), 200, 255};
+    rn_polyline_render(b->state, &b->points[i * per_line], per_line, 1.5f, color);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_SEGMENTS;
+}
+
+// ==== Shapes ====
+static void
+setup_spinners(RnBench* b) {
+  // The centers and radii (in 'sizes') of the spinners
+  b->positions = malloc(sizeof(*b->positions) * BENCH_NUM_SPINNERS);
+  b->sizes = malloc(sizeof(*b->sizes) * BENCH_NUM_SPINNERS);
+  b->colors = malloc(sizeof(*b->colors) * BENCH_NUM_SPINNERS);
+  if(!b->positions || !b->sizes || !b->colors) {
+    fprintf(stderr, "runara-bench: failed to allocate scene.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_SPINNERS; i++) {
+    float radius = rng_float(b, 4, 12);
+    b->sizes[i] = (vec2s){radius, rng_float(b, 0, 6.28f)};
+    b->positions[i] = (vec2s){
+      rng_float(b, radius, BENCH_WIDTH - radius),
+      rng_float(b, radius, BENCH_HEIGHT - radius)};
+    uint64_t c = rng_next(b);
+    b->colors[i] = (RnColor){c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, 255};
+  }
+  b->frame = 0;
+}
+
+static uint32_t
+run_spinners(RnBench* b) {
+  // Every spinner is a single arc instance that 
+  // rotates and changes it's sweep every frame
+  float t = (float)b->frame++ * 0.1f;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_SPINNERS; i++) {
+    float radius = b->sizes[i].x, phase = b->sizes[i].y;
+    rn_arc_render_ex(b->state, b->positions[i], radius, radius * 0.3f, 
+                     phase + t * 2.0f, 3.0f + 1.5f * sinf(phase + t), 
+                     b->colors[i], RN_LINE_CAP_ROUND);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_SPINNERS;
+}
+
+static void
+setup_windows(RnBench* b) {
+  b->positions = malloc(sizeof(*b->positions) * BENCH_NUM_WINDOWS);
+  b->sizes = malloc(sizeof(*b->sizes) * BENCH_NUM_WINDOWS);
+  b->colors = malloc(sizeof(*b->colors) * BENCH_NUM_WINDOWS);
+  if(!b->positions || !b->sizes || !b->colors) {
+    fprintf(stderr, "runara-bench: failed to allocate scene.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_WINDOWS; i++) {
+    b->sizes[i] = (vec2s){rng_float(b, 160, 480), rng_float(b, 120, 360)};
+    b->positions[i] = (vec2s){
+      rng_float(b, 0, BENCH_WIDTH - b->sizes[i].x),
+      rng_float(b, 0, BENCH_HEIGHT - b->sizes[i].y)};
+    uint64_t c = rng_next(b);
+    b->colors[i] = (RnColor){180 + (c & 0x3F), 180 + ((c >> 8) & 0x3F), 180 + ((c >> 16) & 0x3F), 255};
+  }
+}
+
+static uint32_t
+run_windows(RnBench* b) {
+  // Overlapping windows with a drop shadow and 
+  // a title bar, back to front
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_WINDOWS; i++) {
+    vec2s pos = b->positions[i], size = b->sizes[i];
+    rn_box_shadow_render(b->state, (vec2s){pos.x, pos.y + 8}, size, 8.0f, 
+                         32.0f, 0.0f, (RnColor){0, 0, 0, 96});
+    rn_rect_render_ex(b->state, pos, size, 0.0f, b->colors[i], RN_NO_COLOR, 0.0f, 8.0f);
+    rn_rect_render(b->state, (vec2s){pos.x + 8, pos.y + 8}, 
+                   (vec2s){size.x - 16, 24}, (RnColor){60, 60, 70, 255});
+  }
+  rn_end(b->state);
+  return BENCH_NUM_WINDOWS;
+}
+
+// ==== Background blur ====
+static uint32_t
+render_blur(RnBench* b, float radius) {
+  // Frosted panels above the windows, every panel 
+  // flushes the content behind it before it blurs
+  const vec2s size = {320, 240};
+  uint32_t pixels = 0;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_WINDOWS; i++) {
+    rn_rect_render(b->state, b->positions[i], b->sizes[i], b->colors[i]);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_BLUR_PANELS; i++) {
+    vec2s pos = {
+      (i % 4) * (BENCH_WIDTH - size.x) / 3.0f, 
+      (i / 4) * (BENCH_HEIGHT - size.y)};
+    rn_background_blur_render(b->state, pos, size, radius, 12.0f, (RnColor){255, 255, 255, 200});
+    pixels += size.x * size.y;
+  }
+  rn_end(b->state);
+  // Pixels, so that the throughput is the blurred area per second
+  return pixels;
+}
+
+static uint32_t
+run_blur_r4(RnBench* b) {
+  return render_blur(b, 4.0f);
+}
+
+static uint32_t
+run_blur_r16(RnBench* b) {
+  return render_blur(b, 16.0f);
+}
+
+static uint32_t
+run_blur_r64(RnBench* b) {
+  return render_blur(b, 64.0f);
+}
+
+// ==== Texture updates ====
+static void
+setup_surfaces(RnBench* b) {
+  const size_t surface_size = (size_t)BENCH_SURFACE_WIDTH * BENCH_SURFACE_HEIGHT * 4;
+  b->shm_size = surface_size * BENCH_NUM_SURFACES;
+  int fd = memfd_create("runara-bench", 0);
+  if(fd < 0 || ftruncate(fd, (off_t)b->shm_size) != 0) {
+    fprintf(stderr, "runara-bench: failed to create shared memory.\n");
+    exit(EXIT_FAILURE);
+  }
+  b->shm = mmap(NULL, b->shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(b->shm == MAP_FAILED) {
+    fprintf(stderr, "runara-bench: failed to map shared memory.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(size_t i = 0; i < b->shm_size; i += 8) {
+    uint64_t v = rng_next(b);
+    memcpy(&b->shm[i], &v, sizeof(v));
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_SURFACES; i++) {
+    b->surfaces[i] = rn_texture_create(BENCH_SURFACE_WIDTH, BENCH_SURFACE_HEIGHT, 
+                                       RN_TEX_FORMAT_BGRX8);
+  }
+
+  // The damaged rects, 'positions' are their top-left corners
+  b->positions = malloc(sizeof(*b->positions) * BENCH_NUM_DAMAGE_RECTS);
+  b->sizes = malloc(sizeof(*b->sizes) * BENCH_NUM_DAMAGE_RECTS);
+  if(!b->positions || !b->sizes) {
+    fprintf(stderr, "runara-bench: failed to allocate scene.\n");
+    exit(EXIT_FAILURE);
+  }
+  for(uint32_t i = 0; i < BENCH_NUM_DAMAGE_RECTS; i++) {
+    b->sizes[i] = (vec2s){floorf(rng_float(b, 16, 320)), floorf(rng_float(b, 16, 240))};
+    b->positions[i] = (vec2s){
+      floorf(rng_float(b, 0, BENCH_SURFACE_WIDTH - b->sizes[i].x)),
+      floorf(rng_float(b, 0, BENCH_SURFACE_HEIGHT - b->sizes[i].y))};
+  }
+}
+
+static void
+teardown_surfaces(RnBench* b) {
+  for(uint32_t i = 0; i < BENCH_NUM_SURFACES; i++) {
+    rn_texture_free(b->state, &b->surfaces[i]);
+  }
+  munmap(b->shm, b->shm_size);
+  b->shm = NULL;
+  b->shm_size = 0;
+  free_rects(b);
+}
+
+static uint32_t
+render_surfaces(RnBench* b, bool damage) {
+  // Every client commits a new buffer, either with damaged rects 
+  // or entirely, then the compositor draws all surfaces
+  const uint32_t stride = BENCH_SURFACE_WIDTH * 4;
+  uint32_t bytes = 0;
+  for(uint32_t i = 0; i < BENCH_NUM_SURFACES; i++) {
+    const uint8_t* pixels = b->shm + (size_t)i * stride * BENCH_SURFACE_HEIGHT;
+    if(!damage) {
+      rn_texture_update_region(b->state, b->surfaces[i], (RnTextureRect){
+                               0, 0, BENCH_SURFACE_WIDTH, BENCH_SURFACE_HEIGHT}, pixels, stride);
+      bytes += stride * BENCH_SURFACE_HEIGHT;
+      continue;
+    }
+    for(uint32_t j = i; j < BENCH_NUM_DAMAGE_RECTS; j += BENCH_NUM_SURFACES) {
+      RnTextureRect rect = {(uint32_t)b->positions[j].x, (uint32_t)b->positions[j].y, 
+                            (uint32_t)b->sizes[j].x, (uint32_t)b->sizes[j].y};
+      rn_texture_update_region(b->state, b->surfaces[i], rect, pixels, stride);
+      bytes += rect.width * rect.height * 4;
+    }
+  }
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_SURFACES; i++) {
+    rn_image_render(b->state, (vec2s){i * 32.0f, i * 24.0f}, RN_WHITE, b->surfaces[i]);
+  }
+  rn_end(b->state);
+  // Bytes, so that the throughput is the upload bandwidth
+  return bytes;
+}
+
+static uint32_t
+run_surface_damage(RnBench* b) {
+  return render_surfaces(b, true);
+}
+
+static uint32_t
+run_surface_full(RnBench* b) {
+  return render_surfaces(b, false);
+}
+
+// ==== Reordering ====
+static void
+setup_reorder(RnBench* b) {
+  gen_rects(b);
+  b->text = random_words(b, 1, 0);
+  rn_set_reorder(b->state, true);
+}
+
+static uint32_t
+run_reorder(RnBench* b) {
+  // Interleaves images of many textures with text,
+  // which needs a flush per texture set unreordered
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_RECTS; i++) {
+    RnTexture tex = b->textures[i % BENCH_NUM_TEXTURES];
+    tex.width = b->sizes[i].x;
+    tex.height = b->sizes[i].y;
+    rn_image_render(b->state, b->positions[i], RN_WHITE, tex);
+    if(i % 64 == 0) {
+      rn_text_render(b->state, b->text, b->font, b->positions[i], RN_WHITE);
+    }
+  }
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+static void
+teardown_reorder(RnBench* b) {
+  rn_set_reorder(b->state, false);
+  free_text(b);
+  free_rects(b);
+}
+
+// ==== Multi-draw ====
+static void
+setup_multi_draw(RnBench* b) {
+  gen_rects(b);
+  rn_set_multi_draw(b->state, true);
+}
+
+static uint32_t
+run_multi_draw(RnBench* b) {
+  const uint32_t per_batch = BENCH_NUM_RECTS / BENCH_NUM_BATCHES;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_RECTS; i++) {
+    if(i % 8 == 0) {
+      RnTexture tex = b->textures[(i / per_batch) % BENCH_NUM_TEXTURES];
+      tex.width = b->sizes[i].x;
+      tex.height = b->sizes[i].y;
+      rn_image_render(b->state, b->positions[i], RN_WHITE, tex);
+    } else {
+      rn_rect_render(b->state, b->positions[i], b->sizes[i], b->colors[i]);
+    }
+    if((i + 1) % per_batch == 0) {
+      rn_next_batch(b->state);
+    }
+  }
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+static void
+teardown_multi_draw(RnBench* b) {
+  rn_set_multi_draw(b->state, false);
+  free_rects(b);
+}
+
+// ==== Recorders ====
+static void
+setup_recorders(RnBench* b) {
+  gen_rects(b);
+  for(uint32_t i = 0; i < BENCH_NUM_RECORDERS; i++) {
+    b->recorders[i] = rn_recorder_create(b->state);
+  }
+}
+
+static uint32_t
+run_recorders(RnBench* b) {
+  const uint32_t per_rec = BENCH_NUM_RECTS / BENCH_NUM_RECORDERS;
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_RECORDERS; i++) {
+    RnRecorder* rec = b->recorders[i];
+    rn_recorder_begin(rec);
+    for(uint32_t j = i * per_rec; j < (i + 1) * per_rec; j++) {
+      rn_recorder_rect_render_ex(rec, b->positions[j], b->sizes[j], 0.0f,
+                                 b->colors[j], RN_WHITE, 1.0f, 4.0f);
+    }
+    rn_submit_recorder(b->state, rec);
+  }
+  rn_end(b->state);
+  return BENCH_NUM_RECTS;
+}
+
+static void
+teardown_recorders(RnBench* b) {
+  for(uint32_t i = 0; i < BENCH_NUM_RECORDERS; i++) {
+    rn_recorder_free(b->recorders[i]);
+    b->recorders[i] = NULL;
+  }
+  free_rects(b);
+}
+
+// The share of the primitives that a thread records
+typedef struct {
+  RnBench* b;
+  RnRecorder* rec;
+  uint32_t first, last;
+} RnBenchThread;
+
+static void*
+record_thread(void* arg) {
+  // Rounded rects and every 64th primitive a cached text, 
+  // so that the glyph & shaping caches are read concurrently
+  RnBenchThread* t = arg;
+  RnBench* b = t->b;
+  rn_recorder_begin(t->rec);
+  for(uint32_t i = t->first; i < t->last; i++) {
+    if(i % 64 == 0) {
+      rn_recorder_text_render(t->rec, b->text, b->font, b->positions[i], RN_WHITE);
+    } else {
+      rn_recorder_rect_render_ex(t->rec, b->positions[i], b->sizes[i], 0.0f,
+                                 b->colors[i], RN_WHITE, 1.0f, 4.0f);
+    }
+  }
+  return NULL;
+}
+
+static void
+setup_threads(RnBench* b, uint32_t n_threads) {
+  gen_n_rects(b, BENCH_NUM_MT_PRIMITIVES);
+  b->text = random_words(b, 4, 0);
+  // Warm the glyph & shaping caches, recorders only read them
+  rn_text_render_ex(b->state, b->text, b->font, (vec2s){0, 0}, RN_WHITE, 0.0f, false);
+  b->n_threads = n_threads;
+  b->aux_name = "submit_ms";
+  for(uint32_t i = 0; i < n_threads; i++) {
+    b->thread_recorders[i] = rn_recorder_create(b->state);
+  }
+}
+
+static void
+setup_threads_1(RnBench* b) {
+  setup_threads(b, 1);
+}
+
+static void
+setup_threads_2(RnBench* b) {
+  setup_threads(b, 2);
+}
+
+static void
+setup_threads_4(RnBench* b) {
+  setup_threads(b, 4);
+}
+
+static void
+setup_threads_n(RnBench* b) {
+  // One thread per online CPU
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  setup_threads(b, n < 1 ? 1 : n > BENCH_MAX_THREADS ? BENCH_MAX_THREADS : (uint32_t)n);
+}
+
+static void
+teardown_threads(RnBench* b) {
+  for(uint32_t i = 0; i < b->n_threads; i++) {
+    rn_recorder_free(b->thread_recorders[i]);
+    b->thread_recorders[i] = NULL;
+  }
+  b->n_threads = 0;
+  free_text(b);
+  free_rects(b);
+}
+
+static void
+iter_setup_threads(RnBench* b) {
+  rn_begin(b->state);
+}
+
+static uint32_t
+run_threads(RnBench* b) {
+  // Only the recording is timed, the single-threaded 
+  // merge and draw are timed by 'iter_teardown_threads()'
+  RnBenchThread threads[BENCH_MAX_THREADS];
+  pthread_t ids[BENCH_MAX_THREADS];
+  const uint32_t per_thread = BENCH_NUM_MT_PRIMITIVES / b->n_threads;
+  for(uint32_t i = 0; i < b->n_threads; i++) {
+    threads[i] = (RnBenchThread){b, b->thread_recorders[i], i * per_thread, 
+      i + 1 == b->n_threads ? BENCH_NUM_MT_PRIMITIVES : (i + 1) * per_thread};
+    if(pthread_create(&ids[i], NULL, record_thread, &threads[i]) != 0) {
+      fprintf(stderr, "runara-bench: failed to create thread.\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  for(uint32_t i = 0; i < b->n_threads; i++) {
+    pthread_join(ids[i], NULL);
+  }
+  return BENCH_NUM_MT_PRIMITIVES;
+}
+
+static void
+iter_teardown_threads(RnBench* b) {
+  // The recorders are submitted in thread order
+  double start = time_ms();
+  for(uint32_t i = 0; i < b->n_threads; i++) {
+    rn_submit_recorder(b->state, b->thread_recorders[i]);
+  }
+  rn_end(b->state);
+  glFinish();
+  b->aux_ms = time_ms() - start;
+}
+
+// ==== Bindless textures ====
+// Loads the OpenGL entry points of extensions that glad does 
+// not load itself (bindless textures) through EGL
+static void*
+load_gl_proc(const char* name) {
+  void (*proc)(void) = eglGetProcAddress(name);
+  void* ptr;
+  memcpy(&ptr, &proc, sizeof(ptr));
+  return ptr;
+}
+
+static void
+setup_bindless_textures(RnBench* b) {
+  b->main_state = b->state;
+  b->state = rn_init_ex(BENCH_WIDTH, BENCH_HEIGHT, load_gl_proc, b->config);
+  if(!b->state->render.bindless) {
+    fprintf(stderr, "runara-bench: bindless textures are not supported, "
+            "bindless_textures binds texture units instead.\n");
+  }
+}
+
+static void
+iter_setup_bindless_textures(RnBench* b) {
+  for(uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++) {
+    b->iter_textures[i] = rn_texture_create(16, 16, RN_TEX_FORMAT_RGBA8);
+  }
+}
+
+static uint32_t
+run_bindless_textures(RnBench* b) {
+  // Rendering makes the handles of the textures resident, 
+  // freeing them makes them non-resident again
+  rn_begin(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++) {
+    vec2s pos = {(float)(i % 16) * 64.0f, (float)(i / 16) * 64.0f};
+    rn_image_render(b->state, pos, RN_WHITE, b->iter_textures[i]);
+  }
+  rn_end(b->state);
+  for(uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++) {
+    rn_texture_free(b->state, &b->iter_textures[i]);
+  }
+  return BENCH_NUM_TEXTURES;
+}
+
+static void
+teardown_bindless_textures(RnBench* b) {
+  rn_terminate(b->state);
+  b->state = b->main_state;
+  b->main_state = NULL;
+}
+
+// ==== Startup ====
+static void
+make_temp_dir(char* dir, size_t size) {
+  snprintf(dir, size, "/tmp/runara-bench-XXXXXX");
+  if(!mkdtemp(dir)) {
+    fprintf(stderr, "runara-bench: failed to create a temporary directory.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static int
+remove_file(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+  (void)st; (void)ftw;
+  return flag == FTW_DP ? 0 : remove(path);
+}
+
+// Removes the files within a directory and it's subdirectories. 
+// The subdirectories are kept, as Mesa only creates the 
+// directories of it's shader cache once.
+static void
+empty_dir(const char* dir) {
+  nftw(dir, remove_file, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static int
+remove_entry(const char* path, const struct stat* st, int flag, struct FTW* ftw) {
+  (void)st; (void)flag; (void)ftw;
+  return remove(path);
+}
+
+// Removes a directory with everything within it
+static void
+remove_dir(const char* dir) {
+  nftw(dir, remove_entry, 16, FTW_DEPTH | FTW_PHYS);
+}
+
+static void
+make_cache_dir(RnBench* b) {
+  make_temp_dir(b->cache_dir, sizeof(b->cache_dir));
+}
+
+static void
+remove_cache_dir(RnBench* b) {
+  remove_dir(b->cache_dir);
+}
+
+static uint32_t
+run_init(RnBench* b) {
+  RnInitConfig config = b->config;
+  config.disable_program_cache = false;
+  config.program_cache_dir = b->cache_dir;
+  b->init_state = rn_init_ex(BENCH_WIDTH, BENCH_HEIGHT, NULL, config);
+  return 1;
+}
+
+static void
+iter_teardown_init(RnBench* b) {
+  rn_terminate(b->init_state);
+  b->init_state = NULL;
+}
+
+static void
+iter_setup_init_cold(RnBench* b) {
+  // Neither runara nor the driver have cached the shaders
+  make_cache_dir(b);
+  empty_dir(b->driver_cache_dir);
+}
+
+static void
+iter_teardown_init_cold(RnBench* b) {
+  iter_teardown_init(b);
+  remove_cache_dir(b);
+}
+
+static void
+setup_init_warm(RnBench* b) {
+  // Populate the program binary cache
+  make_cache_dir(b);
+  run_init(b);
+  iter_teardown_init(b);
+}
+
+static const RnBenchCase cases[] = {
+  {"rects",           true,  gen_rects,           NULL,                       run_rects,          NULL,               free_rects},
+  {"fill_rects",      true,  NULL,                NULL,                       run_fill_rects,     NULL,               NULL},
+  {"rounded_rects",   true,  gen_rects,           NULL,                       run_rounded_rects,  NULL,               free_rects},
+  {"rounded_rects_quads", true, gen_rects,         NULL,                       run_rounded_rects_quads, NULL,          free_rects},
+  {"textured_rects",  true,  gen_rects,           NULL,                       run_textured_rects, NULL,               free_rects},
+  {"bindless_textures", true, setup_bindless_textures, iter_setup_bindless_textures, run_bindless_textures, NULL, teardown_bindless_textures},
+  {"gradient_rects",  true,  setup_gradient_rects, NULL,                      run_gradient_rects, NULL,               teardown_gradient_rects},
+  {"rects_1m_streamed", true, setup_rects_streamed, NULL,                     run_upload_path,    NULL,               teardown_upload_path},
+  {"rects_1m_buffered", true, setup_rects_buffered, NULL,                     run_upload_path,    NULL,               teardown_upload_path},
+  {"glyphs_cached",   true,  setup_cached_glyphs, NULL,                       run_cached_glyphs,  NULL,               free_text},
+  {"glyphs_uncached", true,  setup_charset,       iter_setup_uncached_glyphs, run_charset,        iter_teardown_font, free_text},
+  {"atlas_growth",    true,  setup_charset,       iter_setup_atlas_growth,    run_charset,        iter_teardown_font, free_text},
+  {"glyph_lookup_100",  false, setup_glyph_lookup_100,  NULL,              run_glyph_lookup,   NULL,               teardown_glyph_lookup},
+  {"glyph_lookup_1k",   false, setup_glyph_lookup_1k,   NULL,              run_glyph_lookup,   NULL,               teardown_glyph_lookup},
+  {"glyph_lookup_10k",  false, setup_glyph_lookup_10k,  NULL,              run_glyph_lookup,   NULL,               teardown_glyph_lookup},
+  {"glyph_lookup_100k", false, setup_glyph_lookup_100k, NULL,              run_glyph_lookup,   NULL,               teardown_glyph_lookup},
+  {"paragraph_layout",false, setup_paragraph,     NULL,                       run_paragraph,      NULL,               teardown_paragraph},
+  {"font_load",       false, NULL,                NULL,                       run_font_load,      iter_teardown_font, NULL},
+  {"static_batch",    true,  setup_static_batch,  NULL,                       run_static_batch,   NULL,               teardown_static_batch},
+  {"culled_list",     true,  setup_list,          NULL,                       run_list,           NULL,               teardown_list},
+  {"scroll_views",    true,  setup_list,          NULL,                       run_scroll_views,   NULL,               teardown_list},
+  {"scroll_views_scissor", true, setup_scroll_views_scissor, NULL,            run_scroll_views,   NULL,               teardown_scroll_views},
+  {"panels",          true,  setup_list,          NULL,                       run_panels,         NULL,               teardown_list},
+  {"panels_layers",   true,  setup_layers,        NULL,                       run_panels_layers,  NULL,               teardown_layers},
+  {"lines",           true,  setup_lines,         NULL,                       run_lines,          NULL,               teardown_lines},
+  {"spinners",        true,  setup_spinners,      NULL,                       run_spinners,       NULL,               free_rects},
+  {"window_shadows",  true,  setup_windows,       NULL,                       run_windows,        NULL,               free_rects},
+  {"blur_r4",         true,  setup_windows,       NULL,                       run_blur_r4,        NULL,               free_rects},
+  {"blur_r16",        true,  setup_windows,       NULL,                       run_blur_r16,       NULL,               free_rects},
+  {"blur_r64",        true,  setup_windows,       NULL,                       run_blur_r64,       NULL,               free_rects},
+  {"surface_damage",  true,  setup_surfaces,      NULL,                       run_surface_damage, NULL,               teardown_surfaces},
+  {"surface_full",    true,  setup_surfaces,      NULL,                       run_surface_full,   NULL,               teardown_surfaces},
+  {"reorder",         true,  setup_reorder,       NULL,                       run_reorder,        NULL,               teardown_reorder},
+  {"multi_draw",      true,  setup_multi_draw,    NULL,                       run_multi_draw,     NULL,               teardown_multi_draw},
+  {"recorders",       true,  setup_recorders,     NULL,                       run_recorders,      NULL,               teardown_recorders},
+  {"recorders_mt_1",  false, setup_threads_1,     iter_setup_threads,         run_threads,        iter_teardown_threads, teardown_threads},
+  {"recorders_mt_2",  false, setup_threads_2,     iter_setup_threads,         run_threads,        iter_teardown_threads, teardown_threads},
+  {"recorders_mt_4",  false, setup_threads_4,     iter_setup_threads,         run_threads,        iter_teardown_threads, teardown_threads},
+  {"recorders_mt_n",  false, setup_threads_n,     iter_setup_threads,         run_threads,        iter_teardown_threads, teardown_threads},
+  // Initializes additional states, so these run last
+  {"init_cold",       false, NULL,                iter_setup_init_cold,       run_init,           iter_teardown_init_cold, NULL},
+  {"init_warm",       false, setup_init_warm,     NULL,                       run_init,           iter_teardown_init, remove_cache_dir},
+};
+
+static int
+cmp_double(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+// Sorts the samples and returns the given percentile (nearest rank)
+static double
+percentile(double* samples, uint32_t n, double p) {
+  qsort(samples, n, sizeof(*samples), cmp_double);
+  uint32_t rank = (uint32_t)ceil(p / 100.0 * n);
+  return samples[rank ? rank - 1 : 0];
+}
+
+static void
+write_timings(FILE* out, const char* name, double* samples, uint32_t n) {
+  double median = percentile(samples, n, 50.0);
+  double p99 = percentile(samples, n, 99.0);
+  fprintf(out, "\"%s\": {\"median\": %.4f, \"p99\": %.4f, \"min\": %.4f, \"max\": %.4f}",
+          name, median, p99, samples[0], samples[n - 1]);
+}
+
+static void
+run_case(RnBench* b, const RnBenchCase* c, uint32_t warmup, uint32_t iterations,
+         FILE* out, bool first) {
+  double* cpu_ms = malloc(sizeof(double) * iterations);
+  double* frame_ms = malloc(sizeof(double) * iterations);
+  double* aux_ms = malloc(sizeof(double) * iterations);
+  if(!cpu_ms || !frame_ms || !aux_ms) {
+    fprintf(stderr, "runara-bench: failed to allocate samples.\n");
+    exit(EXIT_FAILURE);
+  }
+  // Every benchmark gets the same sequence of random numbers,
+  // regardless of which benchmarks ran before
+  b->rng = b->seed;
+  b->aux_name = NULL;
+  if(c->setup) c->setup(b);
+
+  uint32_t items = 0;
+  RnFrameStats stats = {0};
+  for(uint32_t i = 0; i < warmup + iterations; i++) {
+    if(c->iter_setup) c->iter_setup(b);
+    glFinish();
+
+    double start = time_ms();
+    items = c->run(b);
+    double cpu_end = time_ms();
+    if(c->frame) glFinish();
+    double frame_end = time_ms();
+
+    if(c->frame) stats = rn_get_frame_stats(b->state);
+    if(c->iter_teardown) c->iter_teardown(b);
+    if(i < warmup) continue;
+    cpu_ms[i - warmup] = cpu_end - start;
+    frame_ms[i - warmup] = frame_end - start;
+    aux_ms[i - warmup] = b->aux_ms;
+  }
+
+  if(c->teardown) c->teardown(b);
+
+  fprintf(out, "%s\n    {\"name\": \"%s\", \"items\": %u, ", first ? "" : ",", c->name, items);
+  write_timings(out, "cpu_ms", cpu_ms, iterations);
+  double median_cpu = cpu_ms[iterations / 2];
+  if(c->frame) {
+    fprintf(out, ", ");
+    write_timings(out, "frame_ms", frame_ms, iterations);
+    fprintf(out, ", \"instances\": %u, \"drawcalls\": %u, \"flushes\": %u, \"bytes_uploaded\": %llu",
+            stats.instances, stats.drawcalls, stats.flushes, (unsigned long long)stats.bytes_uploaded);
+    fprintf(out, ", \"texture_bytes_uploaded\": %llu, \"texture_upload_waits\": %u",
+            (unsigned long long)stats.texture_bytes_uploaded, stats.texture_upload_waits);
+  }
+  if(b->aux_name) {
+    fprintf(out, ", ");
+    write_timings(out, b->aux_name, aux_ms, iterations);
+  }
+  fprintf(out, ", \"items_per_sec\": %.1f}",
+          median_cpu > 0.0 ? items / (median_cpu / 1000.0) : 0.0);
+  fflush(out);
+
+  free(cpu_ms);
+  free(frame_ms);
+  free(aux_ms);
+}
+
+static bool
+has_extension(const char* extensions, const char* name) {
+  size_t len = strlen(name);
+  for(const char* ext = extensions; ext && (ext = strstr(ext, name)); ext += len) {
+    if((ext == extensions || ext[-1] == ' ') && (ext[len] == ' ' || ext[len] == '\0'))
+      return true;
+  }
+  return false;
+}
+
+static void
+create_context(void) {
+  EGLDisplay display = EGL_NO_DISPLAY;
+  const char* client_exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+  if(has_extension(client_exts, "EGL_MESA_platform_surfaceless")) {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+      (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(get_platform_display)
+      display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+  }
+  if(display == EGL_NO_DISPLAY)
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+  EGLint major, minor;
+  if(display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+    fprintf(stderr, "runara-bench: failed to initialize EGL.\n");
+    exit(EXIT_FAILURE);
+  }
+  if(!eglBindAPI(EGL_OPENGL_API)) {
+    fprintf(stderr, "runara-bench: EGL implementation does not support OpenGL.\n");
+    exit(EXIT_FAILURE);
+  }
+
+  EGLint config_attribs[] = {
+    EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+    EGL_NONE
+  };
+  EGLConfig config = NULL;
+  EGLint n_configs = 0;
+  eglChooseConfig(display, config_attribs, &config, 1, &n_configs);
+
+  // Prefer 4.6, fall back to 4.5 for drivers that
+  // only expose the shader draw parameters as extension
+  EGLContext ctx = EGL_NO_CONTEXT;
+  for(EGLint minor_version = 6; minor_version >= 5 && ctx == EGL_NO_CONTEXT; minor_version--) {
+    EGLint ctx_attribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 4,
+      EGL_CONTEXT_MINOR_VERSION, minor_version,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE
+    };
+    ctx = eglCreateContext(display, n_configs ? config : EGL_NO_CONFIG_KHR,
+                           EGL_NO_CONTEXT, ctx_attribs);
+  }
+  if(ctx == EGL_NO_CONTEXT ||
+    !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)) {
+    fprintf(stderr, "runara-bench: failed to create an OpenGL 4.5+ core context.\n");
+    exit(EXIT_FAILURE);
+  }
+  if(!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    fprintf(stderr, "runara-bench: failed to load OpenGL functions.\n");
+    exit(EXIT_FAILURE);
+  }
+}
+
+static void
+create_render_target(void) {
+  uint32_t tex, fbo;
+  glGenTextures(1, &tex);
+  glBindTexture(GL_TEXTURE_2D, tex);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, BENCH_WIDTH, BENCH_HEIGHT, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  glGenFramebuffers(1, &fbo);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex, 0);
+  if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    fprintf(stderr, "runara-bench: offscreen framebuffer is incomplete.\n");
+    exit(EXIT_FAILURE);
+  }
+  glViewport(0, 0, BENCH_WIDTH, BENCH_HEIGHT);
+}
+
+static void
+create_textures(RnBench* b) {
+  // Small seeded noise textures
+  uint8_t pixels[16 * 16 * 4];
+  for(uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++) {
+    for(uint32_t j = 0; j < sizeof(pixels); j++) {
+      pixels[j] = rng_next(b) & 0xFF;
+    }
+    b->textures[i] = (RnTexture){.width = 16, .height = 16};
+    glGenTextures(1, &b->textures[i].id);
+    glBindTexture(GL_TEXTURE_2D, b->textures[i].id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 16, 16, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+}
+
+static void
+usage(const char* prog) {
+  fprintf(stderr,
+          "Usage: %s [--font <path>] [--iterations <n>] [--warmup <n>] [--seed <n>]\n"
+          "          [--filter <substr>] [--compact] [--no-streaming] [--output <file>]\n",
+          prog);
+  exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char** argv) {
+  RnBench b = {0};
+  b.font_path = BENCH_DEFAULT_FONT;
+  b.seed = 0x52554E415241ULL;
+
+  uint32_t iterations = 50, warmup = 3;
+  const char* filter = NULL, *output = NULL;
+  RnInitConfig config = {
+    // Keep the user's program binary cache untouched, 
+    // the startup benchmarks use their own directory
+    .disable_program_cache = true
+  };
+
+  for(int i = 1; i < argc; i++) {
+    const char* arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if(!strcmp(arg, "--font") && has_value) {
+      b.font_path = argv[++i];
+    } else if(!strcmp(arg, "--iterations") && has_value) {
+      iterations = strtoul(argv[++i], NULL, 10);
+    } else if(!strcmp(arg, "--warmup") && has_value) {
+      warmup = strtoul(argv[++i], NULL, 10);
+    } else if(!strcmp(arg, "--seed") && has_value) {
+      b.seed = strtoull(argv[++i], NULL, 0);
+    } else if(!strcmp(arg, "--filter") && has_value) {
+      filter = argv[++i];
+    } else if(!strcmp(arg, "--output") && has_value) {
+      output = argv[++i];
+    } else if(!strcmp(arg, "--compact")) {
+      config.format = RN_INSTANCE_FORMAT_COMPACT;
+    } else if(!strcmp(arg, "--no-streaming")) {
+      config.disable_streaming = true;
+    } else {
+      usage(argv[0]);
+    }
+  }
+  // xorshift never leaves zero
+  if(!b.seed) b.seed = 1;
+  if(!iterations) usage(argv[0]);
+
+  FILE* out = stdout;
+  if(output && !(out = fopen(output, "w"))) {
+    fprintf(stderr, "runara-bench: failed to open '%s'.\n", output);
+    return EXIT_FAILURE;
+  }
+
+  // Mesa's shader cache stays enabled, as Mesa reports no program 
+  // binary formats without it. It's kept in a private directory 
+  // that the startup benchmarks can empty.
+  make_temp_dir(b.driver_cache_dir, sizeof(b.driver_cache_dir));
+  unsetenv("MESA_SHADER_CACHE_DISABLE");
+  setenv("MESA_SHADER_CACHE_DIR", b.driver_cache_dir, 1);
+
+  create_context();
+  create_render_target();
+
+  b.config = config;
+  b.state = rn_init_ex(BENCH_WIDTH, BENCH_HEIGHT, NULL, config);
+  b.font = rn_load_font(b.state, b.font_path, 16);
+  b.rng = b.seed;
+  create_textures(&b);
+
+  fprintf(out, "{\n  \"renderer\": \"%s\",\n  \"version\": \"%s\",\n",
+          (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+  fprintf(out, "  \"seed\": %llu,\n  \"iterations\": %u,\n  \"warmup\": %u,\n",
+          (unsigned long long)b.seed, iterations, warmup);
+  fprintf(out, "  \"format\": \"%s\",\n  \"streaming\": %s,\n  \"benchmarks\": [",
+          config.format == RN_INSTANCE_FORMAT_COMPACT ? "compact" : "full",
+          b.state->render.streaming ? "true" : "false");
+
+  bool first = true;
+  for(uint32_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    if(filter && !strstr(cases[i].name, filter)) continue;
+    run_case(&b, &cases[i], warmup, iterations, out, first);
+    first = false;
+  }
+  fprintf(out, "\n  ]\n}\n");
+
+  for(uint32_t i = 0; i < BENCH_NUM_TEXTURES; i++) {
+    rn_texture_free(b.state, &b.textures[i]);
+  }
+  rn_free_font(b.state, b.font);
+  rn_terminate(b.state);
+  remove_dir(b.driver_cache_dir);
+
+  if(out != stdout) fclose(out);
+  return EXIT_SUCCESS;
+}
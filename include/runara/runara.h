@@ -86,12 +86,92 @@ typedef struct {
 // Other channels are set to 0
 #define RN_BLUE (RnColor){0, 0, 255, 255}
 
-// Defines the count of rendered elements in the batch renderer 
-// before it creates a new batch.
+// Defines the default count of rendered elements in the batch renderer 
+// before it creates a new batch (see RnInitConfig) and the count of 
+// instances per segment of static batches.
 #define RN_MAX_RENDER_BATCH 10000
+// Defines the maximum count of instances of a batch in the compact 
+// instance format (limited by the 16-bit index of extended parameters).
+#define RN_MAX_COMPACT_RENDER_BATCH 65535
 // Defines the maximum number of textures with different IDs that can 
 // be rendered within one batch in the batch renderer.
 #define RN_MAX_TEX_COUNT_BATCH 32
+// Defines the maximum number of textures with different IDs that can 
+// be rendered within one batch if the driver supports bindless textures 
+// (GL_ARB_bindless_texture). Limited by the 8-bit texture index of instances.
+#define RN_MAX_BINDLESS_TEX_COUNT_BATCH 255
+// Defines the number of entries in the hash table that maps texture IDs 
+// to their slot within the current batch (power of two).
+#define RN_TEX_SLOT_TABLE_SIZE 512
+// Defines the number of regions (each holding the capacity 
+// of a batch) of the persistently mapped instance buffer that is 
+// used when the renderer streams instances (see RnRenderState.streaming). 
+// The GPU can read from the other regions while one is written to.
+#define RN_STREAM_REGIONS 3
+
+// Defines the size (in pixels) of the cells of the grid that 
+// the reordering stage uses to find overlapping instances
+#define RN_REORDER_CELL_SIZE 16
+
+// Defines the number of frames whose GPU timer queries can be in 
+// flight at once. Results are read back once they are available.
+#define RN_TIMER_FRAMES 3
+// Defines the maximum number of draws per frame that are timed 
+// on the GPU. Later draws of the frame are not timed.
+#define RN_MAX_TIMED_DRAWS 64
+// Defines the default number of bytes that shaped texts within the 
+// harfbuzz cache may occupy before the least recently used texts 
+// are evicted (see rn_set_harfbuzz_cache_budget).
+#define RN_HARFBUZZ_CACHE_BUDGET (8 * 1024 * 1024)
+// Defines the maximum number of clips that the instances of one 
+// batch can reference (limited by the 8-bit clip slot of instances). 
+// The batch is flushed automatically once all slots are used.
+#define RN_MAX_CLIP_COUNT_BATCH 255
+// Defines the maximum number of clips that can be 
+// pushed onto the clip stack at once (see 'rn_push_clip()')
+#define RN_MAX_CLIP_DEPTH 32
+// Flags the clip of an instance that lies entirely within all clips 
+// enclosing it's clip, so that only the clip itself is evaluated
+#define RN_CLIP_ONLY 0x80000000u
+// Defines the smallest size class of the render targets of 
+// layers (in pixels). Larger targets are rounded up to a 
+// quarter of the power of two below their size.
+#define RN_LAYER_MIN_SIZE 64
+// Defines the number of frames after which render targets 
+// that no layer uses are deleted from the pool.
+#define RN_LAYER_POOL_FRAMES 120
+// Defines the number of pixels by which the quad of a line, ellipse 
+// or arc extends beyond the shape on every side, so that it's edges 
+// are anti-aliased
+#define RN_SHAPE_AA_PAD 1.0f
+// Defines the maximum number of color stops of a gradient paint
+#define RN_PAINT_MAX_STOPS 8
+// Defines the maximum number of times that the background 
+// of a blur is downsampled (limits the blur radius to 
+// about 2^(RN_BLUR_MAX_PASSES + 1) pixels)
+#define RN_BLUR_MAX_PASSES 6
+// Defines the size (in bytes) of the persistently mapped pixel unpack 
+// buffer that texture updates are staged in (see 'rn_texture_update_region()')
+#define RN_UPLOAD_RING_SIZE (32 * 1024 * 1024)
+// Defines the number of segments of the upload ring that are fenced 
+// seperately. Staging waits only if the GPU still reads the next segment.
+#define RN_UPLOAD_SEGMENTS 4
+// Defines the number of specialized variants of the batch shader 
+// that are compiled at initialization.
+#define RN_SHADER_VARIANT_COUNT 9
+// Identifies the files of the program binary cache ("RNPB")
+#define RN_PROGRAM_CACHE_MAGIC 0x42504E52
+// Defines the version of the program binary cache files. Bumped 
+// whenever the layout of 'RnProgramCacheHeader' changes.
+#define RN_PROGRAM_CACHE_VERSION 1
+
+// Marks functions that are only kept for compatibility 
+// (GCC and Clang warn when they are used)
+#if defined(__GNUC__) || defined(__clang__)
+#define RN_DEPRECATED(msg) __attribute__((deprecated(msg)))
+#else
+#define RN_DEPRECATED(msg)
+#endif
 
 // This function type is used as a drop-in replacement for the 
 // GLADloadproc type.
@@ -114,10 +194,169 @@ typedef enum {
   RN_TEX_FILTER_NEAREST
 } RnTextureFiltering;
 
+/**
+ * @enum RnTextureFormat 
+ * @brief Enumeration of the layouts of the pixels that 
+ * textures are updated with (see 'rn_texture_create()')
+ */
+typedef enum {
+  // 8-bit red, green, blue and alpha channels (in byte order)
+  RN_TEX_FORMAT_RGBA8 = 0,
+  // 8-bit blue, green, red and alpha channels (in byte order, 
+  // e.g. WL_SHM_FORMAT_ARGB8888 on little endian machines)
+  RN_TEX_FORMAT_BGRA8,
+  // Like RN_TEX_FORMAT_BGRA8, but the alpha channel is 
+  // unused and sampled as opaque (WL_SHM_FORMAT_XRGB8888)
+  RN_TEX_FORMAT_BGRX8
+} RnTextureFormat;
+
 typedef struct {
   float minx, miny, maxx, maxy;
 } RnAABB;
 
+/**
+ * @enum RnInstanceFormat 
+ * @brief Enumeration of the layouts in which 
+ * instances are uploaded to the GPU
+ */
+typedef enum {
+  // Every instance is uploaded as a full 'RnInstance' 
+  // (floating point position, size and shape parameters)
+  RN_INSTANCE_FORMAT_FULL = 0,
+  // Instances are quantized to an 'RnInstanceCompact' 
+  // (1/4 pixel fixed-point position and size). Rotation 
+  // and shape parameters are uploaded seperately and 
+  // only for the instances that use them.
+  RN_INSTANCE_FORMAT_COMPACT
+} RnInstanceFormat;
+
+/**
+ * @struct RnInitConfig
+ * @brief Configures the batch renderer (see 'rn_init_ex()'). 
+ * Members that are zero select the default behaviour.
+ */
+typedef struct {
+  // The layout of instances on the GPU
+  RnInstanceFormat format;
+  // The number of instances that a batch can hold 
+  // initially (0 = RN_MAX_RENDER_BATCH)
+  uint32_t initial_capacity;
+  // The number of instances that a batch may grow to 
+  // before it is flushed (0 = 'initial_capacity')
+  uint32_t max_capacity;
+  // Stage instances on the CPU even if persistently 
+  // mapped buffers are supported
+  bool disable_streaming;
+  // Measure the GPU time of every draw with timer 
+  // queries (see 'rn_get_frame_stats()')
+  bool gpu_timing;
+  // Always compile the shaders from source instead of 
+  // loading cached program binaries
+  bool disable_program_cache;
+  // The directory that linked program binaries are cached in 
+  // (NULL = '$XDG_CACHE_HOME/runara' or '$HOME/.cache/runara')
+  const char* program_cache_dir;
+} RnInitConfig;
+
+/*
+ * @brief The reasons for which the batch renderer ends a batch
+ */
+typedef enum {
+  // The frame ended ('rn_end()')
+  RN_FLUSH_END = 0,
+  // All texture slots of the batch were used
+  RN_FLUSH_TEXTURES,
+  // The batch reached it's capacity
+  RN_FLUSH_CAPACITY,
+  // A static batch was drawn or recorded
+  RN_FLUSH_STATIC_BATCH,
+  // A font atlas was recreated
+  RN_FLUSH_ATLAS,
+  // The caller ended the batch (e.g. 'rn_next_batch()')
+  RN_FLUSH_EXPLICIT,
+  // All clip slots of the batch were used
+  RN_FLUSH_CLIPS,
+  // A layer began or ended ('rn_begin_layer()')
+  RN_FLUSH_LAYER,
+  // The background of a blur was captured 
+  // ('rn_background_blur_render()')
+  RN_FLUSH_BLUR,
+  RN_FLUSH_CAUSE_COUNT
+} RnFlushCause;
+
+/**
+ * @struct RnFrameStats
+ * @brief Counters of a frame (see 'rn_get_frame_stats()')
+ */
+typedef struct {
+  // The index of the frame (the number of frames before it)
+  uint64_t frame;
+  // The number of drawn instances (including static batches)
+  uint32_t instances;
+  // The number of instances that were culled or clipped
+  uint32_t culled_instances, clipped_instances;
+  // The number of draw calls
+  uint32_t drawcalls;
+  // The number of batches that were ended and the 
+  // number of batches per cause (see RnFlushCause)
+  uint32_t flushes;
+  uint32_t flush_causes[RN_FLUSH_CAUSE_COUNT];
+  // The number of bytes uploaded to the GPU for instances
+  uint64_t bytes_uploaded;
+  // The number of glyph lookups that found a cached 
+  // glyph or had to load it, and the number of 
+  // glyphs that were rasterized into an atlas
+  uint32_t glyph_cache_hits, glyph_cache_misses;
+  uint32_t glyphs_rasterized;
+  // The number of text lookups that found a 
+  // cached shaping or had to shape the text
+  uint32_t shaping_cache_hits, shaping_cache_misses;
+  // The number of bytes that all font atlases occupy
+  uint64_t atlas_bytes;
+  // The number of textures bound for draws
+  uint32_t texture_binds;
+  // The number of bytes of texture updates that were uploaded since 
+  // the previous frame and the number of updates that had to wait 
+  // for the GPU to finish reading from the upload ring
+  uint64_t texture_bytes_uploaded;
+  uint32_t texture_upload_waits;
+
+  // Whether the GPU timings below are available. They belong to 
+  // the latest frame whose timer queries have finished ('gpu_frame'), 
+  // usually one or two frames before 'frame'.
+  bool gpu_valid;
+  uint64_t gpu_frame;
+  // The GPU time of the frame and of each of it's timed draws (ms)
+  float gpu_ms;
+  uint32_t gpu_draws;
+  float gpu_draw_ms[RN_MAX_TIMED_DRAWS];
+} RnFrameStats;
+
+/**
+ * @struct RnGpuTimer
+ * @brief Times draws with GL_TIME_ELAPSED queries 
+ * that are read back asynchronously.
+ */
+typedef struct {
+  // Whether draws are timed
+  bool enabled;
+  // Whether a query is currently running
+  bool running;
+  // The query objects of every frame in flight
+  uint32_t queries[RN_TIMER_FRAMES][RN_MAX_TIMED_DRAWS];
+  // The number of queries that were issued in every frame
+  uint32_t n_queries[RN_TIMER_FRAMES];
+  // The index of the frame of every slot
+  uint64_t frames[RN_TIMER_FRAMES];
+  // The slot of the current frame
+  uint32_t slot;
+  // The latest results that were read back
+  bool has_result;
+  uint64_t result_frame;
+  uint32_t n_results;
+  float results_ms[RN_MAX_TIMED_DRAWS];
+} RnGpuTimer;
+
 /**
  * @enum RnParagraphAlignment 
  * @brief Enumartion of different alignments 
@@ -153,6 +392,67 @@ typedef struct {
   uint32_t id;
 } RnShader;
 
+/**
+ * @enum RnShaderFeature 
+ * @brief Flags of the features that a variant of the batch 
+ * shader supports. Every draw uses the cheapest variant 
+ * that supports the features of its instances.
+ */
+typedef enum {
+  // Instances sample a texture
+  RN_SHADER_FEATURE_TEXTURED = 1 << 0,
+  // Instances sample more than one texture
+  RN_SHADER_FEATURE_MULTI_TEXTURE = 1 << 1,
+  // Instances have rounded corners or a border, are 
+  // not rectangles or are filled with a paint (see RnInstanceShape)
+  RN_SHADER_FEATURE_SHAPED = 1 << 2,
+  // Instances are rotated
+  RN_SHADER_FEATURE_ROTATED = 1 << 3,
+  // Instances are clipped (see 'rn_push_clip()')
+  RN_SHADER_FEATURE_CLIPPED = 1 << 4,
+  RN_SHADER_FEATURE_ALL = (1 << 5) - 1
+} RnShaderFeature;
+
+/**
+ * @struct RnShaderVariant 
+ * @brief A variant of the batch shader that is 
+ * specialized for a set of features.
+ */
+typedef struct {
+  RnShader shader;
+  // The features (RnShaderFeature) the variant supports
+  uint32_t features;
+  // The location of the uniform that offsets 
+  // all instances of a draw (static batches)
+  int32_t offset_loc;
+  // The location of the uniform that enables 
+  // the texture tables (multi-draw mode)
+  int32_t multi_draw_loc;
+} RnShaderVariant;
+
+/**
+ * @struct RnProgramCacheHeader 
+ * @brief The header of a program binary that is cached on disk 
+ *
+ * The binary is only loaded if it was written by the same 
+ * driver for the same shader sources, otherwise the program 
+ * is compiled from source and the file is overwritten.
+ */
+typedef struct {
+  // Identifies runara program binaries (RN_PROGRAM_CACHE_MAGIC)
+  uint32_t magic;
+  // The version of this header (RN_PROGRAM_CACHE_VERSION)
+  uint32_t version;
+  // The hash of the GL vendor, renderer & version strings
+  uint64_t driver_hash;
+  // The hash of the shader sources
+  uint64_t source_hash;
+  // The format of the binary reported by OpenGL
+  uint32_t format;
+  // The size of the binary that follows the header (bytes)
+  uint32_t size;
+} RnProgramCacheHeader;
+
 /**
  * @struct RnWord
  * @brief Represents a word within a rendered paragraph 
@@ -218,12 +518,44 @@ typedef struct RnPathHeader {
   uint32_t stroke_flags; 
 } RnPathHeader; 
 
+/**
+ * @enum RnPaintType 
+ * @brief The ways in which a paint fills an instance
+ */
+typedef enum {
+  // The slot of the paint is unused
+  RN_PAINT_NONE = 0,
+  // The color stops are placed along the line from 'p0' to 'p1'
+  RN_PAINT_LINEAR_GRADIENT,
+  // The color stops are placed from the center 'p0' 
+  // to the ellipse with the radii 'p1' around it
+  RN_PAINT_RADIAL_GRADIENT
+} RnPaintType;
+
+/**
+ * @struct RnGradientStop 
+ * @brief A color of a gradient at a position along 
+ * the gradient (std430 layout of the stop table)
+ */
+typedef struct {
+  // RGBA of the stop (normalized)
+  uint8_t color[4];
+  // The position of the stop along the gradient (0 to 1)
+  float offset;
+} RnGradientStop;
+
 typedef struct RnPaint {
+  // The type of the paint (see RnPaintType)
   uint32_t type;
-  uint32_t _pad0[3]; 
+  // The index of the first color stop of gradients 
+  // within the stop table and the number of stops
+  uint32_t stop_start, n_stops;
+  uint32_t _pad0; 
 
   float color[4]; 
 
+  // The points of gradients relative to the size 
+  // of the filled instance (0 to 1)
   float p0x, p0y;
   float p1x, p1y;
   float scale_x, scale_y;
@@ -251,8 +583,23 @@ typedef struct {
   uint32_t width;
   // The height of the texture (in pixels)
   uint32_t height;
+  // The layout of the pixels that the texture is 
+  // updated with ('rn_texture_update_region()')
+  RnTextureFormat format;
 } RnTexture;
 
+/**
+ * @struct RnTextureRect 
+ * @brief A rectangle of texels within a texture 
+ * (e.g. the damaged region of a client surface)
+ */
+typedef struct {
+  // The position of the top-left texel of the rectangle
+  uint32_t x, y;
+  // The size of the rectangle (in texels)
+  uint32_t width, height;
+} RnTextureRect;
+
 /**
  * @struct RnFont
  * @brief Represents the data of a font used for rendering 
@@ -299,6 +646,9 @@ typedef struct {
   // The OpenGL object ID of the 
   // atlas texture
   uint32_t atlas_id;
+  // Incremented every time the atlas texture is 
+  // recreated (texture coordinates of glyphs change)
+  uint32_t atlas_version;
   // The OpenGL filtering mode of the texture 
   // atlas of the font
   RnTextureFiltering filter_mode;
@@ -358,8 +708,40 @@ typedef struct {
   int32_t ascender;
 
   int32_t descender;
+
+  // The OpenGL object ID of the atlas texture 
+  // that contains the glyph's bitmap
+  uint32_t atlas_id;
 } RnGlyph;
 
+/**
+ * @struct RnGlyphRenderData
+ * @brief Represents the subset of a glyph's data that is 
+ * accessed every time the glyph is rendered.
+ *
+ * This structure is stored seperately from the rest of the 
+ * glyph (RnGlyph) within the glyph cache so that text rendering 
+ * only touches a small, densely packed record per glyph.
+ */
+typedef struct {
+  // The texture coordinates of the glyph on the 
+  // texture atlas of it's font (top left & bottom right)
+  float u0, v0, u1, v1;
+  // The width of the glyphs texture
+  uint32_t width;
+  // The height of the glyphs texture
+  uint32_t height;
+  // The horizontal offset of the glyph's origin from the
+  // font's x-axis.
+  int32_t bearing_x; 
+  // The vertical offset of the glyph's origin from the 
+  // font's baseline.
+  int32_t bearing_y;
+  // The horizontal distance to move the cursor after 
+  // rendering the glyph.
+  int32_t advance;
+} RnGlyphRenderData;
+
 /**
  * @struct RnHarfbuzzText
  * @brief Represents the data that HarfBuzz calculates to 
@@ -367,10 +749,11 @@ typedef struct {
  *
  * This structure is used to cache data that is used to shape and 
  * position a given text. The structure contains a hash by which it 
- * is identified within the cache. The hash is generated by the text 
- * that is rendered.
+ * is located within the cache. The hash is generated by the text 
+ * that is rendered and the font, entries are identified by comparing 
+ * the full text.
  */
-typedef struct {
+typedef struct RnHarfbuzzText {
   // The HarfBuzz buffer of the txt
   hb_buffer_t* buf;
   // The HarfBuzz glyph information (codepoints) of the text
@@ -387,6 +770,8 @@ typedef struct {
   // The text that is rendered with the harfbuzz 
   // information
   char* str;
+  // The length (in bytes) of the text
+  uint32_t len;
   // The highest glyph bearing within the text
   float highest_bearing;
 
@@ -394,8 +779,33 @@ typedef struct {
   // are within the paragraph 
   RnWord* words;
   uint32_t nwords;
+
+  // The number of bytes that the text occupies 
+  // within the budget of the harfbuzz cache
+  size_t bytes;
+  // The number of users that currently hold on to the 
+  // text. Pinned texts are never evicted.
+  uint32_t pins;
+  // The neighbours of the text within the LRU list 
+  // of the harfbuzz cache
+  struct RnHarfbuzzText* lru_prev;
+  struct RnHarfbuzzText* lru_next;
 } RnHarfbuzzText;
 
+/**
+ * @struct RnHarfbuzzKey
+ * @brief Identifies a text of the harfbuzz cache without 
+ * referencing it, as the text can be evicted meanwhile
+ */
+typedef struct {
+  // The hash of the text ('RnHarfbuzzText.hash')
+  uint64_t hash;
+  // The ID of the font of the text
+  uint32_t font_id;
+  // The length (in bytes) of the text
+  uint32_t len;
+} RnHarfbuzzKey;
+
 /**
  * @struct RnVertex 
  * @brief Defines the data that a vertex uses within the 
@@ -413,14 +823,563 @@ typedef struct {
 
 #pragma pack(pop)
 
+/**
+ * @struct RnTexSlot 
+ * @brief Entry of the hash table that maps the ID of a 
+ * texture to it's slot within the current batch.
+ */
+typedef struct {
+  // The OpenGL object ID of the texture 
+  uint32_t id;
+  // The generation of the table in which the entry 
+  // was written. Entries of older generations are unused.
+  uint32_t gen;
+  // The (1-based) slot of the texture within the batch
+  uint32_t slot;
+} RnTexSlot;
+
+/**
+ * @enum RnInstanceShape 
+ * @brief The shapes that an instance is rendered as. The 
+ * flags of the line caps are combined with the shape.
+ */
+typedef enum {
+  // A rectangle with optionally rounded corners and a border
+  RN_SHAPE_RECT = 0,
+  // A line along the horizontal center of the instance with half 
+  // the width 'corner_radius'. The quad extends half it's height 
+  // beyond the ends of the line (see 'rn_line_render()').
+  RN_SHAPE_LINE,
+  // An ellipse inscribed in the instance (minus RN_SHAPE_AA_PAD) 
+  // with an optional border
+  RN_SHAPE_ELLIPSE,
+  // An arc of the circle inscribed in the instance (minus 
+  // RN_SHAPE_AA_PAD) with the thickness 'corner_radius'. The 
+  // start angle and the sweep of the arc are stored in 'uv[0]' 
+  // and 'uv[1]' as fractions of a turn (see 'rn_arc_render()').
+  RN_SHAPE_ARC,
+  // The shadow of a rect with the corner radius 'corner_radius', 
+  // blurred with a gaussian with the standard deviation 
+  // 'border_width'. The quad extends three standard deviations 
+  // beyond the rect (see 'rn_box_shadow_render()').
+  RN_SHAPE_SHADOW,
+  // The mask of the shape without the flags
+  RN_SHAPE_TYPE_MASK = (1 << 5) - 1,
+  // The instance is filled with a paint whose ID is 
+  // stored in place of the color (see 'rn_instance_set_paint()')
+  RN_SHAPE_PAINTED = 1 << 5,
+  // The line ends in a half circle at it's start or end 
+  // (arcs have round ends if RN_SHAPE_ROUND_START is set)
+  RN_SHAPE_ROUND_START = 1 << 6,
+  RN_SHAPE_ROUND_END = 1 << 7
+} RnInstanceShape;
+
+/**
+ * @enum RnLineCap 
+ * @brief The shapes at the ends of rendered lines
+ */
+typedef enum {
+  // The line ends exactly at it's end points
+  RN_LINE_CAP_BUTT = 0,
+  // The line ends in a half circle around it's end points
+  RN_LINE_CAP_ROUND,
+  // The line extends half it's width beyond it's end points
+  RN_LINE_CAP_SQUARE
+} RnLineCap;
+
 typedef struct {
     float pos[2];       // x, y position in pixels
     float size[2];      // width, height in pixels
     float rotation;     // radians
-    uint8_t color[4];   // RGBA (normalized)
-    uint8_t tex_index;  // texture slot 0–31
-    uint8_t _pad[3];    // align to 4 bytes
+    uint8_t color[4];   // RGBA (normalized) or the paint ID with RN_SHAPE_PAINTED
+    uint8_t tex_index;  // texture slot (0 = untextured)
+    uint8_t layer;      // layer used when reordering (see 'rn_set_layer()')
+    uint8_t clip;       // clip slot (0 = unclipped, see 'rn_push_clip()')
+    uint8_t shape;      // shape and line caps (see RnInstanceShape)
+    uint16_t uv[4];     // sampled texture rect u0, v0, u1, v1 (unorm16)
+    float corner_radius; // radius of the rounded corners in pixels
+    float border_width;  // width of the inner border in pixels
+    uint8_t border_color[4]; // RGBA of the border (normalized)
 } RnInstance;
+
+// The number of subpixel steps per pixel of positions 
+// and sizes within compact instances
+#define RN_COMPACT_SUBPIXELS 4
+
+/**
+ * @struct RnInstanceCompact 
+ * @brief The quantized layout of an instance that is 
+ * uploaded to the GPU with RN_INSTANCE_FORMAT_COMPACT.
+ */
+typedef struct {
+    int16_t pos[2];     // x, y position in 1/RN_COMPACT_SUBPIXELS pixels
+    uint16_t size[2];   // width, height in 1/RN_COMPACT_SUBPIXELS pixels
+    uint16_t uv[4];     // sampled texture rect u0, v0, u1, v1 (unorm16)
+    uint8_t color[4];   // RGBA (normalized)
+    uint8_t tex_index;  // texture slot (0 = untextured)
+    uint8_t clip;       // clip slot (0 = unclipped)
+    uint16_t ext_index; // (1-based) index of the extended parameters (0 = none)
+} RnInstanceCompact;
+
+/**
+ * @struct RnInstanceExt 
+ * @brief The parameters of a compact instance that 
+ * are only uploaded if the instance uses them.
+ */
+typedef struct {
+    float rotation;         // radians
+    float corner_radius;    // radius of the rounded corners in pixels
+    float border_width;     // width of the inner border in pixels
+    uint8_t border_color[4];// RGBA of the border (normalized)
+    uint32_t shape;         // shape and line caps (see RnInstanceShape)
+} RnInstanceExt;
+
+/**
+ * @struct RnClipData 
+ * @brief The layout of a clip within the clip 
+ * table of a batch on the GPU.
+ */
+typedef struct {
+  // The clipped area (min x, min y, max x, max y in pixels)
+  float rect[4];
+  // The radius of the rounded corners of the area in pixels
+  float corner_radius;
+  // The (1-based) slot of the enclosing clip 
+  // within the same table (0 = none)
+  uint32_t parent;
+  float _pad[2];
+} RnClipData;
+
+/**
+ * @struct RnClip 
+ * @brief A clip that was pushed during the 
+ * current frame (see 'rn_push_clip()').
+ */
+typedef struct {
+  // The clipped area (min x, min y, max x, max y in pixels)
+  float rect[4];
+  // The radius of the rounded corners of the area in pixels
+  float corner_radius;
+  // The (1-based) index of the enclosing clip 
+  // within the clips of the frame (0 = none)
+  uint32_t parent;
+  // The generation of the clip table in which the clip 
+  // was added to the batch and it's slot within the table
+  uint32_t gen, slot;
+  // The same for the entry of the clip without it's 
+  // enclosing clips (see RN_CLIP_ONLY)
+  uint32_t only_gen, only_slot;
+} RnClip;
+
+/**
+ * @struct RnClipStack 
+ * @brief The clips of the current frame, the stack of 
+ * clips that apply to new instances and the clip table 
+ * of the current batch.
+ */
+typedef struct {
+  // All clips that were pushed during the frame
+  RnClip* clips;
+  uint32_t n_clips, clips_cap;
+  // The (1-based) indices of the pushed clips 
+  // within 'clips' (innermost last)
+  uint32_t stack[RN_MAX_CLIP_DEPTH];
+  uint32_t depth;
+  // The depth at which the clips of the layer 
+  // that is rendered to begin (see RnLayer)
+  uint32_t base;
+  // The cull box before each clip was pushed
+  vec2s saved_cull_start[RN_MAX_CLIP_DEPTH], saved_cull_end[RN_MAX_CLIP_DEPTH];
+  // The clips referenced by the instances of the current batch
+  RnClipData table[RN_MAX_CLIP_COUNT_BATCH];
+  uint32_t count;
+  // The current generation of the clip table 
+  // (incremented to clear the table)
+  uint32_t gen;
+  // The OpenGL object ID of the shader storage 
+  // buffer that the clip table is uploaded to
+  uint32_t ssbo;
+} RnClipStack;
+
+/**
+ * @struct RnPaintTable 
+ * @brief The paints that instances are filled with. The 
+ * table persists across frames and is uploaded to the 
+ * GPU whenever a paint is created.
+ */
+typedef struct {
+  // The paints, indexed by their ID - 1
+  RnPaint* paints;
+  // The color stops of the paints (RN_PAINT_MAX_STOPS per paint)
+  RnGradientStop* stops;
+  uint32_t n_paints, paints_cap;
+  // The OpenGL object IDs of the shader storage 
+  // buffers that the paints and stops are uploaded to
+  uint32_t ssbo_paints, ssbo_stops;
+} RnPaintTable;
+
+/**
+ * @struct RnStaticBatchSegment 
+ * @brief A range of instances within a static batch 
+ * that is drawn with a single set of textures.
+ */
+typedef struct {
+  // The index of the first instance of the segment
+  uint32_t first;
+  // The number of instances within the segment
+  uint32_t count;
+  // The index of the first texture of the segment 
+  // within the textures of the static batch
+  uint32_t tex_first;
+  // The number of textures of the segment
+  uint32_t tex_count;
+  // The byte offset of the extended parameters of the 
+  // segment within the parameter buffer (compact instances)
+  uint32_t ext_offset;
+  // The number of extended parameters of the segment
+  uint32_t n_ext;
+  // The shader features (RnShaderFeature) 
+  // used by the instances of the segment
+  uint32_t features;
+  // The index of the first clip of the segment within 
+  // the clips of the static batch and the number of clips
+  uint32_t clip_first, n_clips;
+  // The byte offset of the clips of the 
+  // segment within the clip buffer
+  uint32_t clip_offset;
+} RnStaticBatchSegment;
+
+/**
+ * @struct RnStaticGlyphRef 
+ * @brief References a glyph instance of a static 
+ * batch, so that it's texture coordinates can be 
+ * updated when the atlas of it's font is recreated.
+ */
+typedef struct {
+  // The index of the instance within the static batch
+  uint32_t instance;
+  // The index of the segment that contains the instance
+  uint32_t segment;
+  // The key of the glyph within the glyph cache
+  uint64_t key;
+  // The part of the texture rect of the glyph that the instance 
+  // samples if it was clipped to the cull box (u0, v0, u1, v1 as 
+  // fractions of the rect, 0, 0, 1, 1 if it was not clipped)
+  float uv_clip[4];
+} RnStaticGlyphRef;
+
+/**
+ * @struct RnStaticBatch 
+ * @brief A batch of instances that is recorded once, 
+ * kept in it's own GPU buffer and redrawn every frame 
+ * without uploading it again.
+ *
+ * The batch is recorded between 'rn_batch_record_begin()' 
+ * and 'rn_batch_record_end()' with the regular render 
+ * functions and only needs to be recorded again if 
+ * it's content changes ('rn_batch_mark_dirty()').
+ */
+typedef struct RnStaticBatch {
+  // The OpenGL object ID of the vertex array 
+  // that sources the instances of the batch
+  uint32_t vao;
+  // The OpenGL object ID of the buffer that 
+  // holds the instances of the batch
+  uint32_t vbo;
+  // The OpenGL object ID of the shader storage buffer 
+  // that holds the extended parameters (compact instances)
+  uint32_t ssbo_ext;
+  // The OpenGL object ID of the shader storage 
+  // buffer that holds the clips of all segments
+  uint32_t ssbo_clips;
+
+  // The recorded instances 
+  RnInstance* instances;
+  uint32_t n_instances, instances_cap;
+  // The ranges of instances that are drawn 
+  // with a single set of textures
+  RnStaticBatchSegment* segments;
+  uint32_t n_segments, segments_cap;
+  // The textures of all segments
+  RnTexture* textures;
+  uint32_t n_textures, textures_cap;
+  // The clip tables of all segments
+  RnClipData* clips;
+  uint32_t n_clips, clips_cap;
+  // The glyph instances of the batch
+  RnStaticGlyphRef* glyphs;
+  uint32_t n_glyphs, glyphs_cap;
+
+  // The atlas generation of the state with which 
+  // the glyph instances were recorded
+  uint32_t atlas_generation;
+  // Whether the content of the batch needs to be recorded
+  bool dirty;
+
+  // The instance staging of the regular batch, 
+  // restored when recording ends
+  RnInstance* saved_instances;
+  uint32_t saved_n_instances, saved_batch_start;
+} RnStaticBatch;
+
+/**
+ * @struct RnRecordedText 
+ * @brief A text of a recorder that could not be laid out on 
+ * the recording thread (it's shaping or glyphs were not 
+ * cached yet). It is rendered on the GL thread during the merge.
+ */
+typedef struct {
+  // The number of instances of the recorder 
+  // that were recorded before the text
+  uint32_t first;
+  // The offset of the text within the string 
+  // arena of the recorder
+  uint32_t str_offset;
+  // The font to render the text with
+  RnFont* font;
+  // The position of the text
+  vec2s pos;
+  // The color of the text (RGBA)
+  uint8_t color[4];
+  // The line height of the text (0 for the font's height)
+  float line_height;
+} RnRecordedText;
+
+/**
+ * @struct RnRecorder 
+ * @brief Records instances independently of the batch 
+ * renderer, so that multiple threads can record at the 
+ * same time (one recorder per thread).
+ *
+ * Recorders are submitted on the GL thread with 
+ * 'rn_submit_recorder()' and merged into the batch in 
+ * submission order at 'rn_end()'. While recorders are 
+ * recording, the GL thread must not use the library, 
+ * as the glyph and text caches are read without locking.
+ */
+typedef struct RnRecorder {
+  // The state of the library the recorder reads from
+  struct RnState* state;
+  // The recorded instances
+  RnInstance* instances;
+  // The OpenGL texture ID of every recorded instance 
+  // (0 if the instance is untextured)
+  uint32_t* tex_ids;
+  // The (1-based) index of the clip of every recorded instance within 
+  // the clips of the frame, optionally flagged with RN_CLIP_ONLY. Only 
+  // instances captured for reordering are clipped, the instances 
+  // of recorders are always 0.
+  uint32_t* clip_ids;
+  uint32_t n_instances, instances_cap;
+  // Texts that are rendered during the merge
+  RnRecordedText* texts;
+  uint32_t n_texts, texts_cap;
+  // The copied strings of the recorded texts
+  char* strings;
+  uint32_t strings_len, strings_cap;
+  // The glyph instances of the recorder (only 'instance' and 
+  // 'key' are used), patched if an atlas is recreated before the merge
+  RnStaticGlyphRef* glyphs;
+  uint32_t n_glyphs, glyphs_cap;
+  // The keys of the cached texts that were used while recording 
+  // (marked as recently used on submission if they are still cached)
+  RnHarfbuzzKey* hb_hits;
+  uint32_t n_hb_hits, hb_hits_cap;
+
+  // The cull box of the state when recording began
+  vec2s cull_start, cull_end;
+  // The number of culled and clipped instances of the recorder
+  uint32_t culled_instances, clipped_instances;
+  // The atlas generation of the state when recording began
+  uint32_t atlas_generation;
+  // The layer that new instances are recorded on
+  uint8_t layer;
+} RnRecorder;
+
+/**
+ * @struct RnReorderDraw 
+ * @brief A group of instances that the reordering 
+ * stage emits together (see 'rn_set_reorder()').
+ */
+typedef struct {
+  // The first and last instance of the draw (the instances 
+  // are linked in the order in which they were rendered)
+  uint32_t head, tail;
+  // The number of textures the instances of the draw use
+  uint32_t tex_count;
+} RnReorderDraw;
+
+/**
+ * @struct RnReorder 
+ * @brief The state of the stage that reorders the 
+ * instances of a frame to minimize draw calls.
+ */
+typedef struct {
+  // Whether instances are reordered at 'rn_end()'
+  bool enabled;
+  // Whether the reordered instances are currently emitted
+  bool emitting;
+  // The layer that new instances are rendered on
+  uint8_t layer;
+  // Captures the instances of the frame until they are reordered
+  RnRecorder* frame;
+  // The captured instances ordered by layer and the 
+  // next instance of the same draw for each instance
+  uint32_t* order, *next;
+  uint32_t order_cap;
+  // The draws the instances are grouped into
+  RnReorderDraw* draws;
+  uint32_t n_draws, draws_cap;
+  // The texture IDs of every draw ('max_textures' per draw)
+  uint32_t* draw_textures;
+  uint32_t draw_textures_cap;
+  // The last draw (1-based) that covers each 
+  // cell of a grid over the rendered area
+  uint32_t* grid;
+  uint32_t grid_w, grid_h;
+} RnReorder;
+
+/**
+ * @struct RnDrawCommand 
+ * @brief An indexed indirect draw command 
+ * (layout of OpenGL's DrawElementsIndirectCommand).
+ */
+typedef struct {
+  uint32_t count;
+  uint32_t instance_count;
+  uint32_t first_index;
+  int32_t base_vertex;
+  uint32_t base_instance;
+} RnDrawCommand;
+
+/**
+ * @struct RnMultiDraw 
+ * @brief The draws that are queued in multi-draw mode 
+ * and submitted together (see 'rn_set_multi_draw()').
+ */
+typedef struct {
+  // Whether batches are queued instead of drawn right away
+  bool enabled;
+  // The queued draws
+  RnDrawCommand* commands;
+  uint32_t n_commands, commands_cap;
+  // The texture table of every queued draw: the offset of it's 
+  // extended instance parameters and of it's clips, followed by the 
+  // (1-based) index within 'textures' of every texture slot of the draw
+  uint32_t* table;
+  uint32_t table_cap;
+  // The clip tables of the queued draws
+  RnClipData* clips;
+  uint32_t n_clips, clips_cap;
+  // The textures used by the queued draws
+  RnTexture textures[RN_MAX_BINDLESS_TEX_COUNT_BATCH];
+  uint32_t tex_count;
+  // The number of extended parameters of the 
+  // queued compact instances
+  uint32_t n_ext;
+  // The buffers the commands and tables are uploaded to
+  uint32_t ibo_commands, ssbo_table;
+  // The shader features (RnShaderFeature) 
+  // used by the instances of the queued draws
+  uint32_t features;
+} RnMultiDraw;
+
+/**
+ * @struct RnRenderTarget 
+ * @brief A texture and the framebuffer that renders into it.
+ *
+ * The size of the texture is rounded up to a size class 
+ * (see RN_LAYER_MIN_SIZE), so that unused targets can be 
+ * reused by layers of a similar size.
+ */
+typedef struct {
+  // The color attachment of the framebuffer 
+  // (with the size of the size class)
+  RnTexture texture;
+  // The OpenGL object ID of the framebuffer
+  uint32_t fbo;
+  // The frame in which the target was returned to the pool
+  uint64_t released_frame;
+} RnRenderTarget;
+
+/**
+ * @struct RnLayer 
+ * @brief An offscreen surface whose content is kept 
+ * in a texture and composited with a single instance.
+ *
+ * The layer is rendered between 'rn_begin_layer()' and 
+ * 'rn_end_layer()' with the regular render functions and 
+ * only needs to be rendered again if it's content changes 
+ * ('rn_layer_mark_dirty()').
+ */
+typedef struct RnLayer {
+  // The render target that holds the content 
+  // of the layer (id 0 if it has none)
+  RnRenderTarget target;
+  // The size of the content of the layer (px)
+  uint32_t width, height;
+  // Whether the content of the layer needs to be rendered
+  bool dirty;
+
+  // The layer that was rendered to before the layer 
+  // began (NULL for the display) and it's state, 
+  // restored when the layer ends
+  struct RnLayer* parent;
+  uint32_t saved_fbo;
+  uint32_t saved_render_w, saved_render_h;
+  vec2s saved_cull_start, saved_cull_end;
+  uint32_t saved_clip_base;
+  uint32_t saved_n_submitted;
+  bool saved_scissor;
+} RnLayer;
+
+/**
+ * @struct RnBlurState 
+ * @brief The compute program of background blurs and 
+ * the render targets of the blurs of the current frame.
+ */
+typedef struct {
+  // The OpenGL object ID of the program of the downsampling and 
+  // upsampling passes (created with the first blur)
+  uint32_t program;
+  // The locations of the uniforms of the program
+  int32_t texel_loc, src_size_loc, dst_size_loc, offset_loc, upsample_loc;
+  // The render targets that the blurs of the frame sample, 
+  // they return to the pool at the end of the frame
+  RnRenderTarget* targets;
+  uint32_t n_targets, targets_cap;
+} RnBlurState;
+
+/**
+ * @struct RnUploadRing 
+ * @brief The persistently mapped pixel unpack buffer that 
+ * texture updates are staged in ('rn_texture_update_region()')
+ *
+ * The buffer is split into RN_UPLOAD_SEGMENTS segments. Updates 
+ * are written to the current segment, and once it is full it is 
+ * fenced and staging continues in the next one, so that the 
+ * GPU copies the previous segments while the next is written.
+ */
+typedef struct {
+  // The OpenGL object ID of the buffer (created with the first update)
+  uint32_t pbo;
+  // The persistent mapping of the buffer
+  uint8_t* ptr;
+  // The segment that is written to and the offset (in bytes) 
+  // of the next update within the buffer
+  uint32_t segment, offset;
+  // The fences (GLsync) that signal when the GPU 
+  // has finished reading from each segment
+  void* fences[RN_UPLOAD_SEGMENTS];
+  // The number of uploaded bytes and the number of 
+  // waits for the GPU since the previous frame
+  uint64_t bytes;
+  uint32_t waits;
+  // Set if the buffer could not be mapped, updates 
+  // are then copied by the driver directly
+  bool unmapped;
+} RnUploadRing;
+
 /**
  * @struct RnRenderState 
  * @brief Defines the state of the 2D batch renderer 
@@ -435,9 +1394,18 @@ typedef struct {
  * batch.
  */
 typedef struct {
-  // The OpenGL shader that is used for 
-  // rendering batches
+  // The OpenGL shader that supports all features 
+  // (the last of the shader variants)
   RnShader shader;
+  // Specialized variants of the batch shader, ordered 
+  // from the cheapest to the most expensive one
+  RnShaderVariant variants[RN_SHADER_VARIANT_COUNT];
+  // The index of the variant that is in use 
+  // (UINT32_MAX if unknown)
+  uint32_t variant;
+  // The shader features (RnShaderFeature) used by the 
+  // instances of the current batch
+  uint32_t features;
   // The OpenGL object ID of the vertex array 
   // that is used to render a batch.
   uint32_t vao;
@@ -448,26 +1416,114 @@ typedef struct {
   // The OpenGL object ID of the index buffer 
   // that is used to index vertices.
   uint32_t ibo;
-  // The vertex data in the current batch
+  // The layout in which instances are uploaded to the GPU
+  RnInstanceFormat format;
+  // The size of one instance within the instance buffer 
+  // (depends on 'format')
+  uint32_t instance_size;
+  // The vertex data in the current batch. 
+  // When streaming full instances, this points into the mapped 
+  // region of the instance buffer that is currently written to.
+  // Compact instances are always staged on the CPU and packed 
+  // when the batch is flushed.
   RnInstance* instances;
+  // The packed compact instances of the batch 
+  // (only used for compact instances without streaming)
+  RnInstanceCompact* packed;
+  // The extended parameters of the compact 
+  // instances that are flushed
+  RnInstanceExt* ext;
+  // The OpenGL object ID of the shader storage buffer 
+  // that holds the extended parameters
+  uint32_t ssbo_ext;
   uint32_t n_instances;
+  // The index of the first instance within 'instances' 
+  // that was not drawn yet
+  uint32_t batch_start;
   // The vertex positions that make up a quad (NDC)
   vec4s vert_pos[4];
   // The textures that are rendered within the 
   // current batch
-  RnTexture textures[RN_MAX_TEX_COUNT_BATCH];
+  RnTexture textures[RN_MAX_BINDLESS_TEX_COUNT_BATCH];
   // The index to insert at which to insert 
   // new textures
   uint32_t tex_index;
   // The number of textures in the current batch
   uint32_t tex_count;
+  // The maximum number of textures within one batch. The batch 
+  // is flushed automatically once all slots are used.
+  // (RN_MAX_TEX_COUNT_BATCH or RN_MAX_BINDLESS_TEX_COUNT_BATCH)
+  uint32_t max_textures;
+  // Hash table that maps texture IDs to their slot 
+  // within the current batch
+  RnTexSlot tex_slots[RN_TEX_SLOT_TABLE_SIZE];
+  // The current generation of the texture slot table 
+  // (incremented to clear the table)
+  uint32_t tex_slots_gen;
+  // The clips of the frame and of the current batch
+  RnClipStack clips;
+  // The gradient paints that instances are filled with
+  RnPaintTable paints;
+
+  // Whether textures are accessed through bindless handles 
+  // (GL_ARB_bindless_texture) instead of texture units
+  bool bindless;
+  // The OpenGL object ID of the shader storage buffer 
+  // that holds the texture handles of the current batch
+  uint32_t ssbo_tex_handles;
+  // The bindless texture entry points of the driver 
+  // (glGetTextureHandleARB, glIsTextureHandleResidentARB, 
+  // glMakeTextureHandleResidentARB, glMakeTextureHandleNonResidentARB)
+  uint64_t (*get_texture_handle)(uint32_t tex);
+  uint8_t  (*is_texture_handle_resident)(uint64_t handle);
+  void     (*make_texture_handle_resident)(uint64_t handle);
+  void     (*make_texture_handle_non_resident)(uint64_t handle);
+
+  // The number of instances that a batch can currently 
+  // hold and that it may grow to (see RnInitConfig)
+  uint32_t capacity, max_capacity;
 
   // The width of the rendered area
   uint32_t render_w;
   // The height of the rendered area
   uint32_t render_h;
 
+  // Whether instances are written straight into a persistently 
+  // mapped instance buffer (requires OpenGL 4.4). Otherwise 
+  // instances are staged on the CPU and uploaded on every flush.
+  bool streaming;
+  // The persistently mapped memory of the instance 
+  // buffer (NULL if not streaming)
   void* vbo_ptr;  
+  // The region of the instance buffer that 
+  // is currently written to
+  uint32_t region;
+  // The static batch that is currently recorded 
+  // (NULL if instances are rendered immediately)
+  RnStaticBatch* recording;
+  // The layer that is currently rendered 
+  // to (NULL if rendering to the display)
+  RnLayer* layer;
+  // The render targets that no layer uses
+  RnRenderTarget* targets;
+  uint32_t n_targets, targets_cap;
+  // The background blurs of the frame
+  RnBlurState blur;
+  // Stages the updates of textures
+  RnUploadRing upload;
+  // The recorders that are merged into the batch 
+  // at the end of the frame (in submission order)
+  RnRecorder** submitted;
+  uint32_t n_submitted, submitted_cap;
+  // Groups the instances of a frame by their textures
+  RnReorder reorder;
+  // Queues the batches of a frame as indirect draws
+  RnMultiDraw multi_draw;
+  // The fences (GLsync) that signal when the GPU has 
+  // finished reading from each region
+  void* region_fences[RN_STREAM_REGIONS];
+  // Times the draws of the renderer on the GPU
+  RnGpuTimer timer;
 } RnRenderState;
 
 /**
@@ -504,20 +1560,68 @@ typedef struct {
   vec2s paragraph_pos;
 } RnTextProps; 
 
+// Marks an unused slot within the glyph cache
+#define RN_GLYPH_CACHE_EMPTY UINT64_MAX
+
 /**
  * @struct RnGlyphCache 
- * @brief Simple dynamic 
- * array structure to cache glyphs
+ * @brief Open-addressing hash table (linear probing) 
+ * that caches glyphs by font ID and glyph index.
+ *
+ * The keys, the render data and the full glyph information 
+ * are stored in seperate arrays that share the same slot 
+ * index, so probing only touches the key array and rendering 
+ * only touches the render data.
  */
-typedef DA_TYPE(RnGlyph) RnGlyphCache;
+typedef struct {
+  // The key of every slot ((font ID << 32) | glyph index)
+  // or RN_GLYPH_CACHE_EMPTY if the slot is unused
+  uint64_t* keys;
+  // The render data of the glyph in every slot
+  RnGlyphRenderData* hot;
+  // The full information of the glyph in every slot
+  RnGlyph* glyphs;
+  // The number of slots (always a power of two)
+  uint32_t cap;
+  // The number of occupied slots
+  uint32_t len;
+  // The number of lookups that found a cached glyph
+  uint64_t hits;
+  // The number of lookups that had to load the glyph
+  uint64_t misses;
+} RnGlyphCache;
 
 /**
- * @struct RnGlyphCache 
- * @brief Simple dynamic 
- * array structure to cache 
- * harfbuzz text information
+ * @struct RnHarfbuzzCache 
+ * @brief Open-addressing hash table (linear probing)
+ * that caches harfbuzz text information.
+ *
+ * Texts are kept in a least recently used list. When the 
+ * cached texts occupy more than 'budget' bytes, the least 
+ * recently used texts are evicted.
  */
-typedef DA_TYPE(RnHarfbuzzText*) RnHarfbuzzCache;
+typedef struct {
+  // The slots of the hash table (NULL if the slot is unused)
+  RnHarfbuzzText** slots;
+  // The number of slots (always a power of two)
+  uint32_t cap;
+  // The number of cached texts
+  uint32_t len;
+  // The most recently used text 
+  RnHarfbuzzText* lru_head;
+  // The least recently used text
+  RnHarfbuzzText* lru_tail;
+  // The number of bytes occupied by all cached texts
+  size_t bytes;
+  // The maximum number of bytes that cached texts may occupy
+  size_t budget;
+  // The number of lookups that found a cached text
+  uint64_t hits;
+  // The number of lookups that had to shape the text
+  uint64_t misses;
+  // The number of texts that were evicted to stay within budget
+  uint64_t evictions;
+} RnHarfbuzzCache;
 
 /**
  * @struct RnState 
@@ -529,7 +1633,7 @@ typedef DA_TYPE(RnHarfbuzzText*) RnHarfbuzzCache;
  * the dimensions of the rendered area and text rendering 
  * caches. 
  */
-typedef struct {
+typedef struct RnState {
   // States if the library has already been 
   // initialized (Set to true after 'rn_init()')
   bool init;
@@ -540,9 +1644,32 @@ typedef struct {
   // batch. The value of this variable will 
   // only be correct if used after 'rn_end()'
   uint32_t drawcalls;
+  // The number of bytes of instance data uploaded 
+  // to the GPU in the current frame. The value of 
+  // this variable will only be correct if used after 'rn_end()'
+  uint64_t bytes_uploaded;
+  // The number of instances in the current frame that 
+  // were rejected because they lie outside of the cull box
+  uint32_t culled_instances;
+  // The number of instances in the current frame that 
+  // were clipped to the cull box
+  uint32_t clipped_instances;
+  // The highest number of instances that the instance 
+  // buffer held at once since initialization
+  uint32_t batch_high_water;
+  // The number of bytes that all font atlases occupy
+  uint64_t atlas_bytes;
+  // The counters of the current frame
+  RnFrameStats stats;
+  // The counters of the last completed frame
+  RnFrameStats last_stats;
+  // The lookup counters of the glyph and 
+  // harfbuzz caches when the frame began
+  uint64_t glyph_hits_begin, glyph_misses_begin;
+  uint64_t hb_hits_begin, hb_misses_begin;
 
   // The FreeType handle used for loading 
-  // fonts
+  // fonts (initialized with the first font)
   FT_Library ft;
   // The data of cached glyphs
   RnGlyphCache glyph_cache;
@@ -552,8 +1679,13 @@ typedef struct {
   // The ID that is used for the next 
   // loaded font (incremented if a font was loaded)
   uint32_t font_id;
+  // Incremented every time the atlas of any font is 
+  // recreated (invalidates glyph instances of static batches)
+  uint32_t atlas_generation;
 
-  // The starting position of the active culling box (-1,-1 when no culling box) 
+  // The starting position of the active culling box (-1,-1 when no culling box). 
+  // Instances outside of the box are not rendered, unrotated images, 
+  // glyphs and plain rects are clipped to it.
   vec2s cull_start;
   // The ending position of the active culling box (-1,-1 when no culling box) 
   vec2s cull_end;
@@ -583,9 +1715,13 @@ typedef struct {
 /**
  * @brief Initializes the Runara library 
  *
- * This function sets up initial variable values, 
- * the OpenGL batch renderer and the FreeType library 
- * used for loading fonts.
+ * This function sets up initial variable values and 
+ * the OpenGL batch renderer. The FreeType library used 
+ * for loading fonts is initialized with the first font.
+ *
+ * The linked shader program is cached on disk (see 
+ * 'RnInitConfig.program_cache_dir'), so that later 
+ * launches on the same driver skip compiling it.
  *
  * @param[in] render_w The width of the area on which Runara will render 
  * @param[in] render_h The height of the area on which Runara will render
@@ -600,6 +1736,39 @@ typedef struct {
  */
 RnState* rn_init(uint32_t render_w, uint32_t render_h, RnGLLoader loader);
 
+/**
+ * @brief Initializes the Runara library with 
+ * a given configuration of the batch renderer
+ *
+ * Works like 'rn_init()' but lets the caller choose the 
+ * layout in which instances are uploaded to the GPU and 
+ * the capacity of batches. 
+ *
+ * RN_INSTANCE_FORMAT_COMPACT roughly halves the uploaded 
+ * bytes of axis-aligned, pixel-snapped scenes (UI, text). 
+ * Positions are limited to [-8192, 8192) and sizes 
+ * to [0, 16384) pixels in that format.
+ *
+ * If a frame renders more instances than a batch can hold, the 
+ * CPU and GPU instance buffers are doubled (up to 'max_capacity') 
+ * instead of flushing the batch. 'RnState.batch_high_water' 
+ * reports the highest number of instances that were needed.
+ *
+ * Program binaries are loaded from 'program_cache_dir' if they 
+ * were written by the same driver for the same shader sources. 
+ * Otherwise the shaders are compiled from source and the cache 
+ * is updated. Failing to read or write the cache is not an error.
+ *
+ * @param[in] render_w The width of the area on which Runara will render 
+ * @param[in] render_h The height of the area on which Runara will render
+ * @param[in] loader The function to load OpenGL with 
+ * @param[in] config The configuration of the batch renderer
+ * 
+ * @return The initialized state of the library.
+ * */
+RnState* rn_init_ex(uint32_t render_w, uint32_t render_h, RnGLLoader loader, 
+                    RnInitConfig config);
+
 /**
  * @brief Terminates the Runara library 
  *
@@ -819,10 +1988,72 @@ void rn_set_font_size(RnState* state, RnFont* font, uint32_t size);
  * with the ID of a given texture and memet's the 
  * given texture pointer to zero.
  *
+ * @deprecated Without the state of the library, the bindless 
+ * handle that the batch renderer made resident for the texture 
+ * cannot be released. Use 'rn_texture_free()' instead.
+ *
  * @param[in] tex The texture to deallocate
  * */
+RN_DEPRECATED("use rn_texture_free()") 
 void rn_free_texture(RnTexture* tex);
 
+/*
+ * @brief Deallocates the OpenGL texture object of a texture 
+ * and makes it's bindless handle non-resident if the batch 
+ * renderer made it resident (see RnRenderState.bindless). 
+ * Replaces 'rn_free_texture()'.
+ *
+ * @param[in] state The state of the library
+ * @param[in] tex The texture to deallocate (zeroed afterwards)
+ * */
+void rn_texture_free(RnState* state, RnTexture* tex);
+
+/*
+ * @brief Creates an empty (transparent) texture that is 
+ * updated from memory, e.g. the surface of a client window.
+ *
+ * The texture has no mipmaps and is sampled linearly 
+ * and clamped to it's edges.
+ *
+ * @param[in] width The width of the texture (in pixels)
+ * @param[in] height The height of the texture (in pixels)
+ * @param[in] format The layout of the pixels that the 
+ * texture is updated with
+ *
+ * @return The created texture
+ * */
+RnTexture rn_texture_create(uint32_t width, uint32_t height, RnTextureFormat format);
+
+/*
+ * @brief Updates a rectangle of a texture (e.g. the damaged 
+ * region of a client surface) without stalling the render thread.
+ *
+ * The rows of the rectangle are copied straight from 'pixels' into 
+ * a persistently mapped pixel unpack buffer (see RnUploadRing) and 
+ * the GPU copies them into the texture asynchronously. 'pixels' can 
+ * point into shared memory (e.g. a mapped memfd of a wl_shm pool), 
+ * it is not accessed after the function returns. Without GL 4.4 
+ * the texture is updated from 'pixels' directly.
+ *
+ * The update applies to all draws of the texture that were not 
+ * submitted yet, so textures should be updated before the 
+ * frame renders them.
+ *
+ * @param[in] state The state of the library
+ * @param[in] tex The texture to update ('rn_texture_create()')
+ * @param[in] rect The rectangle to update, clipped to the texture
+ * @param[in] pixels The pixels of the whole texture (starting 
+ * at it's top-left texel) in the format of the texture
+ * @param[in] stride The number of bytes between 
+ * the starts of two rows of 'pixels'
+ * */
+void rn_texture_update_region(
+    RnState* state, 
+    RnTexture tex, 
+    RnTextureRect rect, 
+    const void* pixels, 
+    uint32_t stride);
+
 /*
  * @brief Deallocates all memory that is allocated 
  * for the given font.
@@ -856,6 +2087,11 @@ void rn_clear_color(RnColor color);
  * this function uses upper left, like all other functions 
  * in runara.
  *
+ * NOTE: The scissor rectangle applies to the whole batch when 
+ * it is drawn, so the batch needs to be ended before and after 
+ * the scissored content ('rn_next_batch()'). 'rn_push_clip()' 
+ * clips without ending the batch.
+ *
  * @param[in] pos The starting position of the 
  * scissored box
  * @param[in] size The size of the scissored box
@@ -870,6 +2106,39 @@ void rn_begin_scissor(vec2s pos, vec2s size, uint32_t render_height);
  * */
 void rn_end_scissor(void);
 
+/*
+ * @brief Clips everything that is rendered until the matching 
+ * 'rn_pop_clip()' to a (rounded) rectangle. Clips nest: 
+ * instances are clipped to the intersection of all pushed clips.
+ *
+ * Unlike a scissor rectangle, clips do not end the batch. Every 
+ * instance references it's clip, which is evaluated in the 
+ * shader with anti-aliased edges. Instances that lie entirely 
+ * within the clip are not clipped in the shader at all and 
+ * instances outside of it are culled (the cull box is set to 
+ * the clipped area until the clip is popped).
+ *
+ * Clips apply to the instances of the batch and to static 
+ * batches while they are recorded (the clips are recorded 
+ * with the batch and move with it's offset). They do not 
+ * apply to static batches that are drawn or to recorders.
+ *
+ * @param[in] state The state of the library
+ * @param[in] pos The position of the clipped area
+ * @param[in] size The size of the clipped area
+ * @param[in] corner_radius The radius of the rounded 
+ * corners of the clipped area (0 for a rectangle)
+ * */
+void rn_push_clip(RnState* state, vec2s pos, vec2s size, float corner_radius);
+
+/*
+ * @brief Removes the clip that was pushed last 
+ * with 'rn_push_clip()' and restores the cull box.
+ *
+ * @param[in] state The state of the library
+ * */
+void rn_pop_clip(RnState* state);
+
 /*
  * @brief Clears the OpenGL color buffer and 
  * fills it with r, g, b and a float values
@@ -907,10 +2176,38 @@ void rn_begin(RnState* state);
  * */
 void rn_next_batch(RnState* state);
 
+/*
+ * @brief Adds an instance to the current batch.
+ *
+ * The batch is drawn with the cheapest shader that supports 
+ * the features of it's instances, so the shape of the instance 
+ * has to be set with 'rn_instance_set_shape()' or 
+ * 'rn_instance_set_paint()'. Shapes that are written to the 
+ * instance directly may be drawn as plain rectangles.
+ *
+ * @return The added instance or NULL if the instance 
+ * lies outside of the active cull box.
+ * */
 RnInstance* rn_add_instance(RnState* state,
     vec2s pos, vec2s size, float rotation, RnColor color,
     uint8_t tex_index);
 
+/*
+ * @brief Sets the shape of an instance and enables the 
+ * shader features that the shape requires for the batch.
+ *
+ * @param[in] state The state of the library
+ * @param[in] inst The instance (see 'rn_add_instance()')
+ * @param[in] shape The shape and line caps of the 
+ * instance (see RnInstanceShape)
+ * @param[in] border_color The color of the border
+ * @param[in] border_width The width of the border (px)
+ * @param[in] corner_radius The radius of the corners (px)
+ * */
+void rn_instance_set_shape(RnState* state, RnInstance* inst, uint8_t shape, 
+                           RnColor border_color, float border_width, 
+                           float corner_radius);
+
 /*
  * @brief Returns the index of 
  * a given texture within the current 
@@ -929,6 +2226,10 @@ uint8_t rn_tex_index_from_tex(RnState* state, RnTexture tex);
  * that adds a given texture to the 
  * textures rendered in the current batch.
  *
+ * If all texture slots of the batch are used, 
+ * the batch is flushed and the texture is added 
+ * to a new batch.
+ *
  * @param[in] state The state of the library 
  * @param[in] tex The texture to add to the render-batch 
  * to.
@@ -936,22 +2237,361 @@ uint8_t rn_tex_index_from_tex(RnState* state, RnTexture tex);
 void rn_add_tex_to_batch(RnState* state, RnTexture tex);
 
 /*
- * @brief Ends batch rendering operations with 
- * Runara.
- * 
- * This function flushes the batch renderer,
- * submitting all rendered content after 
- * 'rn_begin()' to be displayed.
+ * @brief Creates an empty static batch. 
+ * The batch is dirty until it is recorded.
  *
- * @param[in] state The state of the library 
- * to.
+ * @return The created static batch
  * */
-void rn_end_batch(RnState* state);
+RnStaticBatch* rn_batch_create(void);
 
-void rn_end(RnState* state);
+/*
+ * @brief Deletes the GPU buffers and deallocates 
+ * the memory of a static batch.
+ *
+ * @param[in] batch The static batch to free
+ * */
+void rn_batch_free(RnStaticBatch* batch);
 
 /*
- * @brief Reloads the glyph cache 
+ * @brief Marks the content of a static batch as changed, 
+ * so that the caller records it again.
+ *
+ * @param[in] batch The static batch to mark
+ * */
+void rn_batch_mark_dirty(RnStaticBatch* batch);
+
+/*
+ * @brief Begins recording a static batch. Everything that 
+ * is rendered until 'rn_batch_record_end()' is recorded 
+ * into the batch instead of being drawn. The previous 
+ * content of the batch is discarded.
+ *
+ * Instances that were rendered before are drawn first.
+ *
+ * @param[in] state The state of the library
+ * @param[in] batch The static batch to record
+ * */
+void rn_batch_record_begin(RnState* state, RnStaticBatch* batch);
+
+/*
+ * @brief Ends recording a static batch and uploads 
+ * it's instances to the GPU. The batch is no longer dirty.
+ *
+ * @param[in] state The state of the library
+ * @param[in] batch The recorded static batch
+ * */
+void rn_batch_record_end(RnState* state, RnStaticBatch* batch);
+
+/*
+ * @brief Draws a static batch with one draw call per 
+ * set of textures, without uploading it's instances.
+ *
+ * Glyph instances are updated automatically if the atlas 
+ * of their font was recreated since the batch was recorded.
+ *
+ * @param[in] state The state of the library
+ * @param[in] batch The static batch to draw
+ * @param[in] offset The offset added to the position 
+ * of every instance of the batch (px)
+ * */
+void rn_batch_draw(RnState* state, RnStaticBatch* batch, vec2s offset);
+
+/*
+ * @brief Creates a layer without content. 
+ * The layer is dirty until it is rendered.
+ *
+ * @return The created layer
+ * */
+RnLayer* rn_layer_create(void);
+
+/*
+ * @brief Returns the render target of a layer to the 
+ * pool and deallocates the memory of the layer.
+ *
+ * @param[in] state The state of the library
+ * @param[in] layer The layer to free
+ * */
+void rn_layer_free(RnState* state, RnLayer* layer);
+
+/*
+ * @brief Marks the content of a layer as changed, 
+ * so that the caller renders it again.
+ *
+ * @param[in] layer The layer to mark
+ * */
+void rn_layer_mark_dirty(RnLayer* layer);
+
+/*
+ * @brief Begins rendering into a layer. Everything that is 
+ * rendered until 'rn_end_layer()' is drawn into the texture of 
+ * the layer instead of the display, in the coordinate space 
+ * of the layer (the top-left corner of the layer is at 0, 0). 
+ * The previous content of the layer is discarded.
+ *
+ * Instances that were rendered before are drawn first. The 
+ * render target of the layer is taken from a pool of targets 
+ * with the same size class, so layers that change their size 
+ * slightly or are freed and created again do not allocate 
+ * new textures. Layers can be nested.
+ *
+ * The clips, the cull box and the scissor rectangle of 
+ * the display do not apply within the layer.
+ *
+ * @param[in] state The state of the library
+ * @param[in] layer The layer to render to
+ * @param[in] width The width of the layer (px)
+ * @param[in] height The height of the layer (px)
+ * */
+void rn_begin_layer(RnState* state, RnLayer* layer, uint32_t width, uint32_t height);
+
+/*
+ * @brief Ends rendering into a layer and continues rendering 
+ * to the display (or to the layer that was rendered to before). 
+ * The layer is no longer dirty.
+ *
+ * Recorders that were submitted while the 
+ * layer was rendered are drawn into it.
+ *
+ * @param[in] state The state of the library
+ * @param[in] layer The rendered layer
+ * */
+void rn_end_layer(RnState* state, RnLayer* layer);
+
+/*
+ * @brief Composites the content of a layer with a single 
+ * textured instance.
+ *
+ * The layer holds premultiplied colors, so the content 
+ * is faded with a color like (a, a, a, a).
+ *
+ * @param[in] state The state of the library
+ * @param[in] layer The layer to composite
+ * @param[in] pos The position of the top-left corner of the layer
+ * @param[in] color The color that the content is multiplied with
+ * */
+void rn_layer_render(RnState* state, RnLayer* layer, vec2s pos, RnColor color);
+
+/*
+ * @brief Renders a blurred copy of what was rendered behind 
+ * a rectangle (e.g. for frosted glass panels).
+ *
+ * Everything rendered before is drawn, then the area behind 
+ * the rectangle is captured and blurred with a dual Kawase 
+ * filter (downsampling and upsampling compute passes) at 
+ * reduced resolution. The result is composited as a textured 
+ * instance, so the cost scales with the blurred area.
+ *
+ * @param[in] state The state of the library
+ * @param[in] pos The position of the rectangle (px)
+ * @param[in] size The size of the rectangle (px)
+ * @param[in] radius The blur radius (px)
+ * @param[in] corner_radius The radius of the corners of the rectangle (px)
+ * @param[in] color The color that the blurred background is multiplied with
+ * */
+void rn_background_blur_render(
+    RnState* state, 
+    vec2s pos, 
+    vec2s size, 
+    float radius,
+    float corner_radius,
+    RnColor color);
+
+/*
+ * @brief Creates a recorder that records instances 
+ * independently of the batch renderer (e.g on a worker thread).
+ *
+ * @param[in] state The state of the library
+ *
+ * @return The created recorder
+ * */
+RnRecorder* rn_recorder_create(RnState* state);
+
+/*
+ * @brief Deallocates a recorder. The recorder must 
+ * not be submitted for the current frame.
+ *
+ * @param[in] rec The recorder to free
+ * */
+void rn_recorder_free(RnRecorder* rec);
+
+/*
+ * @brief Discards the content of a recorder and begins 
+ * recording with the current cull box of the state.
+ * May be called from any thread.
+ *
+ * @param[in] rec The recorder to begin
+ * */
+void rn_recorder_begin(RnRecorder* rec);
+
+/*
+ * @brief Records a rectangle. Works like 'rn_rect_render_ex()'.
+ * */
+void rn_recorder_rect_render_ex(
+    RnRecorder* rec, 
+    vec2s pos, 
+    vec2s size, 
+    float rotation_angle, 
+    RnColor color, 
+    RnColor border_color, 
+    float border_width, 
+    float corner_radius);
+
+/*
+ * @brief Records a rectangle. Works like 'rn_rect_render()'.
+ * */
+void rn_recorder_rect_render(
+    RnRecorder* rec, 
+    vec2s pos, 
+    vec2s size, 
+    RnColor color);
+
+/*
+ * @brief Records an image. Works like 'rn_image_render_ex()'.
+ * */
+void rn_recorder_image_render_ex(
+    RnRecorder* rec, 
+    vec2s pos, 
+    float rotation_angle,
+    RnColor color, 
+    RnTexture tex,
+    RnColor border_color,
+    float border_width, 
+    float corner_radius);
+
+/*
+ * @brief Records an image. Works like 'rn_image_render()'.
+ * */
+void rn_recorder_image_render(
+    RnRecorder* rec, 
+    vec2s pos, 
+    RnColor color, 
+    RnTexture tex);
+
+/*
+ * @brief Records a text. Works like 'rn_text_render()'.
+ *
+ * Texts whose shaping and glyphs are already cached are 
+ * laid out on the calling thread. Other texts are 
+ * shaped and laid out on the GL thread during the merge.
+ * */
+void rn_recorder_text_render(
+    RnRecorder* rec, 
+    const char* text, 
+    RnFont* font, 
+    vec2s pos, 
+    RnColor color);
+
+/*
+ * @brief Submits a recorder to be merged into the batch at 
+ * 'rn_end()'. Recorders are merged in the order in which 
+ * they are submitted, after everything rendered directly 
+ * during the frame. Must be called on the GL thread once 
+ * the recorder has finished recording.
+ *
+ * @param[in] state The state of the library
+ * @param[in] rec The recorder to submit
+ * */
+void rn_submit_recorder(RnState* state, RnRecorder* rec);
+
+/*
+ * @brief Returns the counters of the last frame that ended 
+ * with 'rn_end()'. GPU timings are only measured if 
+ * 'RnInitConfig.gpu_timing' was set and belong to an earlier 
+ * frame, as timer queries are read back without waiting.
+ *
+ * @param[in] state The state of the library
+ *
+ * @return The statistics of the last frame
+ * */
+RnFrameStats rn_get_frame_stats(const RnState* state);
+
+/*
+ * @brief Sets the layer that a recorder records new instances on 
+ * (see 'rn_set_layer()'). New recorders record on layer 0.
+ *
+ * @param[in] rec The recorder to set the layer of
+ * @param[in] layer The layer of new instances
+ * */
+void rn_recorder_set_layer(RnRecorder* rec, uint8_t layer);
+
+/*
+ * @brief Enables or disables reordering the instances of a 
+ * frame at 'rn_end()' to minimize draw calls. 
+ *
+ * While enabled, instances are captured instead of being 
+ * batched right away. At the end of the frame they are 
+ * sorted by their layer and grouped by the textures they 
+ * use. An instance is only drawn before another instance 
+ * that was rendered before it if they are on different 
+ * layers or their bounding boxes do not overlap, so the 
+ * result matches the order in which everything was rendered.
+ *
+ * Static batches drawn with 'rn_batch_draw()' are drawn 
+ * after all instances captured before them.
+ *
+ * @param[in] state The state of the library
+ * @param[in] reorder Whether to reorder instances
+ * */
+void rn_set_reorder(RnState* state, bool reorder);
+
+/*
+ * @brief Sets the layer that new instances are rendered on 
+ * while reordering (see 'rn_set_reorder()'). Higher layers 
+ * are drawn on top of lower layers, regardless of the order 
+ * in which they were rendered. Everything is rendered on 
+ * layer 0 by default.
+ *
+ * @param[in] state The state of the library
+ * @param[in] layer The layer of new instances
+ * */
+void rn_set_layer(RnState* state, uint8_t layer);
+
+/*
+ * @brief Enables or disables multi-draw mode. 
+ *
+ * In multi-draw mode, batches are not drawn when they are 
+ * flushed. Instead, they are queued as indirect draw commands, 
+ * each with a table that maps it's texture slots to the textures 
+ * of all queued draws. The queued draws are submitted with a 
+ * single 'glMultiDrawElementsIndirect()' call at 'rn_end()', 
+ * before static batches are drawn and when the instance buffer 
+ * or the texture slots of the queued draws are full.
+ *
+ * As the draws are submitted later, OpenGL state that is changed 
+ * between batches (e.g. the scissor rectangle) requires calling 
+ * 'rn_submit_draws()' first. Requires OpenGL 4.3.
+ *
+ * @param[in] state The state of the library
+ * @param[in] multi_draw Whether to queue batches
+ * */
+void rn_set_multi_draw(RnState* state, bool multi_draw);
+
+/*
+ * @brief Submits the draws that are queued in 
+ * multi-draw mode (see 'rn_set_multi_draw()'), 
+ * including the current batch.
+ *
+ * @param[in] state The state of the library
+ * */
+void rn_submit_draws(RnState* state);
+
+/*
+ * @brief Ends batch rendering operations with 
+ * Runara.
+ * 
+ * This function flushes the batch renderer,
+ * submitting all rendered content after 
+ * 'rn_begin()' to be displayed.
+ *
+ * @param[in] state The state of the library 
+ * to.
+ * */
+void rn_end_batch(RnState* state);
+
+void rn_end(RnState* state);
+
+/*
+ * @brief Reloads the glyph cache 
  * of a given font.
  * 
  * This function recreates the texture atlas 
@@ -1050,6 +2690,347 @@ void rn_rect_render_base_types(
     unsigned char color_b,
     unsigned char color_a);
 
+/*
+ * @brief Renders an anti-aliased line from 'p0' to 'p1' 
+ * as a single instance. The coverage of the line is 
+ * evaluated in the shader, lines thinner than a pixel 
+ * are faded instead of becoming thinner.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] p0 The start point of the line (px)
+ * @param[in] p1 The end point of the line (px)
+ * @param[in] width The width of the line (px)
+ * @param[in] color The color of the line 
+ * @param[in] cap The shape of both ends of the line
+ * */
+void rn_line_render_ex(
+    RnState* state, 
+    vec2s p0, 
+    vec2s p1, 
+    float width,
+    RnColor color,
+    RnLineCap cap);
+
+/*
+ * @brief Uses 'rn_line_render_ex()' with 'cap' 
+ * set to 'RN_LINE_CAP_BUTT'.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] p0 The start point of the line (px)
+ * @param[in] p1 The end point of the line (px)
+ * @param[in] width The width of the line (px)
+ * @param[in] color The color of the line 
+ * */
+void rn_line_render(
+    RnState* state, 
+    vec2s p0, 
+    vec2s p1, 
+    float width,
+    RnColor color);
+
+/*
+ * @brief Renders connected anti-aliased lines through 
+ * a list of points with one instance per segment.
+ *
+ * Segments are joined with round joins that overlap the 
+ * next segment, so joins are only correct for opaque colors: 
+ * translucent polylines are blended twice at their joins. 
+ * Such polylines can be rendered opaque into a layer and 
+ * composited with their alpha instead (see 'rn_layer_render()').
+ *
+ * @param[in] state The state of the library 
+ * @param[in] points The points of the polyline (px)
+ * @param[in] n_points The number of points
+ * @param[in] width The width of the lines (px)
+ * @param[in] color The color of the lines 
+ * @param[in] cap The shape of the ends of the polyline 
+ * (ignored if the polyline is closed)
+ * @param[in] closed Whether the last point is 
+ * connected to the first point
+ * */
+void rn_polyline_render_ex(
+    RnState* state, 
+    const vec2s* points, 
+    uint32_t n_points, 
+    float width,
+    RnColor color,
+    RnLineCap cap, 
+    bool closed);
+
+/*
+ * @brief Uses 'rn_polyline_render_ex()' with 'cap' set 
+ * to 'RN_LINE_CAP_BUTT' and 'closed' set to false.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] points The points of the polyline (px)
+ * @param[in] n_points The number of points
+ * @param[in] width The width of the lines (px)
+ * @param[in] color The color of the lines 
+ * */
+void rn_polyline_render(
+    RnState* state, 
+    const vec2s* points, 
+    uint32_t n_points, 
+    float width,
+    RnColor color);
+
+/*
+ * @brief Renders an anti-aliased circle as a single instance.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the circle (px)
+ * @param[in] radius The radius of the circle (px)
+ * @param[in] color The color of the circle 
+ * */
+void rn_circle_render(
+    RnState* state, 
+    vec2s center, 
+    float radius,
+    RnColor color);
+
+/*
+ * @brief Renders an anti-aliased ellipse with 
+ * an inner border as a single instance.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the ellipse (px)
+ * @param[in] radii The horizontal and vertical radius 
+ * of the ellipse (px)
+ * @param[in] color The color of the ellipse 
+ * @param[in] border_color The color of the border
+ * @param[in] border_width The width of the border (px)
+ * */
+void rn_ellipse_render_ex(
+    RnState* state, 
+    vec2s center, 
+    vec2s radii,
+    RnColor color,
+    RnColor border_color,
+    float border_width);
+
+/*
+ * @brief Uses 'rn_ellipse_render_ex()' with 
+ * 'border_color' set to 'RN_NO_COLOR' and 
+ * 'border_width' set to zero.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the ellipse (px)
+ * @param[in] radii The horizontal and vertical radius 
+ * of the ellipse (px)
+ * @param[in] color The color of the ellipse 
+ * */
+void rn_ellipse_render(
+    RnState* state, 
+    vec2s center, 
+    vec2s radii,
+    RnColor color);
+
+/*
+ * @brief Renders an anti-aliased arc of a circle as a single 
+ * instance. Angles are measured clockwise (on screen) from 
+ * the positive X axis.
+ *
+ * Arcs with a thickness of at least their radius are 
+ * pie segments, arcs thinner than a pixel are faded 
+ * instead of becoming thinner.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the circle (px)
+ * @param[in] radius The outer radius of the arc (px)
+ * @param[in] thickness The thickness of the arc 
+ * towards the center (px)
+ * @param[in] start_angle The angle at which the arc starts (radians)
+ * @param[in] sweep_angle The angle that the arc covers 
+ * (radians, negative values sweep counter-clockwise)
+ * @param[in] color The color of the arc 
+ * @param[in] cap The shape of both ends of the arc
+ * */
+void rn_arc_render_ex(
+    RnState* state, 
+    vec2s center, 
+    float radius,
+    float thickness,
+    float start_angle,
+    float sweep_angle,
+    RnColor color,
+    RnLineCap cap);
+
+/*
+ * @brief Uses 'rn_arc_render_ex()' with 'cap' 
+ * set to 'RN_LINE_CAP_BUTT'.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the circle (px)
+ * @param[in] radius The outer radius of the arc (px)
+ * @param[in] thickness The thickness of the arc 
+ * towards the center (px)
+ * @param[in] start_angle The angle at which the arc starts (radians)
+ * @param[in] sweep_angle The angle that the arc covers (radians)
+ * @param[in] color The color of the arc 
+ * */
+void rn_arc_render(
+    RnState* state, 
+    vec2s center, 
+    float radius,
+    float thickness,
+    float start_angle,
+    float sweep_angle,
+    RnColor color);
+
+/*
+ * @brief Uses 'rn_arc_render()' with a full turn 
+ * to render a ring as a single instance.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the ring (px)
+ * @param[in] radius The outer radius of the ring (px)
+ * @param[in] thickness The thickness of the ring 
+ * towards the center (px)
+ * @param[in] color The color of the ring 
+ * */
+void rn_ring_render(
+    RnState* state, 
+    vec2s center, 
+    float radius,
+    float thickness,
+    RnColor color);
+
+/*
+ * @brief Uses 'rn_arc_render()' with 'thickness' set 
+ * to 'radius' to render a pie segment as a single instance.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the circle (px)
+ * @param[in] radius The radius of the pie segment (px)
+ * @param[in] start_angle The angle at which the segment starts (radians)
+ * @param[in] sweep_angle The angle that the segment covers (radians)
+ * @param[in] color The color of the pie segment 
+ * */
+void rn_pie_render(
+    RnState* state, 
+    vec2s center, 
+    float radius,
+    float start_angle,
+    float sweep_angle,
+    RnColor color);
+
+/*
+ * @brief Creates a paint that fills instances with a linear 
+ * gradient. The points are relative to the size of the filled 
+ * instance, so that one paint fills instances of any size.
+ *
+ * Colors before the first and after the last stop are 
+ * extended. Paints persist until they are freed, instances 
+ * that use a paint only store it's ID.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] p0 The point at which the gradient starts (0 to 1)
+ * @param[in] p1 The point at which the gradient ends (0 to 1)
+ * @param[in] stops The colors of the gradient, sorted by their offset
+ * @param[in] n_stops The number of stops (up to RN_PAINT_MAX_STOPS)
+ *
+ * @return The ID of the paint
+ * */
+uint32_t rn_paint_create_linear(
+    RnState* state, 
+    vec2s p0, 
+    vec2s p1, 
+    const RnGradientStop* stops, 
+    uint32_t n_stops);
+
+/*
+ * @brief Creates a paint that fills instances with a radial 
+ * gradient. The center and the radii are relative to the 
+ * size of the filled instance (see 'rn_paint_create_linear()').
+ *
+ * @param[in] state The state of the library 
+ * @param[in] center The center of the gradient (0 to 1)
+ * @param[in] radii The horizontal and vertical radius at 
+ * which the gradient ends (0 to 1)
+ * @param[in] stops The colors of the gradient, sorted by their offset
+ * @param[in] n_stops The number of stops (up to RN_PAINT_MAX_STOPS)
+ *
+ * @return The ID of the paint
+ * */
+uint32_t rn_paint_create_radial(
+    RnState* state, 
+    vec2s center, 
+    vec2s radii, 
+    const RnGradientStop* stops, 
+    uint32_t n_stops);
+
+/*
+ * @brief Frees a paint, it's ID is reused by the 
+ * next created paint. Instances that use the paint 
+ * must be rendered before it is freed.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] paint The ID of the paint
+ * */
+void rn_paint_free(RnState* state, uint32_t paint);
+
+/*
+ * @brief Fills an instance with a paint instead of 
+ * it's color. The paint is multiplied with the 
+ * sampled texture of textured instances. The shape of 
+ * the instance is passed in as instances may live in 
+ * write-only mapped memory and are never read back.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] inst The instance (see 'rn_add_instance()')
+ * @param[in] paint The ID of the paint
+ * @param[in] shape The shape of the instance (see RnInstanceShape)
+ * */
+void rn_instance_set_paint(RnState* state, RnInstance* inst, uint32_t paint, 
+                           uint8_t shape);
+
+/*
+ * @brief Renders a rectangle that is filled with 
+ * a paint (see 'rn_rect_render_ex()').
+ *
+ * @param[in] state The state of the library 
+ * @param[in] pos The position of the rectangle (px)
+ * @param[in] size The size of the rectangle (px)
+ * @param[in] rotation_angle The rotation angle of the rectangle
+ * @param[in] paint The ID of the paint that fills the rectangle
+ * @param[in] border_color The color of the border
+ * @param[in] border_width The width of the border (px)
+ * @param[in] corner_radius The radius of the corners (px)
+ * */
+void rn_rect_render_paint(
+    RnState* state, 
+    vec2s pos, 
+    vec2s size, 
+    float rotation_angle,
+    uint32_t paint, 
+    RnColor border_color, 
+    float border_width,
+    float corner_radius);
+
+/*
+ * @brief Renders the blurred shadow of a rounded rectangle as a 
+ * single instance. The gaussian blur is evaluated in closed form 
+ * in the shader, so no shadow textures are needed.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] pos The position of the rectangle that casts the shadow (px)
+ * @param[in] size The size of the rectangle that casts the shadow (px)
+ * @param[in] radius The radius of the corners of the rectangle (px)
+ * @param[in] blur The blur radius of the shadow, twice the 
+ * standard deviation of the gaussian (px)
+ * @param[in] spread The distance by which the shadow 
+ * is expanded before it is blurred (px)
+ * @param[in] color The color of the shadow 
+ * */
+void rn_box_shadow_render(
+    RnState* state, 
+    vec2s pos, 
+    vec2s size, 
+    float radius,
+    float blur,
+    float spread,
+    RnColor color);
+
 /*
  * @brief Renders a given texture on 
  * a rectangle.
@@ -1064,7 +3045,9 @@ void rn_rect_render_base_types(
  * @param[in] color The color of the image 
  * @param[in] tex The texture to render 
  * @param[in] texcoords The texture coordinates 
- * to use to render the image (NDC).
+ * to use to render the image (NDC). The first element 
+ * is the minimum and the third the maximum corner. 
+ * NULL renders the whole texture.
  * @param[in] border_color The border color 
  * of the image (ignored if border_width <= 0).
  * @param[in] border_width The border width 
@@ -1154,6 +3137,31 @@ void rn_image_render_base_types(
     unsigned char color_a, 
     uint32_t tex_id, uint32_t tex_width, uint32_t tex_height);
 
+/*
+ * @brief Renders a sub-rectangle of a given texture 
+ * (e.g a sprite of a sprite sheet or a region of an atlas) 
+ * on a rectangle.
+ *
+ * Only the texels within 'src' are sampled, so many 
+ * sub-images of the same texture are rendered within 
+ * a single draw call.
+ *
+ * @param[in] state The state of the library 
+ * @param[in] pos The position of the image (px)
+ * @param[in] size The size of the rendered rectangle (px)
+ * @param[in] color The color of the image 
+ * @param[in] tex The texture to sample from 
+ * @param[in] src The rectangle within the texture to 
+ * render (in texels, minx/miny is the top left corner)
+ * */
+void rn_image_render_sub(
+    RnState* state, 
+    vec2s pos, 
+    vec2s size,
+    RnColor color, 
+    RnTexture tex,
+    RnAABB src);
+
 uint32_t rn_utf8_to_codepoint(const char *text, uint32_t cluster, uint32_t text_length);
 
 /*
@@ -1429,7 +3437,9 @@ RnGlyph rn_glyph_from_codepoint(
  * @param[in] str The string to get the harfbuzz data of 
  *
  * @return The retrieved harfbuzz data associated with the 
- * string.
+ * string. The data is owned by a bounded cache and is only 
+ * valid until the next text shaping call on this state, as 
+ * a later cache miss can evict it. Copy what you need to keep.
  * */
 RnHarfbuzzText* rn_hb_text_from_str(
     RnState* state, 
@@ -1437,6 +3447,22 @@ RnHarfbuzzText* rn_hb_text_from_str(
     const char* str
     );
 
+/*
+ * @brief Sets the number of bytes that shaped texts within 
+ * the harfbuzz cache may occupy.
+ *
+ * If the cache currently exceeds the new budget, the least 
+ * recently used texts are evicted immediately. 
+ * (Default is RN_HARFBUZZ_CACHE_BUDGET)
+ *
+ * @param[in] state The state of the library
+ * @param[in] budget The budget of the cache in bytes
+ * */
+void rn_set_harfbuzz_cache_budget(
+    RnState* state, 
+    size_t budget
+    );
+
 /*
  * @brief Sets the X coordinate from which to start culling. *
  *
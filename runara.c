@@ -22,12 +22,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 
 #ifdef _WIN32
+#include <direct.h>
 #define HOMEDIR "USERPROFILE"
+#define MKDIR(path) _mkdir(path)
 #else
 #define HOMEDIR (char*)"HOME"
+#define MKDIR(path) mkdir(path, 0755)
 #endif
 
 #define MAX(a, b) a > b ? a : b
@@ -40,25 +45,151 @@
 
 static uint32_t         shader_create(GLenum type, const char* src);
 static RnShader         shader_prg_create(const char* vert_src, const char* frag_src);
+static uint32_t         create_compute_program(const char* src);
 static void             shader_set_mat(RnShader prg, const char* name, mat4 mat); 
+static RnShader         shader_prg_create_cached(const RnInitConfig* config, 
+                                                 const char* vert_src, const char* frag_src);
+static bool             program_cache_path(const RnInitConfig* config, uint64_t source_hash, 
+                                           char* path, size_t path_len);
+static bool             program_cache_load(const char* path, uint64_t driver_hash, 
+                                           uint64_t source_hash, RnShader* o_prg);
+static void             program_cache_store(const char* path, uint64_t driver_hash, 
+                                            uint64_t source_hash, RnShader prg);
+static bool             make_dirs(char* path);
+static bool             freetype_init(RnState* state);
 static void             set_projection_matrix(RnState* state);
-static void             renderer_init(RnState* state);
-static void             renderer_flush(RnState* state);
+static void             renderer_init(RnState* state, RnGLLoader loader, const RnInitConfig* config);
+static bool             renderer_has_extension(const char* name);
+static void             renderer_load_proc(RnGLLoader loader, const char* name, void* o_proc);
+static void             renderer_delete_texture(RnState* state, uint32_t* id);
+static void             renderer_flush(RnState* state, RnFlushCause cause);
+static void             renderer_timer_begin(RnState* state);
+static void             renderer_timer_end(RnState* state);
+static void             renderer_timer_end_frame(RnState* state);
+static void             renderer_queue_draw(RnState* state);
+static void             renderer_submit_draws(RnState* state);
+static uint32_t         renderer_create_vao(RnState* state, uint32_t vbo_instances);
+static void             renderer_bind_textures(RnState* state, const RnTexture* textures, uint32_t count);
+static void             renderer_create_variants(RnState* state, const RnInitConfig* config, 
+                                                 const char* vert_header, 
+                                                 const char** vert_parts, uint32_t n_vert_parts, 
+                                                 const char** frag_parts, uint32_t n_frag_parts);
+static void             renderer_use_variant(RnState* state, uint32_t features, uint32_t tex_count);
+static void             renderer_set_offset(RnState* state, vec2s offset);
+static uint32_t         instance_features(const RnInstance* inst);
+static void             renderer_setup_full_attribs(void);
+static void             renderer_setup_compact_attribs(void);
+static uint32_t         renderer_pack_instances(const RnInstance* src, uint32_t count, 
+                                                RnInstanceCompact* dst, RnInstanceExt* ext);
 static void             renderer_begin(RnState* state);
-
-static void             create_font_atlas(RnFont* font);
-
-
-static RnGlyph*         get_glyph_from_codepoint(RnGlyphCache cache, RnFont font, uint64_t codepoint);
-static RnGlyph          load_glyph_from_codepoint(RnFont* font, uint64_t codepoint, bool colored);
-static RnGlyph          load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint);
-static RnGlyph          get_glyph_from_cache(RnGlyphCache* cache, RnFont* font, uint64_t codepoint);
-
-static RnHarfbuzzText*  get_hb_text_from_str(RnHarfbuzzCache cache, RnFont font, const char* str);
+static void             renderer_reset_textures(RnState* state);
+static void             renderer_upload_clips(RnState* state, const RnClipData* clips, uint32_t count);
+static void             renderer_reset_clips(RnState* state);
+static uint8_t          renderer_clip_slot(RnState* state, uint32_t clip);
+static uint8_t          clip_add_to_table(RnClipStack* stack, uint32_t clip, bool only);
+static uint32_t         layer_size_class(uint32_t size);
+static RnRenderTarget   renderer_acquire_target(RnState* state, uint32_t width, uint32_t height);
+static void             renderer_release_target(RnState* state, RnRenderTarget* target);
+static void             renderer_trim_targets(RnState* state);
+static void             renderer_create_blur_program(RnState* state);
+static void             renderer_blur_pass(RnState* state, const RnRenderTarget* src, 
+                                           uint32_t src_w, uint32_t src_h, 
+                                           const RnRenderTarget* dst, uint32_t dst_w, 
+                                           uint32_t dst_h, float offset, bool upsample);
+static uint32_t         clip_for_bounds(const RnClipStack* stack, RnAABB bounds);
+static void             renderer_next_region(RnState* state);
+static bool             renderer_upload_map(RnState* state);
+static uint32_t         renderer_upload_alloc(RnState* state, uint32_t size);
+static bool             renderer_grow(RnState* state);
+static void             renderer_free(RnState* state);
+
+static void*            array_reserve(void* data, uint32_t* cap, uint32_t needed, size_t elem_size);
+static void             static_batch_reserve(RnState* state, RnStaticBatch* batch);
+static void             static_batch_add_segment(RnState* state, RnStaticBatch* batch);
+static void             static_batch_add_glyph(RnStaticBatch* batch, uint32_t instance, uint64_t key);
+static vec4s            glyph_uv_clip(const RnGlyphRenderData* glyph, vec4s uv);
+static vec4s            glyph_ref_uv(const RnStaticGlyphRef* ref, const RnGlyph* glyph);
+static void             static_batch_patch_glyphs(RnState* state, RnStaticBatch* batch);
+static void             static_batch_upload(RnState* state, RnStaticBatch* batch);
+
+static void             create_font_atlas(RnState* state, RnFont* font);
+static bool             grow_font_atlas(RnState* state, RnFont* font);
+
+
+static uint64_t         glyph_cache_key(uint32_t font_id, uint64_t codepoint);
+static uint32_t         glyph_cache_probe(const RnGlyphCache* cache, uint64_t key);
+static void             glyph_cache_grow(RnGlyphCache* cache);
+static uint32_t         glyph_cache_insert(RnGlyphCache* cache, uint64_t key, RnGlyph glyph);
+static void             glyph_cache_set(RnGlyphCache* cache, uint32_t slot, RnGlyph glyph);
+static void             glyph_cache_remove_font(RnGlyphCache* cache, uint32_t font_id);
+static void             glyph_cache_free(RnGlyphCache* cache);
+
+static int32_t          get_glyph_from_codepoint(const RnGlyphCache* cache, RnFont font, uint64_t codepoint);
+static RnGlyph          load_glyph_from_codepoint(RnState* state, RnFont* font, uint64_t codepoint, bool colored);
+static RnGlyph          load_colr_glyph_from_codepoint(RnState* state, RnFont* font, uint64_t codepoint);
+static uint32_t         get_glyph_from_cache(RnState* state, RnFont* font, uint64_t codepoint);
+static void             glyph_render(RnState* state, const RnGlyphRenderData* glyph, 
+                                     uint32_t atlas_id, uint64_t key, vec2s pos, RnColor color);
+static void             set_instance_shape(RnInstance* inst, RnColor border_color, 
+                                           float border_width, float corner_radius);
+static void             set_instance_uv(RnInstance* inst, vec4s uv);
+static bool             cull_rect(RnState* state, vec2s* pos, vec2s* size, float rotation, vec4s* uv);
+static void             fill_instance(RnInstance* inst, vec2s pos, vec2s size, float rotation, 
+                                      RnColor color, uint8_t tex_index);
+static bool             text_layout(RnState* state, RnRecorder* rec, RnHarfbuzzText* hb_text, 
+                                    const char* text, RnFont* font, vec2s pos, RnColor color, 
+                                    float line_height, bool render, RnTextProps* props);
+static RnInstance*      recorder_push(RnRecorder* rec, vec2s pos, vec2s size, float rotation, 
+                                      RnColor color, uint32_t tex_id, uint32_t clip);
+static void             recorder_glyph_render(RnRecorder* rec, const RnGlyphRenderData* glyph, 
+                                              uint32_t atlas_id, uint64_t key, vec2s pos, RnColor color);
+static void             recorder_add_glyph(RnRecorder* rec, uint32_t instance, uint64_t key, 
+                                           vec4s uv_clip);
+static void             recorder_patch_glyphs(RnState* state, RnRecorder* rec);
+static void             recorder_emit_instance(RnState* state, RnRecorder* rec, uint32_t i);
+static void             recorder_merge(RnState* state, RnRecorder* rec);
+static void             renderer_merge_recorders(RnState* state, uint32_t first);
+static void             renderer_emit_reordered(RnState* state);
+static RnAABB           rect_bounds(vec2s pos, vec2s size, float rotation);
+static bool             cull_rect_box(vec2s start, vec2s end, vec2s* pos, vec2s* size, float rotation, 
+                                      vec4s* uv, uint32_t* culled, uint32_t* clipped);
+static RnInstance*      push_instance(RnState* state, vec2s pos, vec2s size, float rotation, 
+                                      RnColor color, uint8_t tex_index);
+static RnInstance*      push_instance_clipped(RnState* state, vec2s pos, vec2s size, float rotation, 
+                                              RnColor color, uint8_t tex_index, uint32_t clip, 
+                                              uint8_t* o_clip_slot);
+static RnInstance*      line_instance(RnState* state, vec2s p0, vec2s p1, float width, 
+                                      RnColor color, uint8_t caps);
+static RnInstance*      ellipse_instance(RnState* state, vec2s center, vec2s radii, 
+                                         RnColor color, uint8_t shape);
+static uint32_t         paint_create(RnState* state, RnPaintType type, vec2s p0, vec2s p1, 
+                                     const RnGradientStop* stops, uint32_t n_stops);
+static void             renderer_bind_paints(RnState* state);
+static RnInstance*      add_textured_instance(RnState* state, vec2s pos, vec2s size, float rotation,
+                                              RnColor color, RnTexture tex, vec4s uv, bool clip);
+static RnInstance*      push_textured_instance(RnState* state, vec2s pos, vec2s size, float rotation,
+                                               RnColor color, RnTexture tex, vec4s uv);
+
+static RnHarfbuzzText*  hb_cache_find_key(const RnHarfbuzzCache* cache, RnHarfbuzzKey key);
+static uint32_t         hb_cache_probe(const RnHarfbuzzCache* cache, uint64_t hash, 
+                                       uint32_t font_id, const char* str, uint32_t len);
+static void             hb_cache_grow(RnHarfbuzzCache* cache);
+static void             hb_cache_touch(RnHarfbuzzCache* cache, RnHarfbuzzText* text);
+static void             hb_cache_remove(RnHarfbuzzCache* cache, RnHarfbuzzText* text);
+static void             hb_cache_trim(RnHarfbuzzCache* cache);
+static void             hb_cache_account(RnHarfbuzzCache* cache, RnHarfbuzzText* text);
+static void             hb_cache_remove_font(RnHarfbuzzCache* cache, uint32_t font_id);
+static void             hb_cache_free(RnHarfbuzzCache* cache);
+
+static void             hb_text_shape(RnHarfbuzzText* text, RnFont font);
+static size_t           hb_text_bytes(const RnHarfbuzzText* text);
+static void             hb_text_free(RnHarfbuzzText* text);
+
+static RnHarfbuzzText*  get_hb_text_from_str(const RnHarfbuzzCache* cache, RnFont font, const char* str);
 static RnHarfbuzzText*  load_hb_text_from_str(RnFont font, const char* str);
 static RnHarfbuzzText*  get_hb_text_from_cache(RnHarfbuzzCache* cache, RnFont font, const char* str);
 
-static uint64_t         djb2_hash(const unsigned char *str);
+static uint64_t         djb2_hash(const unsigned char *str, uint32_t len);
 
 // --- Static Functions ---
 
@@ -78,7 +209,8 @@ shader_create(GLenum type, const char* src) {
   glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
 
   if(!compiled) {
-    RN_ERROR("Failed to compile %s shader.", type == GL_VERTEX_SHADER ? "vertex" : "fragment");
+    RN_ERROR("Failed to compile %s shader.", type == GL_VERTEX_SHADER ? "vertex" : 
+             (type == GL_FRAGMENT_SHADER ? "fragment" : "compute"));
     char info[512];
     glGetShaderInfoLog(shader, 512, NULL, info);
     RN_INFO("%s", info);
@@ -102,6 +234,10 @@ shader_prg_create(const char* vert_src, const char* frag_src) {
   prg.id = glCreateProgram();
   glAttachShader(prg.id, vertex_shader);
   glAttachShader(prg.id, fragment_shader);
+  // Allow the program binary cache to retrieve the linked program
+  if(GLAD_GL_VERSION_4_1) {
+    glProgramParameteri(prg.id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
   glLinkProgram(prg.id);
 
   // Checking for linking errors
@@ -126,37 +262,244 @@ shader_prg_create(const char* vert_src, const char* frag_src) {
   return prg;
 }
 
-static uint32_t create_compute_program(const char* src) {
-  GLuint cs = glCreateShader(GL_COMPUTE_SHADER);
-  glShaderSource(cs, 1, &src, NULL);
-  glCompileShader(cs);
-  GLint ok=0; glGetShaderiv(cs, GL_COMPILE_STATUS, &ok);
-  if(!ok){ 
-    GLint len=0; 
-    glGetShaderiv(cs, GL_INFO_LOG_LENGTH, &len);
-    char* log=(char*)malloc(len?len:1); 
-    if(len) 
-      glGetShaderInfoLog(cs,len,NULL,log); 
-  }
-  GLuint prog = glCreateProgram();
+/* This function creates an OpenGL program 
+ * consisting of a compute shader. 
+ * */
+uint32_t 
+create_compute_program(const char* src) {
+  uint32_t cs = shader_create(GL_COMPUTE_SHADER, src);
+
+  uint32_t prog = glCreateProgram();
   glAttachShader(prog, cs);
   glLinkProgram(prog);
   glDeleteShader(cs);
-  glGetProgramiv(prog, GL_LINK_STATUS, &ok);
-  if(!ok){ 
-    GLint len=0; 
-    glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &len);
-    char* log=(char*)malloc(len?len:1); 
-    if(len) 
-      glGetProgramInfoLog(prog,len,NULL,log);
-    fprintf(stderr,"[Compute] link error:\n%s\n", log); free(log);
+
+  // Checking for linking errors
+  int32_t linked;
+  glGetProgramiv(prog, GL_LINK_STATUS, &linked);
+  if(!linked) {
+    RN_ERROR("Failed to link compute program.");
+    char info[512];
+    glGetProgramInfoLog(prog, 512, NULL, info);
+    RN_INFO("%s", info);
   }
   return prog;
 }
 
+/* This function creates a shader program from the program 
+ * binary cache and falls back to compiling it from source 
+ * if there is no cached binary of the current driver. 
+ * */
+RnShader
+shader_prg_create_cached(const RnInitConfig* config, 
+                         const char* vert_src, const char* frag_src) {
+  int32_t n_formats = 0;
+  if(GLAD_GL_VERSION_4_1) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+  }
+  if(config->disable_program_cache || n_formats <= 0) {
+    return shader_prg_create(vert_src, frag_src);
+  }
+
+  // Binaries are only valid for the driver that 
+  // linked them and for the same shader sources
+  char driver[1024];
+  snprintf(driver, sizeof(driver), "%s\n%s\n%s", 
+           (const char*)glGetString(GL_VENDOR), 
+           (const char*)glGetString(GL_RENDERER), 
+           (const char*)glGetString(GL_VERSION));
+  uint64_t driver_hash = djb2_hash((const unsigned char*)driver, strlen(driver));
+  uint64_t source_hash = 
+    djb2_hash((const unsigned char*)vert_src, strlen(vert_src)) * 31 + 
+    djb2_hash((const unsigned char*)frag_src, strlen(frag_src));
+
+  char path[1024];
+  if(!program_cache_path(config, source_hash, path, sizeof(path))) {
+    return shader_prg_create(vert_src, frag_src);
+  }
+
+  RnShader prg;
+  if(program_cache_load(path, driver_hash, source_hash, &prg)) {
+    return prg;
+  }
+
+  prg = shader_prg_create(vert_src, frag_src);
+  program_cache_store(path, driver_hash, source_hash, prg);
+  return prg;
+}
+
+/* This function writes the path of the cached program binary 
+ * of the given shader sources into 'path'. 
+ * */
+bool
+program_cache_path(const RnInitConfig* config, uint64_t source_hash, 
+                   char* path, size_t path_len) {
+  char default_dir[1024];
+  const char* dir = config->program_cache_dir;
+  if(!dir) {
+    const char* xdg_cache = getenv("XDG_CACHE_HOME");
+    const char* home = getenv(HOMEDIR);
+    int32_t len;
+    if(xdg_cache && *xdg_cache) {
+      len = snprintf(default_dir, sizeof(default_dir), "%s/runara", xdg_cache);
+    } else if(home && *home) {
+      len = snprintf(default_dir, sizeof(default_dir), "%s/.cache/runara", home);
+    } else {
+      return false;
+    }
+    if(len < 0 || (size_t)len >= sizeof(default_dir)) return false;
+    dir = default_dir;
+  }
+
+  int32_t len = snprintf(path, path_len, "%s/program-%016llx.bin", 
+                         dir, (unsigned long long)source_hash);
+  return len > 0 && (size_t)len < path_len;
+}
+
+/* This function loads a cached program binary. Returns false if 
+ * the file is missing, was written for another driver or 
+ * other shader sources or if the driver rejects the binary. 
+ * */
+bool
+program_cache_load(const char* path, uint64_t driver_hash, 
+                   uint64_t source_hash, RnShader* o_prg) {
+  FILE* file = fopen(path, "rb");
+  if(!file) return false;
+
+  RnProgramCacheHeader header;
+  bool valid = 
+    fread(&header, sizeof(header), 1, file) == 1 &&
+    header.magic == RN_PROGRAM_CACHE_MAGIC && 
+    header.version == RN_PROGRAM_CACHE_VERSION &&
+    header.driver_hash == driver_hash && 
+    header.source_hash == source_hash && 
+    header.size > 0;
+
+  void* binary = NULL;
+  if(valid) {
+    binary = malloc(header.size);
+    if(!binary) {
+      RN_ERROR("Failed to allocate memory for program binary.");
+      exit(EXIT_FAILURE);
+    }
+    valid = fread(binary, header.size, 1, file) == 1;
+  }
+  fclose(file);
+  if(!valid) {
+    free(binary);
+    return false;
+  }
+
+  o_prg->id = glCreateProgram();
+  glProgramBinary(o_prg->id, header.format, binary, header.size);
+  free(binary);
+
+  // Drivers reject binaries of other driver builds
+  int32_t linked;
+  glGetProgramiv(o_prg->id, GL_LINK_STATUS, &linked);
+  if(!linked) {
+    glDeleteProgram(o_prg->id);
+    return false;
+  }
+  return true;
+}
+
+/* This function writes the binary of a linked program 
+ * to the program binary cache. 
+ * */
+void
+program_cache_store(const char* path, uint64_t driver_hash, 
+                    uint64_t source_hash, RnShader prg) {
+  int32_t size = 0;
+  glGetProgramiv(prg.id, GL_PROGRAM_BINARY_LENGTH, &size);
+  if(size <= 0) return;
+
+  void* binary = malloc(size);
+  if(!binary) {
+    RN_ERROR("Failed to allocate memory for program binary.");
+    exit(EXIT_FAILURE);
+  }
+  int32_t written = 0;
+  uint32_t format = 0;
+  glGetProgramBinary(prg.id, size, &written, &format, binary);
+  if(written <= 0) {
+    free(binary);
+    return;
+  }
+
+  RnProgramCacheHeader header = {
+    .magic = RN_PROGRAM_CACHE_MAGIC,
+    .version = RN_PROGRAM_CACHE_VERSION,
+    .driver_hash = driver_hash,
+    .source_hash = source_hash,
+    .format = format,
+    .size = written
+  };
+
+  // Create the cache directory
+  char dir[1024];
+  snprintf(dir, sizeof(dir), "%s", path);
+  char* sep = strrchr(dir, '/');
+  if(sep) *sep = '\0';
+
+  // Write to a temporary file first, so that processes starting 
+  // concurrently never read a partially written binary
+  char tmp_path[1040];
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+  FILE* file = make_dirs(dir) ? fopen(tmp_path, "wb") : NULL;
+  if(!file) {
+    RN_WARN("Failed to write program binary cache '%s'.", path);
+    free(binary);
+    return;
+  }
+  bool stored = 
+    fwrite(&header, sizeof(header), 1, file) == 1 &&
+    fwrite(binary, written, 1, file) == 1;
+  stored = fclose(file) == 0 && stored;
+  free(binary);
+
+#ifdef _WIN32
+  // rename() does not replace existing files on windows
+  if(stored) remove(path);
+#endif
+  if(!stored || rename(tmp_path, path) != 0) {
+    RN_WARN("Failed to write program binary cache '%s'.", path);
+    remove(tmp_path);
+  }
+}
+
+/* This function creates a directory and all of 
+ * its missing parent directories. 
+ * */
+bool
+make_dirs(char* path) {
+  for(char* c = path + 1; *c; c++) {
+    if(*c != '/') continue;
+    *c = '\0';
+    bool made = MKDIR(path) == 0 || errno == EEXIST;
+    *c = '/';
+    if(!made) return false;
+  }
+  return MKDIR(path) == 0 || errno == EEXIST;
+}
+
+/* This function initializes FreeType when the 
+ * first font is loaded. 
+ * */
+bool
+freetype_init(RnState* state) {
+  if(state->ft) return true;
+  if(FT_Init_FreeType(&state->ft) != 0) {
+    RN_ERROR("Failed to initialize FreeType.");
+    state->ft = NULL;
+    return false;
+  }
+  return true;
+}
+
 void 
 shader_set_mat(RnShader prg, const char* name, mat4 mat) {
-  glUniformMatrix4fv(glGetUniformLocation(prg.id, name), 1, GL_FALSE, mat[0]);
+  glProgramUniformMatrix4fv(prg.id, glGetUniformLocation(prg.id, name), 1, GL_FALSE, mat[0]);
 }
 
 /* This function uploads the orthographic projection 
@@ -166,31 +509,80 @@ shader_set_mat(RnShader prg, const char* name, mat4 mat) {
 void
 set_projection_matrix(RnState* state) {
   mat4 orthoMatrix = GLM_MAT4_IDENTITY_INIT;
+  // Layers are rendered upside down, so that their first row 
+  // is the top row like within textures loaded from images
+  float h = (float)state->render.render_h;
   glm_ortho(0.0f, (float)state->render.render_w,
-            (float)state->render.render_h, 0.0f, 
+            state->render.layer ? 0.0f : h, 
+            state->render.layer ? h : 0.0f, 
             -1.0f, 1.0f,
             orthoMatrix);
 
-  // Upload the matrix to the shader
-  shader_set_mat(state->render.shader, "u_proj", orthoMatrix);
+  // Upload the matrix to every variant of the shader
+  for(uint32_t i = 0; i < RN_SHADER_VARIANT_COUNT; i++) {
+    shader_set_mat(state->render.variants[i].shader, "u_proj", orthoMatrix);
+  }
 }
 
 /* This function sets up OpenGL buffer object and shaders 
  * and sets up the state to use the batch rendering pipeline. 
  * */
 void
-renderer_init(RnState* state) {
+renderer_init(RnState* state, RnGLLoader loader, const RnInitConfig* config) {
 
   // OpenGL Setup 
   glEnable(GL_BLEND);
   glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
-  // Allocate memory for vertices
+  // Use bindless textures if the driver supports them, so 
+  // that far more textures fit into a single batch. 
+  // The entry points are not part of glad's core profile.
+  state->render.bindless = false;
+  if(loader && renderer_has_extension("GL_ARB_bindless_texture")) {
+    renderer_load_proc(loader, "glGetTextureHandleARB", 
+                       &state->render.get_texture_handle);
+    renderer_load_proc(loader, "glIsTextureHandleResidentARB", 
+                       &state->render.is_texture_handle_resident);
+    renderer_load_proc(loader, "glMakeTextureHandleResidentARB", 
+                       &state->render.make_texture_handle_resident);
+    renderer_load_proc(loader, "glMakeTextureHandleNonResidentARB", 
+                       &state->render.make_texture_handle_non_resident);
+    state->render.bindless = 
+      state->render.get_texture_handle && 
+      state->render.is_texture_handle_resident &&
+      state->render.make_texture_handle_resident &&
+      state->render.make_texture_handle_non_resident;
+  }
+  state->render.max_textures = state->render.bindless ? 
+    RN_MAX_BINDLESS_TEX_COUNT_BATCH : RN_MAX_TEX_COUNT_BATCH;
+
+  if(state->render.bindless) {
+    glCreateBuffers(1, &state->render.ssbo_tex_handles);
+    glNamedBufferData(state->render.ssbo_tex_handles, 
+                      sizeof(uint64_t) * RN_MAX_BINDLESS_TEX_COUNT_BATCH, NULL, GL_DYNAMIC_DRAW);
+  }
+
+  state->render.tex_count = 0;
+  state->render.tex_index = 0;
+  memset(state->render.tex_slots, 0, sizeof(state->render.tex_slots));
+  state->render.tex_slots_gen = 1;
+
+  state->render.clips = (RnClipStack){0};
+  state->render.clips.gen = 1;
+  glCreateBuffers(1, &state->render.clips.ssbo);
+
+  state->render.paints = (RnPaintTable){0};
+  glCreateBuffers(1, &state->render.paints.ssbo_paints);
+  glCreateBuffers(1, &state->render.paints.ssbo_stops);
+
   state->render.n_instances = 0;
-  state->render.instances = (RnInstance*)calloc(RN_MAX_RENDER_BATCH, sizeof(RnInstance) );
+  state->render.batch_start = 0;
+  state->render.region = 0;
+  memset(state->render.region_fences, 0, sizeof(state->render.region_fences));
 
-  glGenVertexArrays(1, &state->render.vao);
-  glBindVertexArray(state->render.vao);
+  // Stream instances through persistently mapped 
+  // memory if buffer storage is supported
+  state->render.streaming = state->render.streaming && GLAD_GL_VERSION_4_4;
 
   RnVertex quad_vertices[4] = {
     {{0.0f, 0.0f}, {0.0f, 0.0f}},
@@ -200,122 +592,602 @@ renderer_init(RnState* state) {
   };
   uint32_t quad_indices[6] = {0, 1, 2, 2, 3, 0};
 
-  glGenBuffers(1, &state->render.vbo_static);
-  glBindBuffer(GL_ARRAY_BUFFER, state->render.vbo_static);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
-
-  glGenBuffers(1, &state->render.ibo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state->render.ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(quad_indices), quad_indices, GL_STATIC_DRAW);
-
-  // --- Vertex layout for static quad (binding 0) ---
-  glEnableVertexAttribArray(0); // a_local_pos
-  glVertexAttribPointer(
-    0, 2, GL_FLOAT, GL_FALSE, sizeof(RnVertex), (void*)offsetof(RnVertex, pos));
-
-  glEnableVertexAttribArray(1); // a_texcoord
-  glVertexAttribPointer(
-    1, 2, GL_FLOAT, GL_FALSE, sizeof(RnVertex), (void*)offsetof(RnVertex, texcoord));
+  glCreateBuffers(1, &state->render.vbo_static);
+  glNamedBufferData(state->render.vbo_static, sizeof(quad_vertices), quad_vertices, GL_STATIC_DRAW);
+
+  glCreateBuffers(1, &state->render.ibo);
+  glNamedBufferData(state->render.ibo, sizeof(quad_indices), quad_indices, GL_STATIC_DRAW);
+
+  bool compact = state->render.format == RN_INSTANCE_FORMAT_COMPACT;
+  state->render.instance_size = compact ? sizeof(RnInstanceCompact) : sizeof(RnInstance);
+  state->render.packed = NULL;
+  state->render.ext = NULL;
+  if(compact) {
+    // Compact instances are staged as full instances and 
+    // quantized on flush, their extended parameters 
+    // live in a shader storage buffer.
+    state->render.ext = (RnInstanceExt*)malloc(sizeof(RnInstanceExt) * state->render.capacity);
+    if(!state->render.ext) {
+      RN_ERROR("Failed to allocate memory for extended instance parameters.");
+      exit(EXIT_FAILURE);
+    }
+    glCreateBuffers(1, &state->render.ssbo_ext);
+    glNamedBufferData(state->render.ssbo_ext, 
+                      sizeof(RnInstanceExt) * state->render.capacity, NULL, GL_STREAM_DRAW);
+  }
 
   glGenBuffers(1, &state->render.vbo_instances);
   glBindBuffer(GL_ARRAY_BUFFER, state->render.vbo_instances);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(RnInstance) * RN_MAX_RENDER_BATCH, NULL, GL_DYNAMIC_DRAW); 
-
-  GLsizei stride = sizeof(RnInstance);
-  uintptr_t offset = 0;
-
-  // i_pos : vec2
-  glEnableVertexAttribArray(2);
-  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-  glVertexAttribDivisor(2, 1);
-  offset += sizeof(float) * 2;
-
-  // i_size : vec2
-  glEnableVertexAttribArray(3);
-  glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-  glVertexAttribDivisor(3, 1);
-  offset += sizeof(float) * 2;
-
-  // i_rotation : float
-  glEnableVertexAttribArray(4);
-  glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)offset);
-  glVertexAttribDivisor(4, 1);
-  offset += sizeof(float) * 1;
-
-  // i_color : vec4 (u8 normalized)
-  glEnableVertexAttribArray(5);
-  glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offset);
-  glVertexAttribDivisor(5, 1);
-  offset += sizeof(uint8_t) * 4;
-
-  // i_tex_index : uint (integer attribute)
-  glEnableVertexAttribArray(6);
-  glVertexAttribIPointer(6, 1, GL_UNSIGNED_BYTE, stride, (void*)offset);
-  glVertexAttribDivisor(6, 1);
+  state->render.vbo_ptr = NULL;
+  if(state->render.streaming) {
+    // Allocate one region per frame in flight and keep 
+    // the whole buffer mapped for the lifetime of the renderer
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = (GLsizeiptr)state->render.instance_size * state->render.capacity * RN_STREAM_REGIONS;
+    glBufferStorage(GL_ARRAY_BUFFER, size, NULL, flags);
+    state->render.vbo_ptr = glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    if(!state->render.vbo_ptr) {
+      // The storage of the buffer is immutable, so
+      // instances are uploaded through a new buffer
+      RN_WARN("Failed to map the instance buffer, uploading instances with glBufferSubData.");
+      glDeleteBuffers(1, &state->render.vbo_instances);
+      glGenBuffers(1, &state->render.vbo_instances);
+      glBindBuffer(GL_ARRAY_BUFFER, state->render.vbo_instances);
+      state->render.streaming = false;
+    }
+  }
+  if(state->render.streaming) {
+    state->render.instances = compact ? 
+      (RnInstance*)calloc(state->render.capacity, sizeof(RnInstance)) : 
+      (RnInstance*)state->render.vbo_ptr;
+  } else {
+    // Allocate memory for vertices
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)state->render.instance_size * state->render.capacity, 
+                 NULL, GL_DYNAMIC_DRAW); 
+    state->render.instances = (RnInstance*)calloc(state->render.capacity, sizeof(RnInstance) );
+    if(compact) {
+      state->render.packed = (RnInstanceCompact*)calloc(state->render.capacity, sizeof(RnInstanceCompact));
+    }
+  }
 
   glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  state->render.vao = renderer_create_vao(state, state->render.vbo_instances);
 
   /* Shader source code*/
 
-  // Vertex shader
-  const char* vert_src =
-    "#version 460 core\n"
+  // Vertex shader (RN_COMPACT selects the compact instance layout, RN_TEXTURED, 
+  // RN_SHAPED, RN_ROTATED and RN_CLIPPED the features of the variant). The 
+  // source is split into parts that are joined when the variants are created, 
+  // as string literals are limited to 4095 characters in ISO C.
+  const char* vert_src_decls =
     "layout(location = 0) in vec2 a_local_pos;\n"
     "layout(location = 1) in vec2 a_texcoord;\n"
     "\n"
     "layout(location = 2) in vec2 i_pos;\n"
     "layout(location = 3) in vec2 i_size;\n"
-    "layout(location = 4) in float i_rotation;\n"
     "layout(location = 5) in vec4 i_color;\n"
     "layout(location = 6) in int i_tex_index;\n"
+    "layout(location = 7) in vec4 i_uv;\n"
+    "layout(location = 10) in uint i_clip;\n"
+    "#ifdef RN_COMPACT\n"
+    "layout(location = 8) in uint i_ext;\n"
+    "\n"
+    "struct RnInstanceExt {\n"
+    "    float rotation;\n"
+    "    float corner_radius;\n"
+    "    float border_width;\n"
+    "    uint border_color;\n"
+    "    uint shape;\n"
+    "};\n"
+    "layout(std430, binding = 1) readonly buffer RnInstanceExts {\n"
+    "    RnInstanceExt u_ext[];\n"
+    "};\n"
+    "#else\n"
+    "layout(location = 4) in float i_rotation;\n"
+    "layout(location = 8) in vec2 i_shape;\n"
+    "layout(location = 9) in vec4 i_border_color;\n"
+    "layout(location = 11) in uint i_shape_type;\n"
+    "#endif\n"
     "\n"
     "uniform mat4 u_proj;\n"
+    "uniform vec2 u_offset;\n"
+    "\n"
+    "// Texture and clip tables of the draws in multi-draw mode\n"
+    "layout(std430, binding = 2) readonly buffer RnDrawTables {\n"
+    "    uint u_draw_tables[];\n"
+    "};\n"
+    "uniform bool u_multi_draw;\n"
+    "\n"
+    "#ifdef RN_CLIPPED\n"
+    "struct RnClip {\n"
+    "    vec4 rect;\n"
+    "    float corner_radius;\n"
+    "    uint parent;\n"
+    "    vec2 pad;\n"
+    "};\n"
+    "layout(std430, binding = 3) readonly buffer RnClips {\n"
+    "    RnClip u_clips[];\n"
+    "};\n"
+    "#endif\n"
     "\n"
-    "out vec2 v_texcoord;\n"
     "out vec4 v_color;\n"
+    "#ifdef RN_TEXTURED\n"
+    "out vec2 v_texcoord;\n"
     "flat out int v_tex_index;\n"
-    "\n"
+    "#endif\n"
+    "#ifdef RN_SHAPED\n"
+    "out vec2 v_local;\n"
+    "flat out vec2 v_size;\n"
+    "flat out vec2 v_shape;\n"
+    "flat out vec4 v_border_color;\n"
+    "flat out uint v_shape_type;\n"
+    "flat out vec4 v_arc;\n"
+    "flat out uint v_paint;\n"
+    "#endif\n"
+    "#ifdef RN_CLIPPED\n"
+    "out vec2 v_clip_pos;\n"
+    "flat out uint v_clip;\n"
+    "flat out uint v_clip_base;\n"
+    "flat out vec4 v_clip_rect;\n"
+    "flat out float v_clip_radius;\n"
+    "flat out uint v_clip_parent;\n"
+    "#endif\n"
+    "\n";
+
+  const char* vert_src_main =
     "void main()\n"
     "{\n"
+    "    int tex_index = i_tex_index;\n"
+    "    uint ext_offset = 0u;\n"
+    "    uint clip_base = 0u;\n"
+    "    if (u_multi_draw) {\n"
+    "        uint table = uint(gl_DrawID) * RN_DRAW_TABLE_STRIDE;\n"
+    "        ext_offset = u_draw_tables[table];\n"
+    "#ifdef RN_CLIPPED\n"
+    "        clip_base = u_draw_tables[table + 1u];\n"
+    "#endif\n"
+    "        if (tex_index != 0) {\n"
+    "            tex_index = int(u_draw_tables[table + 1u + uint(tex_index)]);\n"
+    "        }\n"
+    "    }\n"
+    "#ifdef RN_COMPACT\n"
+    "    vec2 pos = i_pos * RN_SUBPIXEL_STEP;\n"
+    "    vec2 size = i_size * RN_SUBPIXEL_STEP;\n"
+    "    float rotation = 0.0;\n"
+    "    vec2 shape = vec2(0.0);\n"
+    "    vec4 border_color = vec4(0.0);\n"
+    "    uint shape_type = 0u;\n"
+    "#if defined(RN_ROTATED) || defined(RN_SHAPED)\n"
+    "    if (i_ext != 0u) {\n"
+    "        RnInstanceExt ext = u_ext[ext_offset + i_ext - 1u];\n"
+    "        rotation = ext.rotation;\n"
+    "        shape = vec2(ext.corner_radius, ext.border_width);\n"
+    "        border_color = unpackUnorm4x8(ext.border_color);\n"
+    "        shape_type = ext.shape;\n"
+    "    }\n"
+    "#endif\n"
+    "#else\n"
+    "    vec2 pos = i_pos;\n"
+    "    vec2 size = i_size;\n"
+    "    float rotation = i_rotation;\n"
+    "    vec2 shape = i_shape;\n"
+    "    vec4 border_color = i_border_color;\n"
+    "    uint shape_type = i_shape_type;\n"
+    "#endif\n"
+    "#ifdef RN_ROTATED\n"
     "    // Rotation 2x2\n"
-    "    float c = cos(i_rotation);\n"
-    "    float s = sin(i_rotation);\n"
+    "    float c = cos(rotation);\n"
+    "    float s = sin(rotation);\n"
     "    mat2 rot = mat2(c, -s, s, c);\n"
     "\n"
     "    // Transform\n"
-    "    vec2 world = i_pos + rot * (a_local_pos * i_size);\n"
+    "    vec2 world = pos + u_offset + rot * (a_local_pos * size);\n"
+    "#else\n"
+    "    vec2 world = pos + u_offset + a_local_pos * size;\n"
+    "#endif\n"
     "\n"
-    "    v_texcoord = a_texcoord;\n"
     "    v_color = i_color;\n"
-    "    v_tex_index = i_tex_index;\n"
+    "#ifdef RN_TEXTURED\n"
+    "    v_texcoord = mix(i_uv.xy, i_uv.zw, a_texcoord);\n"
+    "    v_tex_index = tex_index;\n"
+    "#endif\n"
+    "#ifdef RN_SHAPED\n"
+    "    v_local = a_local_pos * size;\n"
+    "    v_size = size;\n"
+    "    v_shape = shape;\n"
+    "    v_border_color = border_color;\n"
+    "    v_shape_type = shape_type;\n"
+    "    // The direction of the middle of arcs and the cosine and sine of\n"
+    "    // half their sweep (negative for full turns), the angles of arcs\n"
+    "    // are stored as fractions of a turn in the texture rect\n"
+    "    v_arc = vec4(0.0);\n"
+    "    if ((shape_type & 31u) == 3u) {\n"
+    "        float half_sweep = i_uv.y * 3.14159265;\n"
+    "        float mid = i_uv.x * 6.28318531 + half_sweep;\n"
+    "        v_arc = vec4(cos(mid), sin(mid), cos(half_sweep),\n"
+    "                     i_uv.y < 1.0 ? sin(half_sweep) : -1.0);\n"
+    "    }\n"
+    "    // Painted instances store the ID of their paint in place of the color\n"
+    "    v_paint = 0u;\n"
+    "    if ((shape_type & 32u) != 0u) {\n"
+    "        v_paint = packUnorm4x8(i_color);\n"
+    "        v_color = vec4(1.0);\n"
+    "    }\n"
+    "#endif\n"
+    "#ifdef RN_CLIPPED\n"
+    "    // Clips are recorded with static batches, so they are\n"
+    "    // evaluated without the offset of the draw\n"
+    "    v_clip_pos = world - u_offset;\n"
+    "    v_clip = i_clip;\n"
+    "    v_clip_base = clip_base;\n"
+    "    v_clip_rect = vec4(0.0);\n"
+    "    v_clip_radius = 0.0;\n"
+    "    v_clip_parent = 0u;\n"
+    "    if (i_clip != 0u) {\n"
+    "        // The innermost clip is fetched once per vertex\n"
+    "        RnClip clip = u_clips[clip_base + i_clip - 1u];\n"
+    "        v_clip_rect = clip.rect;\n"
+    "        v_clip_radius = clip.corner_radius;\n"
+    "        v_clip_parent = clip.parent;\n"
+    "    }\n"
+    "#endif\n"
     "    gl_Position = u_proj * vec4(world, 0.0, 1.0);\n"
     "}\n";
 
+  char vert_header[192];
+  if(compact) {
+    snprintf(vert_header, sizeof(vert_header), 
+             "#version 460 core\n#define RN_DRAW_TABLE_STRIDE %uu\n"
+             "#define RN_COMPACT\n#define RN_SUBPIXEL_STEP (1.0 / %d.0)\n", 
+             state->render.max_textures + 2, RN_COMPACT_SUBPIXELS);
+  } else {
+    snprintf(vert_header, sizeof(vert_header), 
+             "#version 460 core\n#define RN_DRAW_TABLE_STRIDE %uu\n", 
+             state->render.max_textures + 2);
+  }
 
-  const char* frag_src =
-    "#version 460 core\n"
+  // Declarations of the fragment shader that sample the 
+  // textures of the batch through texture units. Batches 
+  // with a single texture (e.g. a glyph atlas) always 
+  // sample the first unit.
+  const char* frag_src_samplers =
+    "#ifdef RN_MULTI_TEXTURE\n"
+    "uniform sampler2D u_textures[32];\n"
+    "\n"
+    "vec4 rn_sample(int idx, vec2 uv)\n"
+    "{\n"
+    "    return texture(u_textures[clamp(idx, 1, 32) - 1], uv);\n"
+    "}\n"
+    "#else\n"
+    "uniform sampler2D u_textures[1];\n"
+    "\n"
+    "vec4 rn_sample(int idx, vec2 uv)\n"
+    "{\n"
+    "    return texture(u_textures[0], uv);\n"
+    "}\n"
+    "#endif\n";
+
+  // Declarations of the fragment shader that sample the 
+  // textures of the batch through bindless handles
+  const char* frag_src_bindless =
+    "#extension GL_ARB_bindless_texture : require\n"
+    "layout(std430, binding = 0) readonly buffer RnTextureHandles {\n"
+    "    uvec2 u_handles[];\n"
+    "};\n"
+    "\n"
+    "vec4 rn_sample(int idx, vec2 uv)\n"
+    "{\n"
+    "#ifdef RN_MULTI_TEXTURE\n"
+    "    return texture(sampler2D(u_handles[idx - 1]), uv);\n"
+    "#else\n"
+    "    return texture(sampler2D(u_handles[0]), uv);\n"
+    "#endif\n"
+    "}\n";
+
+  // Fragment shader body, shapes and clips are evaluated 
+  // as a signed distance to a rounded box
+  const char* frag_src_shapes =
     "out vec4 o_color;\n"
     "\n"
     "in vec4 v_color;\n"
+    "#ifdef RN_TEXTURED\n"
     "flat in int v_tex_index;\n"
     "in vec2 v_texcoord;\n"
+    "#endif\n"
+    "#ifdef RN_SHAPED\n"
+    "in vec2 v_local;\n"
+    "flat in vec2 v_size;\n"
+    "flat in vec2 v_shape;\n"
+    "flat in vec4 v_border_color;\n"
+    "flat in uint v_shape_type;\n"
+    "flat in vec4 v_arc;\n"
+    "flat in uint v_paint;\n"
+    "#endif\n"
     "\n"
-    "uniform sampler2D u_textures[32];\n"
+    "float rn_rounded_box(vec2 p, vec2 half_size, float r)\n"
+    "{\n"
+    "    vec2 q = abs(p) - half_size + r;\n"
+    "    return length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - r;\n"
+    "}\n"
+    "\n"
+    "#ifdef RN_SHAPED\n"
+    "// Coverage of a line along the horizontal center of the instance\n"
+    "// with half the width 'v_shape.x', whose quad extends half the\n"
+    "// height of the quad beyond it's ends (RN_SHAPE_LINE)\n"
+    "float rn_line_coverage()\n"
+    "{\n"
+    "    float half_h = v_size.y * 0.5;\n"
+    "    // Lines thinner than a pixel are faded instead\n"
+    "    float fade = min(v_shape.x * 2.0, 1.0);\n"
+    "    float hw = max(v_shape.x, 0.5);\n"
+    "    vec2 a = vec2(half_h, half_h);\n"
+    "    vec2 b = vec2(v_size.x - half_h, half_h);\n"
+    "    float d = abs(v_local.y - half_h) - hw;\n"
+    "    // Round caps (RN_SHAPE_ROUND_START, RN_SHAPE_ROUND_END)\n"
+    "    if ((v_shape_type & 64u) == 0u) {\n"
+    "        d = max(d, a.x - v_local.x);\n"
+    "    } else if (v_local.x < a.x) {\n"
+    "        d = length(v_local - a) - hw;\n"
+    "    }\n"
+    "    if ((v_shape_type & 128u) == 0u) {\n"
+    "        d = max(d, v_local.x - b.x);\n"
+    "    } else if (v_local.x > b.x) {\n"
+    "        d = length(v_local - b) - hw;\n"
+    "    }\n"
+    "    float aa = max(fwidth(d), 1e-4);\n"
+    "    return clamp(0.5 - d / aa, 0.0, 1.0) * fade;\n"
+    "}\n"
+    "\n"
+    "// Approximation of the error function\n"
+    "vec2 rn_erf(vec2 x)\n"
+    "{\n"
+    "    vec2 s = sign(x), a = abs(x);\n"
+    "    x = 1.0 + (0.278393 + (0.230389 + 0.078108 * (a * a)) * a) * a;\n"
+    "    x *= x;\n"
+    "    return s - s / (x * x);\n"
+    "}\n"
+    "\n"
+    "// Coverage of the row 'y' of a blurred rounded box with the\n"
+    "// half size 'half_size' at 'x', integrated along the row\n"
+    "float rn_shadow_row(float x, float y, float sigma, float r, vec2 half_size)\n"
+    "{\n"
+    "    float delta = min(half_size.y - r - abs(y), 0.0);\n"
+    "    float curved = half_size.x - r + sqrt(max(0.0, r * r - delta * delta));\n"
+    "    vec2 integral = 0.5 + 0.5 * rn_erf((x + vec2(-curved, curved)) * (0.70710678 / sigma));\n"
+    "    return integral.y - integral.x;\n"
+    "}\n"
+    "\n"
+    "// Coverage of the shadow of a rounded box with the corner radius\n"
+    "// 'v_shape.x', blurred with the standard deviation 'v_shape.y'\n"
+    "// (RN_SHAPE_SHADOW). The blur is exact along the rows and sampled\n"
+    "// across them within three standard deviations.\n"
+    "float rn_shadow_coverage()\n"
+    "{\n"
+    "    float sigma = max(v_shape.y, 0.25);\n"
+    "    vec2 half_size = max(v_size * 0.5 - 3.0 * v_shape.y, vec2(0.0));\n"
+    "    float r = min(v_shape.x, min(half_size.x, half_size.y));\n"
+    "    vec2 p = v_local - v_size * 0.5;\n"
+    "    // Fragments far within or outside of the box are not blurred\n"
+    "    float d = rn_rounded_box(p, half_size, r);\n"
+    "    if (abs(d) > 3.0 * sigma) {\n"
+    "        return d < 0.0 ? 1.0 : 0.0;\n"
+    "    }\n"
+    "    float start = clamp(-3.0 * sigma, p.y - half_size.y, p.y + half_size.y);\n"
+    "    float end = clamp(3.0 * sigma, p.y - half_size.y, p.y + half_size.y);\n"
+    "    float step = (end - start) * 0.25;\n"
+    "    float y = start + step * 0.5;\n"
+    "    float value = 0.0;\n"
+    "    for (int i = 0; i < 4; i++) {\n"
+    "        float g = exp(-(y * y) / (2.0 * sigma * sigma)) / (2.50662827 * sigma);\n"
+    "        value += rn_shadow_row(p.x, p.y - y, sigma, r, half_size) * g * step;\n"
+    "        y += step;\n"
+    "    }\n"
+    "    return value;\n"
+    "}\n"
+    "\n"
+    "#endif\n";
+
+  const char* frag_src_arcs =
+    "#ifdef RN_SHAPED\n"
+    "// Signed distance to an ellipse with the radii 'r' (first order\n"
+    "// approximation, exact for circles)\n"
+    "float rn_ellipse(vec2 p, vec2 r)\n"
+    "{\n"
+    "    float k0 = length(p / r);\n"
+    "    float k1 = length(p / (r * r));\n"
+    "    return k1 > 0.0 ? k0 * (k0 - 1.0) / k1 : -min(r.x, r.y);\n"
+    "}\n"
+    "\n"
+    "// Coverage of an arc of the circle inscribed in the instance with\n"
+    "// the thickness 'v_shape.x' (RN_SHAPE_ARC)\n"
+    "float rn_arc_coverage()\n"
+    "{\n"
+    "    vec2 half_size = v_size * 0.5;\n"
+    "    float r = half_size.x - RN_SHAPE_AA_PAD;\n"
+    "    // Arcs thinner than a pixel are faded instead\n"
+    "    float fade = min(v_shape.x, 1.0);\n"
+    "    float hw = min(max(v_shape.x, 1.0), r) * 0.5;\n"
+    "    float mid = r - hw;\n"
+    "    // Rotated so that the arc is symmetric about the X axis\n"
+    "    vec2 p = v_local - half_size;\n"
+    "    p = vec2(dot(p, v_arc.xy), abs(v_arc.x * p.y - v_arc.y * p.x));\n"
+    "    float len = length(p);\n"
+    "    // Pie segments reach the center\n"
+    "    float d = mid > hw ? abs(len - mid) - hw : len - r;\n"
+    "    if (v_arc.w >= 0.0) {\n"
+    "        // Distance beyond the line through the end of the arc\n"
+    "        vec2 dir = v_arc.zw;\n"
+    "        float beyond = dir.x * p.y - dir.y * p.x;\n"
+    "        if ((v_shape_type & 64u) != 0u) {\n"
+    "            if (beyond > 0.0) {\n"
+    "                d = length(p - dir * mid) - hw;\n"
+    "            }\n"
+    "        } else {\n"
+    "            if (beyond > 0.0) {\n"
+    "                d = abs(dot(p, dir) - mid) - hw;\n"
+    "            }\n"
+    "            d = max(d, beyond);\n"
+    "        }\n"
+    "    }\n"
+    "    float aa = max(fwidth(d), 1e-4);\n"
+    "    return clamp(0.5 - d / aa, 0.0, 1.0) * fade;\n"
+    "}\n"
+    "#endif\n";
+
+  const char* frag_src_paints =
+    "#ifdef RN_SHAPED\n"
+    "struct RnPaint {\n"
+    "    uint type;\n"
+    "    uint stop_start;\n"
+    "    uint n_stops;\n"
+    "    uint pad0;\n"
+    "    vec4 color;\n"
+    "    vec2 p0;\n"
+    "    vec2 p1;\n"
+    "    vec2 scale;\n"
+    "    vec2 repeat;\n"
+    "    int tex_index;\n"
+    "    int pad1[3];\n"
+    "};\n"
+    "layout(std430, binding = 4) readonly buffer RnPaints {\n"
+    "    RnPaint u_paints[];\n"
+    "};\n"
+    "struct RnGradientStop {\n"
+    "    uint color;\n"
+    "    float offset;\n"
+    "};\n"
+    "layout(std430, binding = 5) readonly buffer RnGradientStops {\n"
+    "    RnGradientStop u_stops[];\n"
+    "};\n"
+    "\n"
+    "// Color of a gradient paint at the fragment, the points of\n"
+    "// the paint are relative to the size of the instance\n"
+    "vec4 rn_paint(uint id)\n"
+    "{\n"
+    "    RnPaint paint = u_paints[id - 1u];\n"
+    "    vec2 p = v_local / v_size;\n"
+    "    float t;\n"
+    "    if (paint.type == 1u) {\n"
+    "        vec2 dir = paint.p1 - paint.p0;\n"
+    "        t = dot(p - paint.p0, dir) / max(dot(dir, dir), 1e-8);\n"
+    "    } else {\n"
+    "        t = length((p - paint.p0) / max(paint.p1, vec2(1e-4)));\n"
+    "    }\n"
+    "    // Stops are sorted, so every stop that 't' lies beyond\n"
+    "    // replaces the color of the previous ones\n"
+    "    RnGradientStop first = u_stops[paint.stop_start];\n"
+    "    vec4 col = unpackUnorm4x8(first.color);\n"
+    "    float prev = first.offset;\n"
+    "    for (uint i = 1u; i < paint.n_stops; i++) {\n"
+    "        RnGradientStop stop = u_stops[paint.stop_start + i];\n"
+    "        float f = clamp((t - prev) / max(stop.offset - prev, 1e-6), 0.0, 1.0);\n"
+    "        col = mix(col, unpackUnorm4x8(stop.color), f);\n"
+    "        prev = stop.offset;\n"
+    "    }\n"
+    "    return col;\n"
+    "}\n"
+    "#endif\n"
+    "\n";
+
+  const char* frag_src_main =
+    "#ifdef RN_CLIPPED\n"
+    "struct RnClip {\n"
+    "    vec4 rect;\n"
+    "    float corner_radius;\n"
+    "    uint parent;\n"
+    "    vec2 pad;\n"
+    "};\n"
+    "layout(std430, binding = 3) readonly buffer RnClips {\n"
+    "    RnClip u_clips[];\n"
+    "};\n"
+    "\n"
+    "in vec2 v_clip_pos;\n"
+    "flat in uint v_clip;\n"
+    "flat in uint v_clip_base;\n"
+    "flat in vec4 v_clip_rect;\n"
+    "flat in float v_clip_radius;\n"
+    "flat in uint v_clip_parent;\n"
+    "\n"
+    "float rn_clip(vec4 rect, float corner_radius)\n"
+    "{\n"
+    "    vec2 half_size = (rect.zw - rect.xy) * 0.5;\n"
+    "    float r = min(corner_radius, min(half_size.x, half_size.y));\n"
+    "    float d = rn_rounded_box(v_clip_pos - rect.xy - half_size, half_size, r);\n"
+    "    return clamp(0.5 - d, 0.0, 1.0);\n"
+    "}\n"
+    "\n"
+    "// Coverage of the fragment by the clip of the instance and\n"
+    "// all enclosing clips (parents always have a lower slot)\n"
+    "float rn_clip_coverage()\n"
+    "{\n"
+    "    float coverage = rn_clip(v_clip_rect, v_clip_radius);\n"
+    "    for (uint c = v_clip_parent; c != 0u;) {\n"
+    "        RnClip clip = u_clips[v_clip_base + c - 1u];\n"
+    "        coverage *= rn_clip(clip.rect, clip.corner_radius);\n"
+    "        c = clip.parent;\n"
+    "    }\n"
+    "    return coverage;\n"
+    "}\n"
+    "#endif\n"
     "\n"
     "void main()\n"
     "{\n"
     "    vec4 col = v_color;\n"
+    "#ifdef RN_SHAPED\n"
+    "    if (v_paint != 0u) {\n"
+    "        col = rn_paint(v_paint);\n"
+    "    }\n"
+    "#endif\n"
+    "#ifdef RN_TEXTURED\n"
     "    if (v_tex_index != 0) {\n"
-    "        int idx = clamp(v_tex_index, 0, 31);\n"
-    "        col *= texture(u_textures[idx - 1], v_texcoord);\n"
+    "        col *= rn_sample(v_tex_index, v_texcoord);\n"
+    "    }\n"
+    "#endif\n"
+    "#ifdef RN_SHAPED\n"
+    "    // The shape without the flags (RN_SHAPE_TYPE_MASK)\n"
+    "    uint shape_type = v_shape_type & 31u;\n"
+    "    if (shape_type == 1u) {\n"
+    "        col *= rn_line_coverage();\n"
+    "    } else if (shape_type == 3u) {\n"
+    "        col *= rn_arc_coverage();\n"
+    "    } else if (shape_type == 4u) {\n"
+    "        col *= rn_shadow_coverage();\n"
+    "    } else if (shape_type == 2u || v_shape.x > 0.0 || v_shape.y > 0.0) {\n"
+    "        vec2 half_size = v_size * 0.5;\n"
+    "        float d;\n"
+    "        if (shape_type == 2u) {\n"
+    "            d = rn_ellipse(v_local - half_size, max(half_size - RN_SHAPE_AA_PAD, 0.5));\n"
+    "        } else {\n"
+    "            float r = min(v_shape.x, min(half_size.x, half_size.y));\n"
+    "            d = rn_rounded_box(v_local - half_size, half_size, r);\n"
+    "        }\n"
+    "        float aa = max(fwidth(d), 1e-4);\n"
+    "        if (v_shape.y > 0.0) {\n"
+    "            float b = clamp(0.5 + (d + v_shape.y) / aa, 0.0, 1.0);\n"
+    "            col = mix(col, v_border_color, b);\n"
+    "        }\n"
+    "        // Output is blended as premultiplied alpha\n"
+    "        col *= clamp(0.5 - d / aa, 0.0, 1.0);\n"
     "    }\n"
+    "#endif\n"
+    "#ifdef RN_CLIPPED\n"
+    "    if (v_clip != 0u) {\n"
+    "        col *= rn_clip_coverage();\n"
+    "    }\n"
+    "#endif\n"
     "    o_color = col;\n"
     "}\n";
 
-  // Creating the shader program with the source code of the 
-  // vertex- and fragment shader
-  state->render.shader = shader_prg_create(vert_src, frag_src);
+  // Creating the shader variants with the source code 
+  // of the vertex- and fragment shader
+  const char* vert_parts[] = {vert_src_decls, vert_src_main};
+  const char* frag_parts[] = {
+    state->render.bindless ? frag_src_bindless : frag_src_samplers, 
+    frag_src_shapes, frag_src_arcs, frag_src_paints, frag_src_main
+  };
+  renderer_create_variants(state, config, vert_header, 
+                           vert_parts, sizeof(vert_parts) / sizeof(vert_parts[0]), 
+                           frag_parts, sizeof(frag_parts) / sizeof(frag_parts[0]));
 
   // initializing vertex position data
   state->render.vert_pos[0] = (vec4s){-0.5f, -0.5f, 0.0f, 1.0f};
@@ -323,89 +1195,1935 @@ renderer_init(RnState* state) {
   state->render.vert_pos[2] = (vec4s){0.5f, 0.5f, 0.0f, 1.0f};
   state->render.vert_pos[3] = (vec4s){-0.5f, 0.5f, 0.0f, 1.0f};
 
-  // Populating the textures array in the shader with texture IDs 
-  int32_t tex_slots[RN_MAX_TEX_COUNT_BATCH];
-  for(uint32_t i = 0; i < RN_MAX_TEX_COUNT_BATCH; i++) {
-    tex_slots[i] = i;
-  }
-
-  // Upload the texture array (sampler2D array) to the shader
   glUseProgram(state->render.shader.id);
   glBindVertexArray(state->render.vao);
+  state->render.variant = RN_SHADER_VARIANT_COUNT - 1;
+  state->render.features = 0;
+  state->render.multi_draw = (RnMultiDraw){0};
+  state->render.reorder = (RnReorder){0};
+  state->render.timer = (RnGpuTimer){0};
+  state->render.recording = NULL;
+  state->render.layer = NULL;
+  state->render.targets = NULL;
+  state->render.n_targets = 0;
+  state->render.targets_cap = 0;
+  state->render.blur = (RnBlurState){0};
+  state->render.upload = (RnUploadRing){0};
+  state->render.submitted = NULL;
+  state->render.n_submitted = 0;
+  state->render.submitted_cap = 0;
   set_projection_matrix(state);
-  glUniform1iv(glGetUniformLocation(state->render.shader.id, "u_textures"), RN_MAX_TEX_COUNT_BATCH, tex_slots);
 }
 
-/* This function renders every vertex in the current batch */
-void 
-renderer_flush(RnState* state) {
-  if(state->render.n_instances <= 0) return;
+/* This function compiles the variants of the batch shader, 
+ * each with the defines of the features it supports. The 
+ * source of each stage is joined from the given parts after 
+ * it's header and the defines.
+ * */
+void
+renderer_create_variants(RnState* state, const RnInitConfig* config, 
+                         const char* vert_header, 
+                         const char** vert_parts, uint32_t n_vert_parts, 
+                         const char** frag_parts, uint32_t n_frag_parts) {
+  // Ordered from the cheapest to the most expensive 
+  // variant, the last one supports everything.
+  static const uint32_t variant_features[RN_SHADER_VARIANT_COUNT] = {
+    0,
+    RN_SHADER_FEATURE_TEXTURED,
+    RN_SHADER_FEATURE_SHAPED,
+    RN_SHADER_FEATURE_TEXTURED | RN_SHADER_FEATURE_SHAPED,
+    RN_SHADER_FEATURE_TEXTURED | RN_SHADER_FEATURE_MULTI_TEXTURE,
+    RN_SHADER_FEATURE_TEXTURED | RN_SHADER_FEATURE_MULTI_TEXTURE | RN_SHADER_FEATURE_SHAPED,
+    RN_SHADER_FEATURE_TEXTURED | RN_SHADER_FEATURE_SHAPED | RN_SHADER_FEATURE_CLIPPED,
+    RN_SHADER_FEATURE_TEXTURED | RN_SHADER_FEATURE_MULTI_TEXTURE | 
+    RN_SHADER_FEATURE_SHAPED | RN_SHADER_FEATURE_CLIPPED,
+    RN_SHADER_FEATURE_ALL,
+  };
+  char frag_header[192];
+  snprintf(frag_header, sizeof(frag_header), 
+           "#version 460 core\n#define RN_SHAPE_AA_PAD %f\n", RN_SHAPE_AA_PAD);
 
-  glBindBuffer(GL_ARRAY_BUFFER, state->render.vbo_instances);
-  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(RnInstance) * state->render.n_instances, state->render.instances); 
+  size_t vert_len = strlen(vert_header), frag_len = strlen(frag_header);
+  for(uint32_t i = 0; i < n_vert_parts; i++) {
+    vert_len += strlen(vert_parts[i]);
+  }
+  for(uint32_t i = 0; i < n_frag_parts; i++) {
+    frag_len += strlen(frag_parts[i]);
+  }
+  char defines[128];
+  char* vert_src = malloc(vert_len + sizeof(defines));
+  char* frag_src = malloc(frag_len + sizeof(defines));
+  if(!vert_src || !frag_src) {
+    RN_ERROR("Failed to allocate memory for shader sources.");
+    exit(EXIT_FAILURE);
+  }
 
-  // Bind used texture slots
-  for(uint32_t i = 0; i < state->render.tex_count; i++) {
-    glBindTextureUnit(i, state->render.textures[i].id);
+  // Populating the textures array in the shader with texture IDs 
+  int32_t tex_slots[RN_MAX_TEX_COUNT_BATCH];
+  for(uint32_t i = 0; i < RN_MAX_TEX_COUNT_BATCH; i++) {
+    tex_slots[i] = i;
   }
 
+  for(uint32_t i = 0; i < RN_SHADER_VARIANT_COUNT; i++) {
+    uint32_t features = variant_features[i];
+    snprintf(defines, sizeof(defines), "%s%s%s%s%s", 
+             features & RN_SHADER_FEATURE_TEXTURED ? "#define RN_TEXTURED\n" : "", 
+             features & RN_SHADER_FEATURE_MULTI_TEXTURE ? "#define RN_MULTI_TEXTURE\n" : "", 
+             features & RN_SHADER_FEATURE_SHAPED ? "#define RN_SHAPED\n" : "", 
+             features & RN_SHADER_FEATURE_ROTATED ? "#define RN_ROTATED\n" : "",
+             features & RN_SHADER_FEATURE_CLIPPED ? "#define RN_CLIPPED\n" : "");
+
+    strcpy(vert_src, vert_header);
+    strcat(vert_src, defines);
+    for(uint32_t p = 0; p < n_vert_parts; p++) {
+      strcat(vert_src, vert_parts[p]);
+    }
+    strcpy(frag_src, frag_header);
+    strcat(frag_src, defines);
+    for(uint32_t p = 0; p < n_frag_parts; p++) {
+      strcat(frag_src, frag_parts[p]);
+    }
+
+    RnShaderVariant* variant = &state->render.variants[i];
+    variant->shader = shader_prg_create_cached(config, vert_src, frag_src);
+    variant->features = features;
+    variant->offset_loc = glGetUniformLocation(variant->shader.id, "u_offset");
+    variant->multi_draw_loc = glGetUniformLocation(variant->shader.id, "u_multi_draw");
+    glProgramUniform2f(variant->shader.id, variant->offset_loc, 0.0f, 0.0f);
+    glProgramUniform1i(variant->shader.id, variant->multi_draw_loc, 0);
+
+    // Upload the texture array (sampler2D array) to the shader
+    if(!state->render.bindless && (features & RN_SHADER_FEATURE_TEXTURED)) {
+      glProgramUniform1iv(variant->shader.id, 
+                          glGetUniformLocation(variant->shader.id, "u_textures"), 
+                          features & RN_SHADER_FEATURE_MULTI_TEXTURE ? RN_MAX_TEX_COUNT_BATCH : 1, 
+                          tex_slots);
+    }
+  }
+  state->render.shader = state->render.variants[RN_SHADER_VARIANT_COUNT - 1].shader;
 
-  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, state->render.n_instances);
-  state->drawcalls++;
+  free(vert_src);
+  free(frag_src);
 }
 
-/* This function begins a new batch within the 
- * renderer 
- * */
-void renderer_begin(RnState* state) {
-  // Resetting all the 
-  state->render.n_instances = 0;
-  state->render.tex_index = 0;
-  state->render.tex_count = 0;
+/* This function returns the shader features that 
+ * are used by an instance (see 'RnShaderFeature') */
+uint32_t
+instance_features(const RnInstance* inst) {
+  uint32_t features = 0;
+  if(inst->tex_index) {
+    features |= RN_SHADER_FEATURE_TEXTURED;
+  }
+  if(inst->corner_radius > 0.0f || inst->border_width > 0.0f || inst->shape) {
+    features |= RN_SHADER_FEATURE_SHAPED;
+  }
+  if(inst->rotation != 0.0f) {
+    features |= RN_SHADER_FEATURE_ROTATED;
+  }
+  if(inst->clip) {
+    features |= RN_SHADER_FEATURE_CLIPPED;
+  }
+  return features;
 }
 
-/* This function creates the atlas texture of 
- * a given font with OpenGL
+/* This function binds the cheapest shader variant that 
+ * supports the given features of a draw with 'tex_count' 
+ * bound textures.
  * */
-void create_font_atlas(RnFont* font) {
-  glGenTextures(1, &font->atlas_id);
-  glBindTexture(GL_TEXTURE_2D, font->atlas_id);
-
-  int32_t filter_mode = font->filter_mode == RN_TEX_FILTER_LINEAR ?
-    GL_LINEAR : GL_NEAREST;
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_mode);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mode); 
-
-  glTexImage2D(
-    GL_TEXTURE_2D,
-    0, 
-    GL_RGBA,
-    font->atlas_w,
-    font->atlas_h,
-    0, 
-    GL_RGBA,
-    GL_UNSIGNED_BYTE,
-    NULL);
+void
+renderer_use_variant(RnState* state, uint32_t features, uint32_t tex_count) {
+  RnRenderState* render = &state->render;
+  if(tex_count > 1) {
+    features |= RN_SHADER_FEATURE_MULTI_TEXTURE;
+  }
+  uint32_t i = 0;
+  while((render->variants[i].features & features) != features) {
+    i++;
+  }
+  if(i != render->variant) {
+    glUseProgram(render->variants[i].shader.id);
+    render->variant = i;
+  }
+}
 
-  // Generate mipmaps
-  glGenerateMipmap(GL_TEXTURE_2D);
+/* This function sets the offset that is applied to all 
+ * instances in every shader variant (static batches) */
+void
+renderer_set_offset(RnState* state, vec2s offset) {
+  for(uint32_t i = 0; i < RN_SHADER_VARIANT_COUNT; i++) {
+    const RnShaderVariant* variant = &state->render.variants[i];
+    glProgramUniform2f(variant->shader.id, variant->offset_loc, offset.x, offset.y);
+  }
 }
 
+/* This function creates a vertex array that draws the 
+ * static quad once for every instance within 'vbo_instances'
+ * (in the instance layout of the renderer) */
+uint32_t 
+renderer_create_vao(RnState* state, uint32_t vbo_instances) {
+  uint32_t vao;
+  glGenVertexArrays(1, &vao);
+  glBindVertexArray(vao);
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, state->render.ibo);
+
+  // --- Vertex layout for static quad (binding 0) ---
+  glBindBuffer(GL_ARRAY_BUFFER, state->render.vbo_static);
+  glEnableVertexAttribArray(0); // a_local_pos
+  glVertexAttribPointer(
+    0, 2, GL_FLOAT, GL_FALSE, sizeof(RnVertex), (void*)offsetof(RnVertex, pos));
+
+  glEnableVertexAttribArray(1); // a_texcoord
+  glVertexAttribPointer(
+    1, 2, GL_FLOAT, GL_FALSE, sizeof(RnVertex), (void*)offsetof(RnVertex, texcoord));
+
+  // --- Per-instance layout ---
+  glBindBuffer(GL_ARRAY_BUFFER, vbo_instances);
+  if(state->render.format == RN_INSTANCE_FORMAT_COMPACT) {
+    renderer_setup_compact_attribs();
+  } else {
+    renderer_setup_full_attribs();
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  return vao;
+}
+
+/* This function sets up the per-instance vertex 
+ * attributes of the full instance layout (RnInstance) */
+void 
+renderer_setup_full_attribs(void) {
+  GLsizei stride = sizeof(RnInstance);
+
+  // i_pos : vec2
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(RnInstance, pos));
+  glVertexAttribDivisor(2, 1);
+
+  // i_size : vec2
+  glEnableVertexAttribArray(3);
+  glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(RnInstance, size));
+  glVertexAttribDivisor(3, 1);
+
+  // i_rotation : float
+  glEnableVertexAttribArray(4);
+  glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(RnInstance, rotation));
+  glVertexAttribDivisor(4, 1);
+
+  // i_color : vec4 (u8 normalized)
+  glEnableVertexAttribArray(5);
+  glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(RnInstance, color));
+  glVertexAttribDivisor(5, 1);
+
+  // i_tex_index : uint (integer attribute)
+  glEnableVertexAttribArray(6);
+  glVertexAttribIPointer(6, 1, GL_UNSIGNED_BYTE, stride, (void*)offsetof(RnInstance, tex_index));
+  glVertexAttribDivisor(6, 1);
+
+  // i_uv : vec4 (u16 normalized)
+  glEnableVertexAttribArray(7);
+  glVertexAttribPointer(7, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(RnInstance, uv));
+  glVertexAttribDivisor(7, 1);
+
+  // i_shape : vec2 (corner radius, border width)
+  glEnableVertexAttribArray(8);
+  glVertexAttribPointer(8, 2, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(RnInstance, corner_radius));
+  glVertexAttribDivisor(8, 1);
+
+  // i_border_color : vec4 (u8 normalized)
+  glEnableVertexAttribArray(9);
+  glVertexAttribPointer(9, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(RnInstance, border_color));
+  glVertexAttribDivisor(9, 1);
+
+  // i_clip : uint (integer attribute)
+  glEnableVertexAttribArray(10);
+  glVertexAttribIPointer(10, 1, GL_UNSIGNED_BYTE, stride, (void*)offsetof(RnInstance, clip));
+  glVertexAttribDivisor(10, 1);
+
+  // i_shape_type : uint (integer attribute)
+  glEnableVertexAttribArray(11);
+  glVertexAttribIPointer(11, 1, GL_UNSIGNED_BYTE, stride, (void*)offsetof(RnInstance, shape));
+  glVertexAttribDivisor(11, 1);
+}
+
+/* This function sets up the per-instance vertex attributes 
+ * of the compact instance layout (RnInstanceCompact) */
+void 
+renderer_setup_compact_attribs(void) {
+  GLsizei stride = sizeof(RnInstanceCompact);
+
+  // i_pos : vec2 (fixed-point, scaled in the shader)
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 2, GL_SHORT, GL_FALSE, stride, (void*)offsetof(RnInstanceCompact, pos));
+  glVertexAttribDivisor(2, 1);
+
+  // i_size : vec2 (fixed-point, scaled in the shader)
+  glEnableVertexAttribArray(3);
+  glVertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, GL_FALSE, stride, (void*)offsetof(RnInstanceCompact, size));
+  glVertexAttribDivisor(3, 1);
+
+  // i_color : vec4 (u8 normalized)
+  glEnableVertexAttribArray(5);
+  glVertexAttribPointer(5, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(RnInstanceCompact, color));
+  glVertexAttribDivisor(5, 1);
+
+  // i_tex_index : uint (integer attribute)
+  glEnableVertexAttribArray(6);
+  glVertexAttribIPointer(6, 1, GL_UNSIGNED_BYTE, stride, (void*)offsetof(RnInstanceCompact, tex_index));
+  glVertexAttribDivisor(6, 1);
+
+  // i_uv : vec4 (u16 normalized)
+  glEnableVertexAttribArray(7);
+  glVertexAttribPointer(7, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(RnInstanceCompact, uv));
+  glVertexAttribDivisor(7, 1);
+
+  // i_ext : uint (integer attribute)
+  glEnableVertexAttribArray(8);
+  glVertexAttribIPointer(8, 1, GL_UNSIGNED_SHORT, stride, (void*)offsetof(RnInstanceCompact, ext_index));
+  glVertexAttribDivisor(8, 1);
+
+  // i_clip : uint (integer attribute)
+  glEnableVertexAttribArray(10);
+  glVertexAttribIPointer(10, 1, GL_UNSIGNED_BYTE, stride, (void*)offsetof(RnInstanceCompact, clip));
+  glVertexAttribDivisor(10, 1);
+}
+
+/* This function makes the given textures available 
+ * to the shader in the order of their slots */
+void 
+renderer_bind_textures(RnState* state, const RnTexture* textures, uint32_t count) {
+  RnRenderState* render = &state->render;
+  state->stats.texture_binds += count;
+  if(render->bindless) {
+    // Upload the handles of the used textures, making 
+    // them resident when they are used the first time
+    uint64_t handles[RN_MAX_BINDLESS_TEX_COUNT_BATCH];
+    for(uint32_t i = 0; i < count; i++) {
+      handles[i] = render->get_texture_handle(textures[i].id);
+      if(!render->is_texture_handle_resident(handles[i])) {
+        render->make_texture_handle_resident(handles[i]);
+      }
+    }
+    glNamedBufferSubData(render->ssbo_tex_handles, 0, sizeof(uint64_t) * count, handles);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, render->ssbo_tex_handles);
+  } else {
+    // Bind used texture slots
+    for(uint32_t i = 0; i < count; i++) {
+      glBindTextureUnit(i, textures[i].id);
+    }
+  }
+}
+
+/* This function quantizes 'count' staged instances 
+ * into the compact layout. Rotation and shape 
+ * parameters are written to the extended parameters of the 
+ * batch, only for instances that use them.
+ *
+ * Returns the number of written extended parameters.
+ * */
+uint32_t 
+renderer_pack_instances(const RnInstance* instances, uint32_t count, 
+                        RnInstanceCompact* dst, RnInstanceExt* exts) {
+  const float sub = (float)RN_COMPACT_SUBPIXELS;
+  uint32_t n_ext = 0;
+
+  for(uint32_t i = 0; i < count; i++) {
+    const RnInstance* src = &instances[i];
+    RnInstanceCompact packed;
+
+    for(uint32_t j = 0; j < 2; j++) {
+      float pos = roundf(src->pos[j] * sub);
+      float size = roundf(src->size[j] * sub);
+      pos = pos < INT16_MIN ? INT16_MIN : (pos > INT16_MAX ? INT16_MAX : pos);
+      size = size < 0.0f ? 0.0f : (size > UINT16_MAX ? UINT16_MAX : size);
+      packed.pos[j] = (int16_t)pos;
+      packed.size[j] = (uint16_t)size;
+    }
+    memcpy(packed.uv, src->uv, sizeof(packed.uv));
+    memcpy(packed.color, src->color, sizeof(packed.color));
+    packed.tex_index = src->tex_index;
+    packed.clip = src->clip;
+    packed.ext_index = 0;
+
+    if(src->rotation != 0.0f || src->corner_radius > 0.0f || src->border_width > 0.0f || 
+       src->shape) {
+      RnInstanceExt* ext = &exts[n_ext++];
+      ext->rotation = src->rotation;
+      ext->corner_radius = src->corner_radius;
+      ext->border_width = src->border_width;
+      memcpy(ext->border_color, src->border_color, sizeof(ext->border_color));
+      ext->shape = src->shape;
+      packed.ext_index = (uint16_t)n_ext;
+    }
+
+    dst[i] = packed;
+  }
+  return n_ext;
+}
+
+/* Grows a dynamic array to hold at least 'needed' 
+ * elements, doubling it's capacity. 
+ * */
+void* 
+array_reserve(void* data, uint32_t* cap, uint32_t needed, size_t elem_size) {
+  if(needed <= *cap) return data;
+  uint32_t new_cap = *cap ? *cap : 64;
+  while(new_cap < needed) new_cap *= 2;
+  void* new_data = realloc(data, new_cap * elem_size);
+  if(!new_data) {
+    RN_ERROR("Failed to allocate memory for dynamic array.");
+    exit(EXIT_FAILURE);
+  }
+  *cap = new_cap;
+  return new_data;
+}
+
+/* Makes room for one more instance within the static 
+ * batch that is recorded. Segments are split every 
+ * RN_MAX_RENDER_BATCH instances, so that the indices of 
+ * the extended parameters of compact instances stay small.
+ * */
+void 
+static_batch_reserve(RnState* state, RnStaticBatch* batch) {
+  RnRenderState* render = &state->render;
+  if(render->n_instances - render->batch_start + 1 >= RN_MAX_RENDER_BATCH) {
+    renderer_flush(state, RN_FLUSH_CAPACITY);
+  }
+  batch->instances = array_reserve(batch->instances, &batch->instances_cap, 
+                                   render->n_instances + 1, sizeof(RnInstance));
+  render->instances = batch->instances;
+}
+
+/* Adds the instances of the recorded static batch that are 
+ * not part of a segment yet as a segment with the current 
+ * textures and clips of the batch.
+ * */
+void 
+static_batch_add_segment(RnState* state, RnStaticBatch* batch) {
+  RnRenderState* render = &state->render;
+  uint32_t n_clips = render->features & RN_SHADER_FEATURE_CLIPPED ? render->clips.count : 0;
+  batch->segments = array_reserve(batch->segments, &batch->segments_cap, 
+                                  batch->n_segments + 1, sizeof(RnStaticBatchSegment));
+  batch->textures = array_reserve(batch->textures, &batch->textures_cap, 
+                                  batch->n_textures + render->tex_count, sizeof(RnTexture));
+  batch->clips = array_reserve(batch->clips, &batch->clips_cap, 
+                               batch->n_clips + n_clips, sizeof(RnClipData));
+
+  memcpy(&batch->textures[batch->n_textures], render->textures, 
+         sizeof(RnTexture) * render->tex_count);
+  memcpy(&batch->clips[batch->n_clips], render->clips.table, sizeof(RnClipData) * n_clips);
+  batch->segments[batch->n_segments++] = (RnStaticBatchSegment){
+    .first = render->batch_start,
+    .count = render->n_instances - render->batch_start,
+    .tex_first = batch->n_textures,
+    .tex_count = render->tex_count,
+    .features = render->features,
+    .clip_first = batch->n_clips,
+    .n_clips = n_clips
+  };
+  batch->n_textures += render->tex_count;
+  batch->n_clips += n_clips;
+}
+
+/* Remembers that an instance of the recorded static 
+ * batch renders the glyph with the given cache key.
+ * */
+void 
+static_batch_add_glyph(RnStaticBatch* batch, uint32_t instance, uint64_t key) {
+  batch->glyphs = array_reserve(batch->glyphs, &batch->glyphs_cap, 
+                                batch->n_glyphs + 1, sizeof(RnStaticGlyphRef));
+  // The segment of the instance is added once it's closed
+  // Instances of static batches are never clipped
+  batch->glyphs[batch->n_glyphs++] = (RnStaticGlyphRef){
+    .instance = instance, 
+    .segment = batch->n_segments, 
+    .key = key,
+    .uv_clip = {0.0f, 0.0f, 1.0f, 1.0f}
+  };
+}
+
+/* Returns the part of the texture rect of a glyph that 
+ * the (clipped) texture rect 'uv' samples, as fractions 
+ * of the rect (see 'RnStaticGlyphRef.uv_clip').
+ * */
+vec4s 
+glyph_uv_clip(const RnGlyphRenderData* glyph, vec4s uv) {
+  float w = glyph->u1 - glyph->u0, h = glyph->v1 - glyph->v0;
+  if(w <= 0.0f || h <= 0.0f) return (vec4s){0.0f, 0.0f, 1.0f, 1.0f};
+  return (vec4s){
+    (uv.x - glyph->u0) / w, (uv.y - glyph->v0) / h, 
+    (uv.z - glyph->u0) / w, (uv.w - glyph->v0) / h
+  };
+}
+
+/* Returns the texture rect that a referenced glyph instance 
+ * samples within the current atlas of the glyph, so that 
+ * clipped glyphs keep sampling the same part of the glyph. 
+ * */
+vec4s 
+glyph_ref_uv(const RnStaticGlyphRef* ref, const RnGlyph* glyph) {
+  const float* f = ref->uv_clip;
+  return (vec4s){
+    glyph->u0 * (1.0f - f[0]) + glyph->u1 * f[0], 
+    glyph->v0 * (1.0f - f[1]) + glyph->v1 * f[1], 
+    glyph->u0 * (1.0f - f[2]) + glyph->u1 * f[2], 
+    glyph->v0 * (1.0f - f[3]) + glyph->v1 * f[3]
+  };
+}
+
+/* Updates the texture coordinates and atlas textures of 
+ * the glyph instances of a static batch after font 
+ * atlases were recreated.
+ * */
+void 
+static_batch_patch_glyphs(RnState* state, RnStaticBatch* batch) {
+  RnGlyphCache* cache = &state->glyph_cache;
+  for(uint32_t i = 0; i < batch->n_glyphs && cache->cap; i++) {
+    RnStaticGlyphRef ref = batch->glyphs[i];
+    uint32_t slot = glyph_cache_probe(cache, ref.key);
+    // The font of the glyph was freed
+    if(cache->keys[slot] != ref.key) continue;
+
+    const RnGlyph* glyph = &cache->glyphs[slot];
+    RnInstance* inst = &batch->instances[ref.instance];
+    set_instance_uv(inst, glyph_ref_uv(&ref, glyph));
+
+    RnStaticBatchSegment* seg = &batch->segments[ref.segment];
+    batch->textures[seg->tex_first + inst->tex_index - 1].id = glyph->atlas_id;
+  }
+  batch->atlas_generation = state->atlas_generation;
+}
+
+/* Uploads the instances of a static batch to it's 
+ * buffer in the instance layout of the renderer.
+ * */
+void 
+static_batch_upload(RnState* state, RnStaticBatch* batch) {
+  if(!batch->vbo) {
+    glCreateBuffers(1, &batch->vbo);
+    batch->vao = renderer_create_vao(state, batch->vbo);
+    glBindVertexArray(state->render.vao);
+  }
+
+  // The clips and extended parameters of every segment are 
+  // bound as a range, so their offsets need to be aligned.
+  int32_t align = 256;
+  glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+
+  if(batch->n_clips) {
+    uint8_t* clips = malloc(sizeof(RnClipData) * batch->n_clips + 
+                            (size_t)align * batch->n_segments);
+    if(!clips) {
+      RN_ERROR("Failed to allocate memory for the clips of static batch.");
+      exit(EXIT_FAILURE);
+    }
+    uint32_t clips_size = 0;
+    for(uint32_t i = 0; i < batch->n_segments; i++) {
+      RnStaticBatchSegment* seg = &batch->segments[i];
+      if(!seg->n_clips) continue;
+      seg->clip_offset = clips_size;
+      memcpy(clips + clips_size, &batch->clips[seg->clip_first], 
+             sizeof(RnClipData) * seg->n_clips);
+      clips_size += (seg->n_clips * sizeof(RnClipData) + align - 1) / align * align;
+    }
+    if(!batch->ssbo_clips) glCreateBuffers(1, &batch->ssbo_clips);
+    glNamedBufferData(batch->ssbo_clips, clips_size, clips, GL_STATIC_DRAW);
+    free(clips);
+  }
+
+  if(state->render.format == RN_INSTANCE_FORMAT_FULL) {
+    glNamedBufferData(batch->vbo, sizeof(RnInstance) * batch->n_instances, 
+                      batch->instances, GL_STATIC_DRAW);
+    return;
+  }
+
+  RnInstanceCompact* packed = malloc(sizeof(RnInstanceCompact) * batch->n_instances);
+  uint8_t* ext = malloc(sizeof(RnInstanceExt) * batch->n_instances + 
+                        (size_t)align * batch->n_segments);
+  if(!packed || !ext) {
+    RN_ERROR("Failed to allocate memory for packing static batch.");
+    exit(EXIT_FAILURE);
+  }
+
+  uint32_t ext_size = 0;
+  for(uint32_t i = 0; i < batch->n_segments; i++) {
+    RnStaticBatchSegment* seg = &batch->segments[i];
+    seg->ext_offset = ext_size;
+    seg->n_ext = renderer_pack_instances(&batch->instances[seg->first], seg->count, 
+                                         &packed[seg->first], (RnInstanceExt*)(ext + ext_size));
+    ext_size += (seg->n_ext * sizeof(RnInstanceExt) + align - 1) / align * align;
+  }
+
+  glNamedBufferData(batch->vbo, sizeof(RnInstanceCompact) * batch->n_instances, 
+                    packed, GL_STATIC_DRAW);
+  if(ext_size) {
+    if(!batch->ssbo_ext) glCreateBuffers(1, &batch->ssbo_ext);
+    glNamedBufferData(batch->ssbo_ext, ext_size, ext, GL_STATIC_DRAW);
+  }
+
+  free(packed);
+  free(ext);
+}
+
+/* Appends an instance to a recorder. The texture and 
+ * clip slots of the instance are resolved during the merge.
+ * */
+RnInstance* 
+recorder_push(RnRecorder* rec, vec2s pos, vec2s size, float rotation, 
+              RnColor color, uint32_t tex_id, uint32_t clip) {
+  // All arrays grow the same way
+  uint32_t ids_cap = rec->instances_cap, clips_cap = rec->instances_cap;
+  rec->instances = array_reserve(rec->instances, &rec->instances_cap, 
+                                 rec->n_instances + 1, sizeof(RnInstance));
+  rec->tex_ids = array_reserve(rec->tex_ids, &ids_cap, 
+                               rec->n_instances + 1, sizeof(uint32_t));
+  rec->clip_ids = array_reserve(rec->clip_ids, &clips_cap, 
+                                rec->n_instances + 1, sizeof(uint32_t));
+
+  RnInstance* inst = &rec->instances[rec->n_instances];
+  fill_instance(inst, pos, size, rotation, color, tex_id ? 1 : 0);
+  inst->layer = rec->layer;
+  rec->tex_ids[rec->n_instances] = tex_id;
+  rec->clip_ids[rec->n_instances++] = clip;
+  return inst;
+}
+
+/* Records a glyph from it's cached render 
+ * data (see 'glyph_render()') */
+void 
+recorder_glyph_render(RnRecorder* rec, const RnGlyphRenderData* glyph, 
+                      uint32_t atlas_id, uint64_t key, vec2s pos, RnColor color) {
+  vec2s glyph_pos = {pos.x + glyph->bearing_x, pos.y - glyph->bearing_y};
+  vec2s size = {glyph->width, glyph->height};
+  vec4s uv = {glyph->u0, glyph->v0, glyph->u1, glyph->v1};
+  if(!cull_rect_box(rec->cull_start, rec->cull_end, &glyph_pos, &size, 0.0f, &uv, 
+                    &rec->culled_instances, &rec->clipped_instances)) {
+    return;
+  }
+  RnInstance* inst = recorder_push(rec, glyph_pos, size, 0.0f, color, atlas_id, 0);
+  set_instance_uv(inst, uv);
+  recorder_add_glyph(rec, rec->n_instances - 1, key, glyph_uv_clip(glyph, uv));
+}
+
+/* Keeps track of a glyph instance of a recorder so 
+ * that it can be patched if it's atlas is recreated. 
+ * 'uv_clip' is the part of the glyph that the instance 
+ * samples (see 'glyph_uv_clip()').
+ * */
+void 
+recorder_add_glyph(RnRecorder* rec, uint32_t instance, uint64_t key, vec4s uv_clip) {
+  rec->glyphs = array_reserve(rec->glyphs, &rec->glyphs_cap, 
+                              rec->n_glyphs + 1, sizeof(RnStaticGlyphRef));
+  rec->glyphs[rec->n_glyphs++] = (RnStaticGlyphRef){
+    .instance = instance, 
+    .key = key,
+    .uv_clip = {uv_clip.x, uv_clip.y, uv_clip.z, uv_clip.w}
+  };
+}
+
+/* Updates the glyph instances of a recorder if an 
+ * atlas was recreated since the recorder began */
+void 
+recorder_patch_glyphs(RnState* state, RnRecorder* rec) {
+  if(rec->atlas_generation == state->atlas_generation) return;
+  RnGlyphCache* cache = &state->glyph_cache;
+  for(uint32_t i = 0; i < rec->n_glyphs; i++) {
+    uint32_t slot = glyph_cache_probe(cache, rec->glyphs[i].key);
+    if(cache->keys[slot] != rec->glyphs[i].key) continue;
+    // Glyphs that were clipped to the cull box keep their part of the glyph
+    const RnGlyph* glyph = &cache->glyphs[slot];
+    set_instance_uv(&rec->instances[rec->glyphs[i].instance], 
+                    glyph_ref_uv(&rec->glyphs[i], glyph));
+    rec->tex_ids[rec->glyphs[i].instance] = glyph->atlas_id;
+  }
+  rec->atlas_generation = state->atlas_generation;
+}
+
+/* Adds the i-th instance of a recorder to the current batch, 
+ * resolving the texture and clip slots of the instance */
+void 
+recorder_emit_instance(RnState* state, RnRecorder* rec, uint32_t i) {
+  uint8_t slot = 0;
+  if(rec->tex_ids[i]) {
+    RnTexture tex = {.id = rec->tex_ids[i]};
+    slot = rn_tex_index_from_tex(state, tex);
+    if(!slot) {
+      rn_add_tex_to_batch(state, tex);
+      slot = (uint8_t)state->render.tex_count;
+    }
+  }
+  uint8_t clip = 0;
+  RnInstance* inst = push_instance_clipped(state, (vec2s){0}, (vec2s){0}, 0.0f, 
+                                           RN_NO_COLOR, slot, rec->clip_ids[i], &clip);
+  // The batch may be mapped write-only, so the 
+  // instance is never read back once it's written
+  RnInstance src = rec->instances[i];
+  src.tex_index = slot;
+  src.clip = clip;
+  *inst = src;
+  state->render.features |= instance_features(&src);
+}
+
+/* Merges the instances and texts of a recorder into 
+ * the current batch in the order they were recorded.
+ * */
+void 
+recorder_merge(RnState* state, RnRecorder* rec) {
+  // Glyphs that were recorded before an atlas was recreated
+  recorder_patch_glyphs(state, rec);
+
+  // Deferred texts are culled with the cull box of the recorder
+  vec2s cull_start = state->cull_start, cull_end = state->cull_end;
+  state->cull_start = rec->cull_start;
+  state->cull_end = rec->cull_end;
+
+  uint32_t next = 0;
+  for(uint32_t t = 0; t <= rec->n_texts; t++) {
+    uint32_t end = t < rec->n_texts ? rec->texts[t].first : rec->n_instances;
+    for(; next < end; next++) {
+      recorder_emit_instance(state, rec, next);
+    }
+    if(t < rec->n_texts) {
+      const RnRecordedText* text = &rec->texts[t];
+      RnColor color = {text->color[0], text->color[1], text->color[2], text->color[3]};
+      rn_text_render_ex(state, rec->strings + text->str_offset, text->font, 
+                        text->pos, color, text->line_height, true);
+    }
+  }
+
+  state->cull_start = cull_start;
+  state->cull_end = cull_end;
+  state->culled_instances += rec->culled_instances;
+  state->clipped_instances += rec->clipped_instances;
+}
+
+/* Merges the recorders that were submitted since the 
+ * 'first' submitted recorder into the current batch */
+void 
+renderer_merge_recorders(RnState* state, uint32_t first) {
+  RnRenderState* render = &state->render;
+  if(render->n_submitted <= first) return;
+
+  // Shape the deferred texts and load their glyphs first, 
+  // so that atlases are only recreated before merging
+  for(uint32_t i = first; i < render->n_submitted; i++) {
+    RnRecorder* rec = render->submitted[i];
+    for(uint32_t t = 0; t < rec->n_texts; t++) {
+      const RnRecordedText* text = &rec->texts[t];
+      rn_text_render_ex(state, rec->strings + text->str_offset, text->font, 
+                        text->pos, RN_NO_COLOR, text->line_height, false);
+    }
+  }
+
+  for(uint32_t i = first; i < render->n_submitted; i++) {
+    recorder_merge(state, render->submitted[i]);
+  }
+  render->n_submitted = first;
+}
+
+/* Groups the instances captured during the frame by their 
+ * textures and adds them to the batch. An instance is moved 
+ * before instances that were rendered before it only if it 
+ * is on a higher layer or does not overlap them.
+ * */
+void 
+renderer_emit_reordered(RnState* state) {
+  RnRenderState* render = &state->render;
+  RnReorder* reorder = &render->reorder;
+  if(!reorder->enabled || reorder->emitting || !reorder->frame->n_instances) return;
+
+  RnRecorder* frame = reorder->frame;
+  uint32_t n = frame->n_instances;
+  recorder_patch_glyphs(state, frame);
+
+  // Order the instances by layer (keeping the 
+  // order in which they were rendered per layer)
+  uint32_t next_cap = reorder->order_cap;
+  reorder->order = array_reserve(reorder->order, &reorder->order_cap, n, sizeof(uint32_t));
+  reorder->next = array_reserve(reorder->next, &next_cap, n, sizeof(uint32_t));
+  uint32_t offsets[257] = {0};
+  for(uint32_t i = 0; i < n; i++) {
+    offsets[frame->instances[i].layer + 1]++;
+  }
+  for(uint32_t i = 0; i < 256; i++) {
+    offsets[i + 1] += offsets[i];
+  }
+  for(uint32_t i = 0; i < n; i++) {
+    reorder->order[offsets[frame->instances[i].layer]++] = i;
+  }
+
+  uint32_t grid_w = render->render_w / RN_REORDER_CELL_SIZE + 1;
+  uint32_t grid_h = render->render_h / RN_REORDER_CELL_SIZE + 1;
+  if(!reorder->grid || grid_w != reorder->grid_w || grid_h != reorder->grid_h) {
+    free(reorder->grid);
+    reorder->grid = malloc(sizeof(uint32_t) * grid_w * grid_h);
+    if(!reorder->grid) {
+      RN_ERROR("Failed to allocate memory for reordering grid.");
+      exit(EXIT_FAILURE);
+    }
+    reorder->grid_w = grid_w;
+    reorder->grid_h = grid_h;
+  }
+  memset(reorder->grid, 0, sizeof(uint32_t) * grid_w * grid_h);
+
+  uint32_t max_tex = render->max_textures;
+  reorder->n_draws = 0;
+  for(uint32_t k = 0; k < n; k++) {
+    uint32_t i = reorder->order[k];
+    const RnInstance* inst = &frame->instances[i];
+    uint32_t tex_id = frame->tex_ids[i];
+
+    // The cells covered by the instance (instances outside 
+    // of the rendered area are clamped to the border cells)
+    RnAABB bounds = rect_bounds((vec2s){inst->pos[0], inst->pos[1]}, 
+                                (vec2s){inst->size[0], inst->size[1]}, inst->rotation);
+    uint32_t x0 = (uint32_t)fminf(fmaxf(bounds.minx / RN_REORDER_CELL_SIZE, 0.0f), grid_w - 1);
+    uint32_t y0 = (uint32_t)fminf(fmaxf(bounds.miny / RN_REORDER_CELL_SIZE, 0.0f), grid_h - 1);
+    uint32_t x1 = (uint32_t)fminf(fmaxf(ceilf(bounds.maxx / RN_REORDER_CELL_SIZE) - 1.0f, 
+                                        (float)x0), grid_w - 1);
+    uint32_t y1 = (uint32_t)fminf(fmaxf(ceilf(bounds.maxy / RN_REORDER_CELL_SIZE) - 1.0f, 
+                                        (float)y0), grid_h - 1);
+
+    // The instance cannot be drawn before the 
+    // last draw that might overlap it
+    uint32_t first = 0;
+    for(uint32_t y = y0; y <= y1; y++) {
+      for(uint32_t x = x0; x <= x1; x++) {
+        uint32_t d = reorder->grid[y * grid_w + x];
+        if(d > first) first = d;
+      }
+    }
+    if(first) first--;
+
+    // Prefer the first draw that already uses the texture, then 
+    // the first draw with a free texture slot, then a new draw
+    uint32_t target = UINT32_MAX, with_slot = UINT32_MAX;
+    for(uint32_t d = first; d < reorder->n_draws && target == UINT32_MAX; d++) {
+      const RnReorderDraw* draw = &reorder->draws[d];
+      if(!tex_id) {
+        target = d;
+        break;
+      }
+      const uint32_t* ids = &reorder->draw_textures[d * max_tex];
+      for(uint32_t t = 0; t < draw->tex_count; t++) {
+        if(ids[t] == tex_id) {
+          target = d;
+          break;
+        }
+      }
+      if(with_slot == UINT32_MAX && draw->tex_count < max_tex) {
+        with_slot = d;
+      }
+    }
+
+    if(target == UINT32_MAX && with_slot != UINT32_MAX) {
+      target = with_slot;
+      reorder->draw_textures[target * max_tex + reorder->draws[target].tex_count++] = tex_id;
+    }
+    if(target == UINT32_MAX) {
+      target = reorder->n_draws++;
+      reorder->draws = array_reserve(reorder->draws, &reorder->draws_cap, 
+                                     reorder->n_draws, sizeof(RnReorderDraw));
+      reorder->draw_textures = array_reserve(reorder->draw_textures, &reorder->draw_textures_cap, 
+                                             reorder->n_draws * max_tex, sizeof(uint32_t));
+      reorder->draws[target] = (RnReorderDraw){.head = i, .tail = i, .tex_count = 0};
+      if(tex_id) {
+        reorder->draw_textures[target * max_tex] = tex_id;
+        reorder->draws[target].tex_count = 1;
+      }
+    }
+    else {
+      reorder->next[reorder->draws[target].tail] = i;
+      reorder->draws[target].tail = i;
+    }
+    reorder->next[i] = UINT32_MAX;
+
+    for(uint32_t y = y0; y <= y1; y++) {
+      for(uint32_t x = x0; x <= x1; x++) {
+        uint32_t* cell = &reorder->grid[y * grid_w + x];
+        if(*cell < target + 1) *cell = target + 1;
+      }
+    }
+  }
+
+  // Every draw is emitted in the order in which it's instances were rendered
+  reorder->emitting = true;
+  for(uint32_t d = 0; d < reorder->n_draws; d++) {
+    for(uint32_t i = reorder->draws[d].head; i != UINT32_MAX; i = reorder->next[i]) {
+      recorder_emit_instance(state, frame, i);
+    }
+  }
+  reorder->emitting = false;
+  rn_recorder_begin(frame);
+}
+
+/* This function checks if the OpenGL context 
+ * supports an extension with a given name
+ * */
+bool 
+renderer_has_extension(const char* name) {
+  int32_t n = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+  for(int32_t i = 0; i < n; i++) {
+    const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+    if(ext && strcmp(ext, name) == 0) return true;
+  }
+  return false;
+}
+
+/* Loads an entry point of the driver into the function pointer 
+ * at 'o_proc'. The loader returns an object pointer, which ISO C 
+ * does not allow to be cast to a function pointer directly.
+ * */
+void 
+renderer_load_proc(RnGLLoader loader, const char* name, void* o_proc) {
+  void* proc = loader(name);
+  memcpy(o_proc, &proc, sizeof(proc));
+}
+
+/* Deletes a texture, making it's bindless handle non-resident 
+ * first if it was made resident for a batch
+ * */
+void 
+renderer_delete_texture(RnState* state, uint32_t* id) {
+  RnRenderState* render = &state->render;
+  if(render->bindless && *id) {
+    uint64_t handle = render->get_texture_handle(*id);
+    if(render->is_texture_handle_resident(handle)) {
+      render->make_texture_handle_non_resident(handle);
+    }
+  }
+  glDeleteTextures(1, id);
+  *id = 0;
+}
+
+/* This function renders every vertex in the current batch */
+void 
+renderer_flush(RnState* state, RnFlushCause cause) {
+  RnRenderState* render = &state->render;
+  uint32_t count = render->n_instances - render->batch_start;
+  if(count == 0) return;
+
+  if(!render->recording && render->n_instances > state->batch_high_water) {
+    state->batch_high_water = render->n_instances;
+  }
+
+  // Instances of a recorded static batch are 
+  // kept as a segment of the batch instead
+  if(render->recording) {
+    static_batch_add_segment(state, render->recording);
+    render->batch_start = render->n_instances;
+    render->features = 0;
+    return;
+  }
+
+  state->stats.flushes++;
+  state->stats.flush_causes[cause]++;
+  state->stats.instances += count;
+
+  // Batches are drawn together in multi-draw mode
+  if(render->multi_draw.enabled) {
+    renderer_queue_draw(state);
+    return;
+  }
+
+  uint32_t base_instance = 0;
+  state->bytes_uploaded += (uint64_t)render->instance_size * count;
+
+  const void* upload = render->instances;
+  if(render->format == RN_INSTANCE_FORMAT_COMPACT) {
+    // Quantize the staged instances into the mapped 
+    // region or the staging array of packed instances
+    RnInstanceCompact* dst = render->streaming ? 
+      (RnInstanceCompact*)render->vbo_ptr + 
+      (size_t)render->region * render->capacity + render->batch_start : 
+      render->packed;
+    uint32_t n_ext = renderer_pack_instances(&render->instances[render->batch_start], count, 
+                                             dst, render->ext);
+    if(n_ext) {
+      // Orphan the buffer, the previous draw may still read it
+      glNamedBufferData(render->ssbo_ext, sizeof(RnInstanceExt) * render->capacity, 
+                        NULL, GL_STREAM_DRAW);
+      glNamedBufferSubData(render->ssbo_ext, 0, sizeof(RnInstanceExt) * n_ext, render->ext);
+      state->bytes_uploaded += sizeof(RnInstanceExt) * n_ext;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, render->ssbo_ext);
+    upload = render->packed;
+  }
+
+  if(render->streaming) {
+    // The instances already live in the mapped region, 
+    // only their offset within the buffer is needed.
+    base_instance = render->region * render->capacity + render->batch_start;
+  } else {
+    glBindBuffer(GL_ARRAY_BUFFER, render->vbo_instances);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)render->instance_size * count, upload); 
+  }
+
+  renderer_bind_textures(state, render->textures, render->tex_count);
+  if(render->features & RN_SHADER_FEATURE_CLIPPED) {
+    renderer_upload_clips(state, render->clips.table, render->clips.count);
+  }
+  renderer_use_variant(state, render->features, render->tex_count);
+  render->features = 0;
+
+  renderer_timer_begin(state);
+  glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, count, base_instance);
+  renderer_timer_end(state);
+  state->drawcalls++;
+
+  if(render->streaming) {
+    // Keep appending behind the drawn instances, the GPU 
+    // may still be reading them.
+    render->batch_start = render->n_instances;
+  } else {
+    render->n_instances = 0;
+  }
+}
+
+/* Queues the instances of the current batch as an indirect 
+ * draw with it's own texture table (multi-draw mode). The 
+ * instances stay in the instance buffer until submission.
+ * */
+void 
+renderer_queue_draw(RnState* state) {
+  RnRenderState* render = &state->render;
+  RnMultiDraw* md = &render->multi_draw;
+  uint32_t count = render->n_instances - render->batch_start;
+  uint32_t stride = render->max_textures + 2;
+  state->bytes_uploaded += (uint64_t)render->instance_size * count;
+
+  // Find the textures of the batch among the textures 
+  // of the queued draws (0 if not yet used)
+  uint32_t indices[RN_MAX_BINDLESS_TEX_COUNT_BATCH];
+  uint32_t missing = 0;
+  for(uint32_t i = 0; i < render->tex_count; i++) {
+    indices[i] = 0;
+    for(uint32_t j = 0; j < md->tex_count; j++) {
+      if(md->textures[j].id == render->textures[i].id) {
+        indices[i] = j + 1;
+        break;
+      }
+    }
+    if(!indices[i]) missing++;
+  }
+  // Draw the queued batches first if the textures do not fit
+  if(md->tex_count + missing > render->max_textures) {
+    renderer_submit_draws(state);
+    memset(indices, 0, sizeof(uint32_t) * render->tex_count);
+  }
+
+  md->table = array_reserve(md->table, &md->table_cap, 
+                            (md->n_commands + 1) * stride, sizeof(uint32_t));
+  uint32_t* table = &md->table[md->n_commands * stride];
+  table[0] = md->n_ext;
+  table[1] = md->n_clips;
+  for(uint32_t i = 0; i < render->tex_count; i++) {
+    if(!indices[i]) {
+      md->textures[md->tex_count++] = render->textures[i];
+      indices[i] = md->tex_count;
+    }
+    table[i + 2] = indices[i];
+  }
+  if(render->features & RN_SHADER_FEATURE_CLIPPED) {
+    md->clips = array_reserve(md->clips, &md->clips_cap, 
+                              md->n_clips + render->clips.count, sizeof(RnClipData));
+    memcpy(&md->clips[md->n_clips], render->clips.table, 
+           sizeof(RnClipData) * render->clips.count);
+    md->n_clips += render->clips.count;
+  }
+
+  uint32_t base_instance = render->streaming ? 
+    render->region * render->capacity + render->batch_start : 
+    render->batch_start;
+  if(render->format == RN_INSTANCE_FORMAT_COMPACT) {
+    RnInstanceCompact* dst = render->streaming ? 
+      (RnInstanceCompact*)render->vbo_ptr + base_instance : 
+      render->packed + base_instance;
+    md->n_ext += renderer_pack_instances(&render->instances[render->batch_start], count, 
+                                         dst, render->ext + md->n_ext);
+  }
+
+  md->commands = array_reserve(md->commands, &md->commands_cap, 
+                               md->n_commands + 1, sizeof(RnDrawCommand));
+  md->commands[md->n_commands++] = (RnDrawCommand){
+    .count = 6, 
+    .instance_count = count, 
+    .first_index = 0, 
+    .base_vertex = 0, 
+    .base_instance = base_instance
+  };
+  md->features |= render->features;
+  render->features = 0;
+  render->batch_start = render->n_instances;
+}
+
+/* Submits all queued draws (multi-draw mode) 
+ * with a single indirect draw call.
+ * */
+void 
+renderer_submit_draws(RnState* state) {
+  RnRenderState* render = &state->render;
+  RnMultiDraw* md = &render->multi_draw;
+  if(!md->n_commands) return;
+  uint32_t stride = render->max_textures + 2;
+
+  if(!render->streaming) {
+    // Upload the instances of all queued draws at once
+    const RnDrawCommand* last = &md->commands[md->n_commands - 1];
+    uint32_t first = md->commands[0].base_instance;
+    uint32_t end = last->base_instance + last->instance_count;
+    const uint8_t* src = render->format == RN_INSTANCE_FORMAT_COMPACT ? 
+      (const uint8_t*)render->packed : (const uint8_t*)render->instances;
+    glNamedBufferSubData(render->vbo_instances, (GLintptr)render->instance_size * first, 
+                         (GLsizeiptr)render->instance_size * (end - first), 
+                         src + (size_t)render->instance_size * first);
+  }
+  if(render->format == RN_INSTANCE_FORMAT_COMPACT) {
+    if(md->n_ext) {
+      // Orphan the buffer, the previous draw may still read it
+      glNamedBufferData(render->ssbo_ext, sizeof(RnInstanceExt) * render->capacity, 
+                        NULL, GL_STREAM_DRAW);
+      glNamedBufferSubData(render->ssbo_ext, 0, sizeof(RnInstanceExt) * md->n_ext, render->ext);
+      state->bytes_uploaded += sizeof(RnInstanceExt) * md->n_ext;
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, render->ssbo_ext);
+  }
+
+  renderer_bind_textures(state, md->textures, md->tex_count);
+  if(md->n_clips) {
+    renderer_upload_clips(state, md->clips, md->n_clips);
+  }
+
+  glNamedBufferData(md->ssbo_table, sizeof(uint32_t) * stride * md->n_commands, 
+                    md->table, GL_STREAM_DRAW);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, md->ssbo_table);
+  glNamedBufferData(md->ibo_commands, sizeof(RnDrawCommand) * md->n_commands, 
+                    md->commands, GL_STREAM_DRAW);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, md->ibo_commands);
+  state->bytes_uploaded += (sizeof(uint32_t) * stride + sizeof(RnDrawCommand)) * md->n_commands;
+
+  renderer_use_variant(state, md->features, md->tex_count);
+  const RnShaderVariant* variant = &render->variants[render->variant];
+  glProgramUniform1i(variant->shader.id, variant->multi_draw_loc, 1);
+  renderer_timer_begin(state);
+  glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, NULL, md->n_commands, 0);
+  renderer_timer_end(state);
+  glProgramUniform1i(variant->shader.id, variant->multi_draw_loc, 0);
+  state->drawcalls++;
+
+  md->n_commands = 0;
+  md->tex_count = 0;
+  md->n_ext = 0;
+  md->n_clips = 0;
+  md->features = 0;
+  // Start over at the beginning of the staging buffer 
+  // unless instances of the current batch are pending
+  if(!render->streaming && render->n_instances == render->batch_start) {
+    render->n_instances = 0;
+    render->batch_start = 0;
+  }
+}
+
+/* This function begins a new batch within the 
+ * renderer 
+ * */
+void renderer_begin(RnState* state) {
+  // Resetting all the 
+  if(state->render.streaming || state->render.multi_draw.enabled || 
+     state->render.recording) {
+    // Drop instances that were not drawn, but never overwrite 
+    // ones the GPU may still be reading, that are queued or 
+    // that belong to the static batch being recorded.
+    state->render.n_instances = state->render.batch_start;
+  } else {
+    state->render.n_instances = 0;
+  }
+  state->render.features = 0;
+  // Bind the shader again with the first draw, in 
+  // case the application used it's own in between
+  state->render.variant = UINT32_MAX;
+  renderer_reset_textures(state);
+  renderer_reset_clips(state);
+  renderer_bind_paints(state);
+}
+
+/* This function binds the paint table to the shader, 
+ * it is not rebound per draw as it rarely changes */
+void 
+renderer_bind_paints(RnState* state) {
+  RnPaintTable* table = &state->render.paints;
+  if(!table->n_paints) return;
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, table->ssbo_paints);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, table->ssbo_stops);
+}
+
+/* This function empties the texture slots 
+ * of the current batch 
+ * */
+void 
+renderer_reset_textures(RnState* state) {
+  state->render.tex_index = 0;
+  state->render.tex_count = 0;
+  // Bumping the generation invalidates all entries 
+  // of the slot table at once
+  if(++state->render.tex_slots_gen == 0) {
+    memset(state->render.tex_slots, 0, sizeof(state->render.tex_slots));
+    state->render.tex_slots_gen = 1;
+  }
+}
+
+/* This function uploads a clip table and binds it to the 
+ * shader (the clips of the batch or of the queued draws) */
+void 
+renderer_upload_clips(RnState* state, const RnClipData* clips, uint32_t count) {
+  RnClipStack* stack = &state->render.clips;
+  // Orphan the buffer, the previous draw may still read it
+  glNamedBufferData(stack->ssbo, sizeof(RnClipData) * count, NULL, GL_STREAM_DRAW);
+  glNamedBufferSubData(stack->ssbo, 0, sizeof(RnClipData) * count, clips);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, stack->ssbo);
+  state->bytes_uploaded += sizeof(RnClipData) * count;
+}
+
+/* This function empties the clip slots 
+ * of the current batch 
+ * */
+void 
+renderer_reset_clips(RnState* state) {
+  RnClipStack* stack = &state->render.clips;
+  stack->count = 0;
+  // Bumping the generation removes all 
+  // clips of the frame from the table at once
+  if(++stack->gen == 0) {
+    for(uint32_t i = 0; i < stack->n_clips; i++) {
+      stack->clips[i].gen = stack->clips[i].only_gen = 0;
+    }
+    stack->gen = 1;
+  }
+}
+
+/* Returns the slot of a clip of the frame (1-based index 
+ * within 'clips', optionally flagged with RN_CLIP_ONLY) within 
+ * the clip table of the current batch, adding it and the clips 
+ * enclosing it to the table if they are not part of it yet. 
+ * The batch is flushed if the table cannot hold them.
+ * */
+uint8_t 
+renderer_clip_slot(RnState* state, uint32_t clip) {
+  if(!clip) return 0;
+  RnClipStack* stack = &state->render.clips;
+  bool only = clip & RN_CLIP_ONLY;
+  clip &= ~RN_CLIP_ONLY;
+
+  uint32_t missing = 0;
+  if(only) {
+    missing = stack->clips[clip - 1].only_gen != stack->gen;
+  } else {
+    for(uint32_t c = clip; c && stack->clips[c - 1].gen != stack->gen; 
+        c = stack->clips[c - 1].parent) {
+      missing++;
+    }
+  }
+  if(stack->count + missing > RN_MAX_CLIP_COUNT_BATCH) {
+    renderer_flush(state, RN_FLUSH_CLIPS);
+    renderer_reset_clips(state);
+  }
+  return clip_add_to_table(stack, clip, only);
+}
+
+/* Adds a clip of the frame and the clips enclosing it (unless 
+ * 'only' is set) to the clip table (see 'renderer_clip_slot()') */
+uint8_t 
+clip_add_to_table(RnClipStack* stack, uint32_t clip, bool only) {
+  RnClip* entry = &stack->clips[clip - 1];
+  uint32_t* gen = only ? &entry->only_gen : &entry->gen;
+  uint32_t* slot = only ? &entry->only_slot : &entry->slot;
+  if(*gen == stack->gen) return (uint8_t)*slot;
+
+  // Parents are added first, so that they always 
+  // have a lower slot than the clips they enclose
+  uint32_t parent = entry->parent && !only ? 
+    clip_add_to_table(stack, entry->parent, false) : 0;
+  RnClipData* data = &stack->table[stack->count++];
+  memcpy(data->rect, entry->rect, sizeof(data->rect));
+  data->corner_radius = entry->corner_radius;
+  data->parent = parent;
+  data->_pad[0] = data->_pad[1] = 0.0f;
+  *gen = stack->gen;
+  *slot = stack->count;
+  return (uint8_t)*slot;
+}
+
+/* Returns the innermost clip of the clip stack that an instance 
+ * with the given bounds is not entirely within (1-based index 
+ * within 'clips', 0 if no clip is needed). The clip is flagged 
+ * with RN_CLIP_ONLY if the instance is within all enclosing clips.
+ * */
+uint32_t 
+clip_for_bounds(const RnClipStack* stack, RnAABB bounds) {
+  uint32_t result = 0;
+  for(uint32_t i = stack->depth; i > stack->base; i--) {
+    const RnClip* clip = &stack->clips[stack->stack[i - 1] - 1];
+    float r = clip->corner_radius;
+    bool inside = 
+      bounds.minx >= clip->rect[0] && bounds.maxx <= clip->rect[2] &&
+      bounds.miny >= clip->rect[1] && bounds.maxy <= clip->rect[3];
+    // Instances must not reach into the rounded corners
+    bool corners = r <= 0.0f || 
+      (bounds.minx >= clip->rect[0] + r && bounds.maxx <= clip->rect[2] - r) ||
+      (bounds.miny >= clip->rect[1] + r && bounds.maxy <= clip->rect[3] - r);
+    if(inside && corners) continue;
+    // An enclosing clip is needed as well
+    if(result) return result & ~RN_CLIP_ONLY;
+    result = stack->stack[i - 1] | RN_CLIP_ONLY;
+  }
+  return result;
+}
+
+/* Returns the size class of a render target 
+ * dimension (see RN_LAYER_MIN_SIZE) */
+uint32_t 
+layer_size_class(uint32_t size) {
+  if(size <= RN_LAYER_MIN_SIZE) return RN_LAYER_MIN_SIZE;
+  uint32_t pow2 = 1;
+  while(pow2 * 2 < size) pow2 *= 2;
+  uint32_t step = pow2 / 4;
+  return (size + step - 1) / step * step;
+}
+
+/* Returns an unused render target of the size class of the 
+ * given size from the pool or creates it if there is none */
+RnRenderTarget 
+renderer_acquire_target(RnState* state, uint32_t width, uint32_t height) {
+  RnRenderState* render = &state->render;
+  uint32_t w = layer_size_class(width), h = layer_size_class(height);
+  for(uint32_t i = 0; i < render->n_targets; i++) {
+    RnRenderTarget target = render->targets[i];
+    if(target.texture.width == w && target.texture.height == h) {
+      render->targets[i] = render->targets[--render->n_targets];
+      return target;
+    }
+  }
+
+  RnRenderTarget target = {0};
+  target.texture.width = w;
+  target.texture.height = h;
+  glCreateTextures(GL_TEXTURE_2D, 1, &target.texture.id);
+  glTextureStorage2D(target.texture.id, 1, GL_RGBA8, w, h);
+  glTextureParameteri(target.texture.id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(target.texture.id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureParameteri(target.texture.id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(target.texture.id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glCreateFramebuffers(1, &target.fbo);
+  glNamedFramebufferTexture(target.fbo, GL_COLOR_ATTACHMENT0, target.texture.id, 0);
+  if(glCheckNamedFramebufferStatus(target.fbo, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+    RN_ERROR("Failed to create render target of %ux%u pixels.", w, h);
+    exit(EXIT_FAILURE);
+  }
+  return target;
+}
+
+/* Returns the render target of a layer to the pool */
+void 
+renderer_release_target(RnState* state, RnRenderTarget* target) {
+  RnRenderState* render = &state->render;
+  if(!target->texture.id) return;
+  target->released_frame = state->stats.frame;
+  render->targets = array_reserve(render->targets, &render->targets_cap, 
+                                  render->n_targets + 1, sizeof(RnRenderTarget));
+  render->targets[render->n_targets++] = *target;
+  memset(target, 0, sizeof(*target));
+}
+
+/* Deletes the render targets of the pool that were not 
+ * used within the last RN_LAYER_POOL_FRAMES frames */
+void 
+renderer_trim_targets(RnState* state) {
+  RnRenderState* render = &state->render;
+  for(uint32_t i = 0; i < render->n_targets;) {
+    RnRenderTarget* target = &render->targets[i];
+    if(state->stats.frame - target->released_frame < RN_LAYER_POOL_FRAMES) {
+      i++;
+      continue;
+    }
+    glDeleteFramebuffers(1, &target->fbo);
+    renderer_delete_texture(state, &target->texture.id);
+    *target = render->targets[--render->n_targets];
+  }
+}
+
+/* Starts timing a draw on the GPU if timing is enabled 
+ * and the frame has timer queries left */
+void 
+renderer_timer_begin(RnState* state) {
+  RnGpuTimer* timer = &state->render.timer;
+  if(!timer->enabled || timer->n_queries[timer->slot] >= RN_MAX_TIMED_DRAWS) return;
+  glBeginQuery(GL_TIME_ELAPSED, timer->queries[timer->slot][timer->n_queries[timer->slot]]);
+  timer->running = true;
+}
+
+/* Stops timing the current draw */
+void 
+renderer_timer_end(RnState* state) {
+  RnGpuTimer* timer = &state->render.timer;
+  if(!timer->running) return;
+  glEndQuery(GL_TIME_ELAPSED);
+  timer->n_queries[timer->slot]++;
+  timer->running = false;
+}
+
+/* Reads back the timer queries of earlier frames that have 
+ * finished without waiting for the GPU and moves on to the 
+ * next frame slot. Queries that have not finished after 
+ * RN_TIMER_FRAMES frames are dropped.
+ * */
+void 
+renderer_timer_end_frame(RnState* state) {
+  RnGpuTimer* timer = &state->render.timer;
+  if(!timer->enabled) return;
+  timer->frames[timer->slot] = state->stats.frame;
+
+  // From the oldest to the newest frame, so that 
+  // the results of the newest finished frame are kept
+  for(uint32_t age = RN_TIMER_FRAMES - 1; age >= 1; age--) {
+    uint32_t slot = (timer->slot + RN_TIMER_FRAMES - age) % RN_TIMER_FRAMES;
+    uint32_t n = timer->n_queries[slot];
+    if(!n) continue;
+    // Queries finish in order
+    int32_t available = 0;
+    glGetQueryObjectiv(timer->queries[slot][n - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available) break;
+    for(uint32_t i = 0; i < n; i++) {
+      uint64_t ns = 0;
+      glGetQueryObjectui64v(timer->queries[slot][i], GL_QUERY_RESULT, &ns);
+      timer->results_ms[i] = (float)((double)ns / 1e6);
+    }
+    timer->n_results = n;
+    timer->result_frame = timer->frames[slot];
+    timer->has_result = true;
+    timer->n_queries[slot] = 0;
+  }
+
+  timer->slot = (timer->slot + 1) % RN_TIMER_FRAMES;
+  timer->n_queries[timer->slot] = 0;
+}
+
+/* Doubles the number of instances that a batch can hold 
+ * (up to the maximum capacity), keeping the instances that 
+ * were rendered. Returns false if the batch cannot grow.
+ * */
+bool 
+renderer_grow(RnState* state) {
+  RnRenderState* render = &state->render;
+  if(render->capacity >= render->max_capacity) return false;
+  uint32_t old_capacity = render->capacity;
+  uint32_t capacity = old_capacity > render->max_capacity / 2 ? 
+    render->max_capacity : old_capacity * 2;
+  bool compact = render->format == RN_INSTANCE_FORMAT_COMPACT;
+
+  // Queued draws refer to instances within the old buffer
+  renderer_submit_draws(state);
+
+  if(!render->streaming || compact) {
+    RnInstance* instances = realloc(render->instances, sizeof(RnInstance) * capacity);
+    if(!instances) {
+      RN_ERROR("Failed to allocate memory for instances.");
+      exit(EXIT_FAILURE);
+    }
+    render->instances = instances;
+  }
+  if(compact) {
+    RnInstanceExt* ext = realloc(render->ext, sizeof(RnInstanceExt) * capacity);
+    if(!ext) {
+      RN_ERROR("Failed to allocate memory for extended instance parameters.");
+      exit(EXIT_FAILURE);
+    }
+    render->ext = ext;
+    if(!render->streaming) {
+      RnInstanceCompact* packed = realloc(render->packed, sizeof(RnInstanceCompact) * capacity);
+      if(!packed) {
+        RN_ERROR("Failed to allocate memory for packed instances.");
+        exit(EXIT_FAILURE);
+      }
+      render->packed = packed;
+    }
+  }
+
+  if(render->streaming) {
+    // Map a larger buffer and continue within it's first region
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    GLsizeiptr size = (GLsizeiptr)render->instance_size * capacity * RN_STREAM_REGIONS;
+    uint32_t vbo;
+    glCreateBuffers(1, &vbo);
+    glNamedBufferStorage(vbo, size, NULL, flags);
+    void* vbo_ptr = glMapNamedBufferRange(vbo, 0, size, flags);
+    if(!vbo_ptr) {
+      // The renderer keeps streaming through the current
+      // buffer, the batch is flushed instead of growing it
+      RN_WARN("Failed to map a larger instance buffer.");
+      glDeleteBuffers(1, &vbo);
+      return false;
+    }
 
-RnGlyph* get_glyph_from_codepoint(RnGlyphCache cache, RnFont font, uint64_t codepoint) {
-  for(uint32_t i = 0; i < cache.len; i++) {
-    if(cache.data[i].codepoint == codepoint
-      && cache.data[i].font_id == font.id) {
-      return &cache.data[i];
+    // Full instances of the current batch live within the mapped region
+    if(!compact && render->n_instances > render->batch_start) {
+      glCopyNamedBufferSubData(render->vbo_instances, vbo, 
+        (GLintptr)render->instance_size * ((size_t)render->region * old_capacity + render->batch_start), 
+        (GLintptr)render->instance_size * render->batch_start, 
+        (GLsizeiptr)render->instance_size * (render->n_instances - render->batch_start));
     }
+
+    // The old buffer is released once the GPU has finished reading it
+    glUnmapNamedBuffer(render->vbo_instances);
+    glDeleteBuffers(1, &render->vbo_instances);
+    for(uint32_t i = 0; i < RN_STREAM_REGIONS; i++) {
+      if(render->region_fences[i]) glDeleteSync((GLsync)render->region_fences[i]);
+      render->region_fences[i] = NULL;
+    }
+    render->vbo_instances = vbo;
+    render->vbo_ptr = vbo_ptr;
+    render->region = 0;
+    if(!compact) {
+      render->instances = (RnInstance*)vbo_ptr;
+    }
+
+    glDeleteVertexArrays(1, &render->vao);
+    render->vao = renderer_create_vao(state, vbo);
+    glBindVertexArray(render->vao);
+  } else {
+    glNamedBufferData(render->vbo_instances, (GLsizeiptr)render->instance_size * capacity, 
+                      NULL, GL_DYNAMIC_DRAW);
   }
-  return NULL;
+
+  render->capacity = capacity;
+  return true;
+}
+
+/* This function fences the region of the instance buffer 
+ * that was written to and moves on to the next region, 
+ * waiting until the GPU has finished reading from it.
+ * */
+void 
+renderer_next_region(RnState* state) {
+  RnRenderState* render = &state->render;
+  render->region_fences[render->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  render->region = (render->region + 1) % RN_STREAM_REGIONS;
+
+  GLsync fence = (GLsync)render->region_fences[render->region];
+  if(fence) {
+    GLenum res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while(res == GL_TIMEOUT_EXPIRED) {
+      res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    glDeleteSync(fence);
+    render->region_fences[render->region] = NULL;
+  }
+
+  // Compact instances are staged on the CPU
+  if(render->format == RN_INSTANCE_FORMAT_FULL) {
+    render->instances = (RnInstance*)render->vbo_ptr + 
+      (size_t)render->region * render->capacity;
+  }
+  render->n_instances = 0;
+  render->batch_start = 0;
+}
+
+/* Creates and maps the upload ring with the first texture 
+ * update. Returns false if buffer storage is not supported or 
+ * the ring could not be mapped, texture updates are then 
+ * copied by the driver directly.
+ * */
+bool 
+renderer_upload_map(RnState* state) {
+  RnUploadRing* ring = &state->render.upload;
+  if(ring->ptr) return true;
+  if(ring->unmapped || !GLAD_GL_VERSION_4_4) return false;
+
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  glCreateBuffers(1, &ring->pbo);
+  glNamedBufferStorage(ring->pbo, RN_UPLOAD_RING_SIZE, NULL, flags);
+  ring->ptr = glMapNamedBufferRange(ring->pbo, 0, RN_UPLOAD_RING_SIZE, flags);
+  if(!ring->ptr) {
+    RN_WARN("Failed to map the texture upload ring, uploading textures directly.");
+    glDeleteBuffers(1, &ring->pbo);
+    ring->pbo = 0;
+    ring->unmapped = true;
+    return false;
+  }
+  ring->segment = 0;
+  ring->offset = 0;
+  return true;
+}
+
+/* Returns the offset (in bytes) within the upload ring at which 
+ * 'size' bytes of a texture update can be staged. Moves on to 
+ * the next segment (fencing the current one) if the update does 
+ * not fit, waiting until the GPU has finished reading from it. 
+ * 'size' must not exceed the size of a segment.
+ * */
+uint32_t 
+renderer_upload_alloc(RnState* state, uint32_t size) {
+  RnUploadRing* ring = &state->render.upload;
+  const uint32_t segment_size = RN_UPLOAD_RING_SIZE / RN_UPLOAD_SEGMENTS;
+
+  // Rows of updates start at cache line boundaries
+  uint32_t offset = (ring->offset + 63) & ~63u;
+  if(offset + size > (ring->segment + 1) * segment_size) {
+    ring->fences[ring->segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring->segment = (ring->segment + 1) % RN_UPLOAD_SEGMENTS;
+    offset = ring->segment * segment_size;
+
+    GLsync fence = (GLsync)ring->fences[ring->segment];
+    if(fence) {
+      GLenum res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      if(res == GL_TIMEOUT_EXPIRED) {
+        ring->waits++;
+      }
+      while(res == GL_TIMEOUT_EXPIRED) {
+        res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+      }
+      glDeleteSync(fence);
+      ring->fences[ring->segment] = NULL;
+    }
+  }
+  ring->offset = offset + size;
+  ring->bytes += size;
+  return offset;
+}
+
+/* This function deletes the OpenGL objects and 
+ * memory of the batch renderer 
+ * */
+void 
+renderer_free(RnState* state) {
+  RnRenderState* render = &state->render;
+  if(render->streaming) {
+    for(uint32_t i = 0; i < RN_STREAM_REGIONS; i++) {
+      if(render->region_fences[i]) glDeleteSync((GLsync)render->region_fences[i]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, render->vbo_instances);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  } 
+  if(!render->streaming || render->format == RN_INSTANCE_FORMAT_COMPACT) {
+    free(render->instances);
+  }
+  if(render->format == RN_INSTANCE_FORMAT_COMPACT) {
+    free(render->packed);
+    free(render->ext);
+    glDeleteBuffers(1, &render->ssbo_ext);
+  }
+  free(render->submitted);
+  render->submitted = NULL;
+
+  RnReorder* reorder = &render->reorder;
+  rn_recorder_free(reorder->frame);
+  free(reorder->order);
+  free(reorder->next);
+  free(reorder->draws);
+  free(reorder->draw_textures);
+  free(reorder->grid);
+  memset(reorder, 0, sizeof(*reorder));
+
+  if(render->timer.enabled) {
+    glDeleteQueries(RN_TIMER_FRAMES * RN_MAX_TIMED_DRAWS, &render->timer.queries[0][0]);
+  }
+
+  RnMultiDraw* md = &render->multi_draw;
+  free(md->commands);
+  free(md->table);
+  free(md->clips);
+  if(md->ibo_commands) {
+    glDeleteBuffers(1, &md->ibo_commands);
+    glDeleteBuffers(1, &md->ssbo_table);
+  }
+  memset(md, 0, sizeof(*md));
+  render->instances = NULL;
+  render->packed = NULL;
+  render->ext = NULL;
+  render->vbo_ptr = NULL;
+
+  free(render->clips.clips);
+  glDeleteBuffers(1, &render->clips.ssbo);
+  memset(&render->clips, 0, sizeof(render->clips));
+
+  for(uint32_t i = 0; i < render->blur.n_targets; i++) {
+    renderer_release_target(state, &render->blur.targets[i]);
+  }
+  free(render->blur.targets);
+  if(render->blur.program) {
+    glDeleteProgram(render->blur.program);
+  }
+  memset(&render->blur, 0, sizeof(render->blur));
+
+  if(render->upload.pbo) {
+    for(uint32_t i = 0; i < RN_UPLOAD_SEGMENTS; i++) {
+      if(render->upload.fences[i]) glDeleteSync((GLsync)render->upload.fences[i]);
+    }
+    glUnmapNamedBuffer(render->upload.pbo);
+    glDeleteBuffers(1, &render->upload.pbo);
+  }
+  memset(&render->upload, 0, sizeof(render->upload));
+
+  free(render->paints.paints);
+  free(render->paints.stops);
+  glDeleteBuffers(1, &render->paints.ssbo_paints);
+  glDeleteBuffers(1, &render->paints.ssbo_stops);
+  memset(&render->paints, 0, sizeof(render->paints));
+
+  for(uint32_t i = 0; i < render->n_targets; i++) {
+    glDeleteFramebuffers(1, &render->targets[i].fbo);
+    renderer_delete_texture(state, &render->targets[i].texture.id);
+  }
+  free(render->targets);
+  render->targets = NULL;
+  render->n_targets = 0;
+
+  glDeleteBuffers(1, &render->vbo_instances);
+  glDeleteBuffers(1, &render->vbo_static);
+  glDeleteBuffers(1, &render->ibo);
+  if(render->bindless) {
+    glDeleteBuffers(1, &render->ssbo_tex_handles);
+  }
+  glDeleteVertexArrays(1, &render->vao);
+  for(uint32_t i = 0; i < RN_SHADER_VARIANT_COUNT; i++) {
+    glDeleteProgram(render->variants[i].shader.id);
+  }
+}
+
+/* This function creates the atlas texture of 
+ * a given font with OpenGL
+ * */
+void create_font_atlas(RnState* state, RnFont* font) {
+  glGenTextures(1, &font->atlas_id);
+  state->atlas_bytes += (uint64_t)font->atlas_w * font->atlas_h * 4;
+  glBindTexture(GL_TEXTURE_2D, font->atlas_id);
+
+  int32_t filter_mode = font->filter_mode == RN_TEX_FILTER_LINEAR ?
+    GL_LINEAR : GL_NEAREST;
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_mode);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mode); 
+
+  glTexImage2D(
+    GL_TEXTURE_2D,
+    0, 
+    GL_RGBA,
+    font->atlas_w,
+    font->atlas_h,
+    0, 
+    GL_RGBA,
+    GL_UNSIGNED_BYTE,
+    NULL);
+
+  // Generate mipmaps
+  glGenerateMipmap(GL_TEXTURE_2D);
+}
+
+/* This function doubles the size of the atlas texture of 
+ * a given font, keeping all glyphs that were already 
+ * uploaded and rescaling the texture coordinates of 
+ * their cached glyphs.
+ * */
+bool 
+grow_font_atlas(RnState* state, RnFont* font) {
+  // Instances in the current batch still reference 
+  // the old atlas with the old texture coordinates
+  if(rn_tex_index_from_tex(state, (RnTexture){.id = font->atlas_id})) {
+    renderer_flush(state, RN_FLUSH_ATLAS);
+    renderer_reset_textures(state);
+  }
+  // And so might queued draws
+  renderer_submit_draws(state);
+
+  uint32_t old_id = font->atlas_id;
+  uint32_t old_w = font->atlas_w, old_h = font->atlas_h;
+
+  font->atlas_w *= 2;
+  font->atlas_h *= 2;
+  create_font_atlas(state, font);
+
+  // Copy the old glyph bitmaps into the new atlas 
+  glCopyImageSubData(old_id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                     font->atlas_id, GL_TEXTURE_2D, 0, 0, 0, 0,
+                     old_w, old_h, 1);
+  renderer_delete_texture(state, &old_id);
+  state->atlas_bytes -= (uint64_t)old_w * old_h * 4;
+  font->atlas_version++;
+  state->atlas_generation++;
+
+  // The glyphs now cover a smaller part of the atlas 
+  float sx = (float)old_w / (float)font->atlas_w;
+  float sy = (float)old_h / (float)font->atlas_h;
+  RnGlyphCache* cache = &state->glyph_cache;
+  for(uint32_t i = 0; i < cache->cap; i++) {
+    if(cache->keys[i] == RN_GLYPH_CACHE_EMPTY || 
+      cache->glyphs[i].font_id != font->id) continue;
+    RnGlyph glyph = cache->glyphs[i];
+    glyph.u0 *= sx; glyph.u1 *= sx;
+    glyph.v0 *= sy; glyph.v1 *= sy;
+    glyph.atlas_id = font->atlas_id;
+    glyph_cache_set(cache, i, glyph);
+  }
+
+  glBindTexture(GL_TEXTURE_2D, font->atlas_id);
+  return true;
+}
+
+
+/* Builds the key of a glyph within the glyph cache. 
+ * FreeType glyph indices always fit into 32 bits. */
+uint64_t 
+glyph_cache_key(uint32_t font_id, uint64_t codepoint) {
+  return ((uint64_t)font_id << 32) | (uint32_t)codepoint;
+}
+
+/* Returns the slot that holds the given key or the 
+ * empty slot at which the key would be inserted. 
+ * The cache must have at least one empty slot. 
+ * */
+uint32_t 
+glyph_cache_probe(const RnGlyphCache* cache, uint64_t key) {
+  // 64-bit finalizer (murmur3) to spread the font ID 
+  // and glyph index bits over the whole hash
+  uint64_t h = key;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  uint32_t mask = cache->cap - 1;
+  uint32_t slot = (uint32_t)h & mask;
+  while(cache->keys[slot] != key && 
+    cache->keys[slot] != RN_GLYPH_CACHE_EMPTY) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/* Doubles the capacity of the glyph cache and 
+ * rehashes all occupied slots. 
+ * */
+void 
+glyph_cache_grow(RnGlyphCache* cache) {
+  RnGlyphCache old = *cache;
+
+  cache->cap = old.cap ? old.cap * 2 : 256;
+  cache->len = 0;
+  cache->keys   = malloc(sizeof(*cache->keys) * cache->cap);
+  cache->hot    = malloc(sizeof(*cache->hot) * cache->cap);
+  cache->glyphs = malloc(sizeof(*cache->glyphs) * cache->cap);
+  if(!cache->keys || !cache->hot || !cache->glyphs) {
+    RN_ERROR("Failed to allocate memory for the glyph cache.");
+    exit(EXIT_FAILURE);
+  }
+  memset(cache->keys, 0xff, sizeof(*cache->keys) * cache->cap);
+
+  for(uint32_t i = 0; i < old.cap; i++) {
+    if(old.keys[i] == RN_GLYPH_CACHE_EMPTY) continue;
+    uint32_t slot = glyph_cache_probe(cache, old.keys[i]);
+    cache->keys[slot]   = old.keys[i];
+    cache->hot[slot]    = old.hot[i];
+    cache->glyphs[slot] = old.glyphs[i];
+    cache->len++;
+  }
+
+  free(old.keys);
+  free(old.hot);
+  free(old.glyphs);
+}
+
+/* Inserts a glyph that is not yet cached and returns 
+ * it's slot. The cache is kept at a load factor <= 0.75.
+ * */
+uint32_t 
+glyph_cache_insert(RnGlyphCache* cache, uint64_t key, RnGlyph glyph) {
+  if((cache->len + 1) * 4 > cache->cap * 3) {
+    glyph_cache_grow(cache);
+  }
+  uint32_t slot = glyph_cache_probe(cache, key);
+  cache->keys[slot] = key;
+  cache->len++;
+  glyph_cache_set(cache, slot, glyph);
+  return slot;
+}
+
+/* Writes the given glyph into an occupied slot, 
+ * updating both the render data and the full glyph. 
+ * */
+void 
+glyph_cache_set(RnGlyphCache* cache, uint32_t slot, RnGlyph glyph) {
+  cache->glyphs[slot] = glyph;
+  cache->hot[slot] = (RnGlyphRenderData){
+    .u0 = glyph.u0, .v0 = glyph.v0, 
+    .u1 = glyph.u1, .v1 = glyph.v1,
+    .width = glyph.width, 
+    .height = glyph.height,
+    .bearing_x = glyph.bearing_x, 
+    .bearing_y = glyph.bearing_y,
+    .advance = glyph.advance
+  };
+}
+
+/* Removes all glyphs of a given font from the cache. 
+ * Open addressing cannot simply clear slots, so the 
+ * remaining glyphs are reinserted into a fresh table. 
+ * */
+void 
+glyph_cache_remove_font(RnGlyphCache* cache, uint32_t font_id) {
+  if(!cache->cap) return;
+  RnGlyphCache old = *cache;
+
+  cache->keys   = malloc(sizeof(*cache->keys) * old.cap);
+  cache->hot    = malloc(sizeof(*cache->hot) * old.cap);
+  cache->glyphs = malloc(sizeof(*cache->glyphs) * old.cap);
+  if(!cache->keys || !cache->hot || !cache->glyphs) {
+    RN_ERROR("Failed to allocate memory for the glyph cache.");
+    exit(EXIT_FAILURE);
+  }
+  cache->len = 0;
+  memset(cache->keys, 0xff, sizeof(*cache->keys) * old.cap);
+
+  for(uint32_t i = 0; i < old.cap; i++) {
+    if(old.keys[i] == RN_GLYPH_CACHE_EMPTY ||
+      old.glyphs[i].font_id == font_id) continue;
+    uint32_t slot = glyph_cache_probe(cache, old.keys[i]);
+    cache->keys[slot]   = old.keys[i];
+    cache->hot[slot]    = old.hot[i];
+    cache->glyphs[slot] = old.glyphs[i];
+    cache->len++;
+  }
+
+  free(old.keys);
+  free(old.hot);
+  free(old.glyphs);
+}
+
+void 
+glyph_cache_free(RnGlyphCache* cache) {
+  free(cache->keys);
+  free(cache->hot);
+  free(cache->glyphs);
+  memset(cache, 0, sizeof(*cache));
+}
+
+/* Returns the slot of a cached glyph or -1 if 
+ * the glyph is not cached. 
+ * */
+int32_t 
+get_glyph_from_codepoint(const RnGlyphCache* cache, RnFont font, uint64_t codepoint) {
+  if(!cache->cap) return -1;
+  uint64_t key = glyph_cache_key(font.id, codepoint);
+  uint32_t slot = glyph_cache_probe(cache, key);
+  return cache->keys[slot] == key ? (int32_t)slot : -1;
 }
 
 
-RnGlyph load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint) {
+RnGlyph load_colr_glyph_from_codepoint(RnState* state, RnFont* font, uint64_t codepoint) {
   RnGlyph glyph = {0};
 
   FT_UInt glyph_index = codepoint; 
@@ -416,7 +3134,7 @@ RnGlyph load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint) {
   }
   FT_GlyphSlot slot = font->face->glyph;
   if (slot->format == FT_GLYPH_FORMAT_BITMAP && slot->bitmap.pixel_mode == FT_PIXEL_MODE_BGRA) {
-    return load_glyph_from_codepoint(font, codepoint, true);
+    return load_glyph_from_codepoint(state, font, codepoint, true);
   }
 
   FT_LayerIterator layer_iterator = {0};
@@ -434,7 +3152,7 @@ RnGlyph load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint) {
   );
 
   if (!has_layers) {
-    return load_glyph_from_codepoint(font, codepoint, false);
+    return load_glyph_from_codepoint(state, font, codepoint, false);
   }
 
   // Select default palette (palette 0)
@@ -549,12 +3267,12 @@ RnGlyph load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint) {
     font->atlas_row_h = 0;
   }
 
-  if (font->atlas_y + glyph_height >= font->atlas_h) {
-    RN_ERROR("Font atlas overflow (vertical). Not handled yet.");
-    free(rgba_data);
-    return glyph;
+  // Grow the atlas if the glyph overflows on the Y
+  while (font->atlas_y + glyph_height >= font->atlas_h) {
+    grow_font_atlas(state, font);
   }
 
+  state->stats.glyphs_rasterized++;
   glTexSubImage2D(
     GL_TEXTURE_2D,
     0,
@@ -588,6 +3306,7 @@ RnGlyph load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint) {
   glyph.advance   = (font->face->glyph->advance.x / 64.0f) * scale; // remember divide by 64!
 
   glyph.font_id = font->id;
+  glyph.atlas_id = font->atlas_id;
   glyph.codepoint = codepoint;
 
   font->atlas_x += glyph_width + 1;
@@ -606,7 +3325,7 @@ RnGlyph load_colr_glyph_from_codepoint(RnFont* font, uint64_t codepoint) {
 * within the atlas 
 * */
 RnGlyph 
-load_glyph_from_codepoint(RnFont* font, uint64_t codepoint, bool colored) {
+load_glyph_from_codepoint(RnState* state, RnFont* font, uint64_t codepoint, bool colored) {
   RnGlyph glyph;
   // Load the glyph with freetype
   uint32_t flags = colored ? FT_LOAD_RENDER | FT_LOAD_COLOR : FT_LOAD_RENDER;
@@ -680,56 +3399,16 @@ load_glyph_from_codepoint(RnFont* font, uint64_t codepoint, bool colored) {
   }
 
   // Resize the atlas if it overflows on the Y
-  if (font->atlas_y + height > font->atlas_h) {
-    int new_w = font->atlas_w * 2;
-    int new_h = font->atlas_h * 2 + 1;
-
-    uint32_t new_id;
-    // Create new texture
-    glGenTextures(1, &new_id);
-    glBindTexture(GL_TEXTURE_2D, new_id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, new_w, new_h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
-
-    // Copy old texture data
-    glBindTexture(GL_TEXTURE_2D, font->atlas_id);
-    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, font->atlas_w, font->atlas_h);
-
-    // Delete old texture
-    glDeleteTextures(1, &font->atlas_id);
-
-    // Set new values
-    font->atlas_id = new_id;
-    font->atlas_w = new_w;
-    font->atlas_h = new_h;
-
-    // Bind the new texture
-    glBindTexture(GL_TEXTURE_2D, font->atlas_id);
-
-    // Initialize new texture data
-    glTexImage2D(
-      GL_TEXTURE_2D,
-      0, 
-      GL_RGBA, 
-      font->atlas_w, 
-      font->atlas_h,
-      0,
-      GL_RGBA,
-      GL_UNSIGNED_BYTE,
-      NULL);
-  }
-
-  // Bind the texture atlas
-  glBindTexture(GL_TEXTURE_2D, font->atlas_id);
+  while (font->atlas_y + height > font->atlas_h) {
+    grow_font_atlas(state, font);
+  }
 
-  // Set texture attributes
-  int32_t filter_mode = font->filter_mode == RN_TEX_FILTER_LINEAR ?
-    GL_LINEAR : GL_NEAREST;
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter_mode);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter_mode);
+  // Bind the texture atlas. Texture attributes are set when the 
+  // atlas is created (they are immutable once a bindless handle exists)
+  glBindTexture(GL_TEXTURE_2D, font->atlas_id);
 
   // Upload the glyph's bitmap to the atlas
+  state->stats.glyphs_rasterized++;
   glTexSubImage2D(
     GL_TEXTURE_2D, 
     0, 
@@ -760,11 +3439,12 @@ load_glyph_from_codepoint(RnFont* font, uint64_t codepoint, bool colored) {
 
   glyph.codepoint = codepoint;
   glyph.font_id = font->id;
+  glyph.atlas_id = font->atlas_id;
 
   glyph.u0 = (float)(font->atlas_x + padding) / (float)font->atlas_w;
   glyph.v0 = (float)(font->atlas_y + padding) / (float)font->atlas_h;
-  glyph.u1 = (float)(font->atlas_x + width)   / (float)font->atlas_w;
-  glyph.v1 = (float)(font->atlas_y + height) / (float)font->atlas_h;
+  glyph.u1 = (float)(font->atlas_x + padding + old_width)  / (float)font->atlas_w;
+  glyph.v1 = (float)(font->atlas_y + padding + old_height) / (float)font->atlas_h;
 
   font->atlas_x += width + 1;
   font->atlas_row_h = (font->atlas_row_h > height) ? font->atlas_row_h : height;
@@ -782,76 +3462,308 @@ load_glyph_from_codepoint(RnFont* font, uint64_t codepoint, bool colored) {
   return glyph;
 }
 
-RnGlyph get_glyph_from_cache(RnGlyphCache* cache, RnFont* font, uint64_t codepoint) {
-  RnGlyph* glyph = get_glyph_from_codepoint(*cache, *font, codepoint);
+/* Returns the slot of a glyph within the cache, loading 
+ * the glyph if it is not cached yet. The slot stays valid 
+ * until the next glyph is inserted. 
+ * */
+uint32_t get_glyph_from_cache(RnState* state, RnFont* font, uint64_t codepoint) {
+  RnGlyphCache* cache = &state->glyph_cache;
+  int32_t slot = get_glyph_from_codepoint(cache, *font, codepoint);
 
-  if(glyph) {
-    return *glyph;
+  if(slot != -1) {
+    cache->hits++;
+    return (uint32_t)slot;
   }
 
-  RnGlyph new_glyph = load_colr_glyph_from_codepoint(font, codepoint);
-  DA_PUSH(cache, new_glyph);
-  return new_glyph; 
+  cache->misses++;
+  RnGlyph new_glyph = load_colr_glyph_from_codepoint(state, font, codepoint);
+  return glyph_cache_insert(cache, glyph_cache_key(font->id, codepoint), new_glyph);
 }
 
-RnHarfbuzzText* get_hb_text_from_str(RnHarfbuzzCache cache, RnFont font, const char* str) {
-  uint64_t hash = djb2_hash((unsigned char*)str);
-  for(uint32_t i = 0; i < cache.len; i++) {
-    if(cache.data[i]->hash == hash && 
-      cache.data[i]->font_id == font.id) {
-      return cache.data[i];
+/* Returns the slot that holds the text with the given 
+ * string & font or the empty slot at which the text 
+ * would be inserted. The cache must have at least one 
+ * empty slot.
+ * */
+uint32_t 
+hb_cache_probe(const RnHarfbuzzCache* cache, uint64_t hash, 
+               uint32_t font_id, const char* str, uint32_t len) {
+  uint32_t mask = cache->cap - 1;
+  uint32_t slot = (uint32_t)hash & mask;
+  while(cache->slots[slot]) {
+    RnHarfbuzzText* text = cache->slots[slot];
+    // Only treat the text as a match if the full 
+    // string is equal, not just the hash
+    if(text->hash == hash && text->font_id == font_id &&
+      text->len == len && memcmp(text->str, str, len) == 0) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+/* Returns the cached text with the given key or NULL if it 
+ * was evicted. Texts of equal hash, font and length cannot be 
+ * told apart without their string, so one of them is returned.
+ * */
+RnHarfbuzzText* 
+hb_cache_find_key(const RnHarfbuzzCache* cache, RnHarfbuzzKey key) {
+  if(!cache->cap) return NULL;
+  uint32_t mask = cache->cap - 1;
+  for(uint32_t slot = (uint32_t)key.hash & mask; cache->slots[slot]; slot = (slot + 1) & mask) {
+    RnHarfbuzzText* text = cache->slots[slot];
+    if(text->hash == key.hash && text->font_id == key.font_id && text->len == key.len) {
+      return text;
     }
   }
   return NULL;
 }
 
-/*
- * This function loads the 
- * text rendering information for a given string 
- * with harfbuzz */
-RnHarfbuzzText*
-load_hb_text_from_str(RnFont font, const char* str) {
-  RnHarfbuzzText* text = malloc(sizeof(*text));
-  text->words  = NULL;
-  text->nwords = 0;
+/* Doubles the capacity of the harfbuzz cache and 
+ * rehashes all cached texts. 
+ * */
+void 
+hb_cache_grow(RnHarfbuzzCache* cache) {
+  RnHarfbuzzText** old = cache->slots;
+  uint32_t old_cap = cache->cap;
+
+  cache->cap = old_cap ? old_cap * 2 : 64;
+  cache->slots = calloc(cache->cap, sizeof(*cache->slots));
+  if(!cache->slots) {
+    RN_ERROR("Failed to allocate memory for the harfbuzz cache.");
+    exit(EXIT_FAILURE);
+  }
+
+  uint32_t mask = cache->cap - 1;
+  for(uint32_t i = 0; i < old_cap; i++) {
+    if(!old[i]) continue;
+    uint32_t slot = (uint32_t)old[i]->hash & mask;
+    while(cache->slots[slot]) slot = (slot + 1) & mask;
+    cache->slots[slot] = old[i];
+  }
+  free(old);
+}
+
+/* Moves a text to the front of the LRU list 
+ * (most recently used). 
+ * */
+void 
+hb_cache_touch(RnHarfbuzzCache* cache, RnHarfbuzzText* text) {
+  if(cache->lru_head == text) return;
+
+  // Unlink the text if it is already in the list
+  if(text->lru_prev) text->lru_prev->lru_next = text->lru_next;
+  if(text->lru_next) text->lru_next->lru_prev = text->lru_prev;
+  if(cache->lru_tail == text) cache->lru_tail = text->lru_prev;
+
+  // Link it in at the front
+  text->lru_prev = NULL;
+  text->lru_next = cache->lru_head;
+  if(cache->lru_head) cache->lru_head->lru_prev = text;
+  cache->lru_head = text;
+  if(!cache->lru_tail) cache->lru_tail = text;
+}
+
+/* Removes a text from the cache and deallocates it.
+ * Slots after the removed one are shifted back so that 
+ * probing never needs tombstones. 
+ * */
+void 
+hb_cache_remove(RnHarfbuzzCache* cache, RnHarfbuzzText* text) {
+  uint32_t mask = cache->cap - 1;
+  uint32_t i = (uint32_t)text->hash & mask;
+  while(cache->slots[i] != text) i = (i + 1) & mask;
+
+  cache->slots[i] = NULL;
+  uint32_t j = i;
+  while(true) {
+    j = (j + 1) & mask;
+    if(!cache->slots[j]) break;
+    uint32_t home = (uint32_t)cache->slots[j]->hash & mask;
+    // Leave the entry where it is if its home slot 
+    // lies cyclically within (i, j]
+    bool in_range = (i <= j) ? (home > i && home <= j) : (home > i || home <= j);
+    if(in_range) continue;
+    cache->slots[i] = cache->slots[j];
+    cache->slots[j] = NULL;
+    i = j;
+  }
+
+  // Unlink from the LRU list
+  if(text->lru_prev) text->lru_prev->lru_next = text->lru_next;
+  else cache->lru_head = text->lru_next;
+  if(text->lru_next) text->lru_next->lru_prev = text->lru_prev;
+  else cache->lru_tail = text->lru_prev;
+
+  cache->bytes -= text->bytes;
+  cache->len--;
+  hb_text_free(text);
+}
+
+/* Evicts the least recently used texts that are not 
+ * pinned until the cache fits into its budget.
+ * */
+void 
+hb_cache_trim(RnHarfbuzzCache* cache) {
+  RnHarfbuzzText* text = cache->lru_tail;
+  while(text && cache->bytes > cache->budget) {
+    RnHarfbuzzText* prev = text->lru_prev;
+    if(!text->pins) {
+      hb_cache_remove(cache, text);
+      cache->evictions++;
+    }
+    text = prev;
+  }
+}
+
+/* Updates the number of bytes a cached text accounts for 
+ * (e.g after the words of the text were split) 
+ * */
+void 
+hb_cache_account(RnHarfbuzzCache* cache, RnHarfbuzzText* text) {
+  size_t bytes = hb_text_bytes(text);
+  cache->bytes = cache->bytes - text->bytes + bytes;
+  text->bytes = bytes;
+}
+
+/* Removes all cached texts of a given font */
+void 
+hb_cache_remove_font(RnHarfbuzzCache* cache, uint32_t font_id) {
+  RnHarfbuzzText* text = cache->lru_head;
+  while(text) {
+    RnHarfbuzzText* next = text->lru_next;
+    if(text->font_id == font_id) {
+      hb_cache_remove(cache, text);
+    }
+    text = next;
+  }
+}
+
+void 
+hb_cache_free(RnHarfbuzzCache* cache) {
+  RnHarfbuzzText* text = cache->lru_head;
+  while(text) {
+    RnHarfbuzzText* next = text->lru_next;
+    hb_text_free(text);
+    text = next;
+  }
+  free(cache->slots);
+  memset(cache, 0, sizeof(*cache));
+}
+
+/* Shapes the string of a given text with harfbuzz,
+ * replacing any previous shaping information. 
+ * */
+void 
+hb_text_shape(RnHarfbuzzText* text, RnFont font) {
+  if(text->buf) {
+    hb_buffer_destroy(text->buf);
+  }
 
   // Create a HarfBuzz buffer and add text
   text->buf = hb_buffer_create();
-  hb_buffer_add_utf8(text->buf, str, -1, 0, -1);
+  hb_buffer_add_utf8(text->buf, text->str, text->len, 0, text->len);
 
   // Shape the text
   hb_buffer_guess_segment_properties(text->buf);
   hb_shape(font.hb_font, text->buf, NULL, 0);
 
-  int32_t len;
   // Retrieve glyph information and positions
   text->glyph_info = hb_buffer_get_glyph_infos(text->buf, &text->glyph_count);
   text->glyph_pos = hb_buffer_get_glyph_positions(text->buf, &text->glyph_count);
 
-  // Generate a hash for the text
-  text->hash = djb2_hash((const unsigned char*)str);
+  // Glyph metrics and word widths depend on the shaping
+  text->highest_bearing = 0.0f;
+  for(uint32_t i = 0; i < text->nwords; i++) {
+    text->words[i].width = 0.0f;
+  }
+}
+
+/* Returns the (approximate) number of bytes that 
+ * a cached text occupies in memory. 
+ * */
+size_t 
+hb_text_bytes(const RnHarfbuzzText* text) {
+  size_t bytes = sizeof(*text) + text->len + 1;
+  bytes += text->glyph_count * (sizeof(hb_glyph_info_t) + sizeof(hb_glyph_position_t));
+  bytes += text->nwords * sizeof(RnWord);
+  for(uint32_t i = 0; i < text->nwords; i++) {
+    bytes += strlen(text->words[i].str) + 1;
+  }
+  return bytes;
+}
 
-  // Set font ID for the harfbuzz text
-  text->font_id = font.id;
+void 
+hb_text_free(RnHarfbuzzText* text) {
+  hb_buffer_destroy(text->buf);
+  for(uint32_t i = 0; i < text->nwords; i++) {
+    free(text->words[i].str);
+  }
+  free(text->words);
+  free(text->str);
+  free(text);
+}
+
+/* Returns the cached text of a given string & font 
+ * or NULL if the text is not cached. 
+ * */
+RnHarfbuzzText* get_hb_text_from_str(const RnHarfbuzzCache* cache, RnFont font, const char* str) {
+  if(!cache->cap) return NULL;
+  uint32_t len = strlen(str);
+  uint64_t hash = djb2_hash((const unsigned char*)str, len) ^ ((uint64_t)font.id * 0x9e3779b97f4a7c15ULL);
+  return cache->slots[hb_cache_probe(cache, hash, font.id, str, len)];
+}
+
+/*
+ * This function loads the 
+ * text rendering information for a given string 
+ * with harfbuzz */
+RnHarfbuzzText*
+load_hb_text_from_str(RnFont font, const char* str) {
+  RnHarfbuzzText* text = calloc(1, sizeof(*text));
 
   // Set rendered string of the text 
-  text->str = malloc(strlen(str) + 1);
-  strcpy(text->str, str);
+  text->len = strlen(str);
+  text->str = malloc(text->len + 1);
+  memcpy(text->str, str, text->len + 1);
 
-  text->highest_bearing = 0.0f;
+  // Generate a hash for the text & font
+  text->hash = djb2_hash((const unsigned char*)str, text->len) ^ ((uint64_t)font.id * 0x9e3779b97f4a7c15ULL);
+
+  // Set font ID for the harfbuzz text
+  text->font_id = font.id;
+
+  hb_text_shape(text, font);
+  text->bytes = hb_text_bytes(text);
 
   return text;
 }
 
 RnHarfbuzzText* get_hb_text_from_cache(RnHarfbuzzCache* cache, RnFont font, const char* str) {
-  RnHarfbuzzText* text = get_hb_text_from_str(*cache, font, str);
+  RnHarfbuzzText* text = get_hb_text_from_str(cache, font, str);
 
   if(text) {
+    cache->hits++;
+    hb_cache_touch(cache, text);
     return text;
   }
+  cache->misses++;
+
+  if((cache->len + 1) * 4 > cache->cap * 3) {
+    hb_cache_grow(cache);
+  }
 
   RnHarfbuzzText* new_text = load_hb_text_from_str(font, str);
-  DA_PUSH(cache, new_text);
+  cache->slots[hb_cache_probe(cache, new_text->hash, font.id, new_text->str, new_text->len)] = new_text;
+  cache->len++;
+  cache->bytes += new_text->bytes;
+  hb_cache_touch(cache, new_text);
+
+  // Never evict the text that is about to be returned
+  new_text->pins++;
+  hb_cache_trim(cache);
+  new_text->pins--;
   return new_text; 
 }
 
@@ -859,12 +3771,11 @@ RnHarfbuzzText* get_hb_text_from_cache(RnHarfbuzzCache* cache, RnFont font, cons
  * Returns the DJB2 hash of a given string
  * */
 uint64_t 
-djb2_hash(const unsigned char *str) {
-  unsigned long hash = 5381;
-  int c;
+djb2_hash(const unsigned char *str, uint32_t len) {
+  uint64_t hash = 5381;
 
-  while ((c = *str++)) {
-    hash = ((hash << 5) + hash) + c;  // hash * 33 + c
+  for(uint32_t i = 0; i < len; i++) {
+    hash = ((hash << 5) + hash) + str[i];  // hash * 33 + c
   }
 
   return hash;
@@ -875,7 +3786,18 @@ djb2_hash(const unsigned char *str) {
 // ===========================================================
 RnState*
 rn_init(uint32_t render_w, uint32_t render_h, RnGLLoader loader) {
-  RnState* state = malloc(sizeof(*state));
+  return rn_init_ex(render_w, render_h, loader, (RnInitConfig){0});
+}
+
+RnState*
+rn_init_ex(uint32_t render_w, uint32_t render_h, RnGLLoader loader, 
+           RnInitConfig config) {
+  // Members that are not initialized explicitly start out zeroed
+  RnState* state = calloc(1, sizeof(*state));
+  if(!state) {
+    RN_ERROR("Failed to allocate memory for the state.");
+    exit(EXIT_FAILURE);
+  }
 
   // Set locale to ensure that unicode is working
   setlocale(LC_ALL, "");
@@ -889,23 +3811,54 @@ rn_init(uint32_t render_w, uint32_t render_h, RnGLLoader loader) {
   // Set default state
   state->render.render_w = render_w;
   state->render.render_h = render_h;
-  state->render.tex_count = 0;
+  state->render.format = config.format;
+  state->render.streaming = !config.disable_streaming;
+
+  // Compact instances index their extended parameters with 16 bits
+  uint32_t limit = config.format == RN_INSTANCE_FORMAT_COMPACT ? 
+    RN_MAX_COMPACT_RENDER_BATCH : UINT32_MAX;
+  uint32_t capacity = config.initial_capacity ? config.initial_capacity : RN_MAX_RENDER_BATCH;
+  uint32_t max_capacity = config.max_capacity > capacity ? config.max_capacity : capacity;
+  if(max_capacity > limit) {
+    RN_WARN("Batches of compact instances are limited to %i instances.", 
+            RN_MAX_COMPACT_RENDER_BATCH);
+    max_capacity = limit;
+  }
+  state->render.capacity = capacity < max_capacity ? capacity : max_capacity;
+  state->render.max_capacity = max_capacity;
+
   state->drawcalls = 0;
+  state->bytes_uploaded = 0;
+  state->culled_instances = 0;
+  state->clipped_instances = 0;
+  state->batch_high_water = 0;
+  state->atlas_bytes = 0;
+  state->stats = (RnFrameStats){0};
+  state->last_stats = (RnFrameStats){0};
+  state->glyph_hits_begin = state->glyph_misses_begin = 0;
+  state->hb_hits_begin = state->hb_misses_begin = 0;
 
   state->cull_start = (vec2s){-1, -1};
   state->cull_end = (vec2s){-1, -1};
 
   // Initializing the renderer
-  renderer_init(state);
+  renderer_init(state, loader, &config);
 
-  // Initializing FreeType
-  if(FT_Init_FreeType(&state->ft) != 0) {
-    RN_ERROR("Failed to initialize FreeType.");
-    return state;
+  // Timer queries of the frames in flight
+  if(config.gpu_timing) {
+    RnGpuTimer* timer = &state->render.timer;
+    timer->enabled = true;
+    glGenQueries(RN_TIMER_FRAMES * RN_MAX_TIMED_DRAWS, &timer->queries[0][0]);
   }
 
-  state->glyph_cache = (RnGlyphCache)DA_INIT;
-  state->hb_cache = (RnHarfbuzzCache)DA_INIT;
+  // FreeType is initialized with the first font
+  state->ft = NULL;
+
+  state->glyph_cache = (RnGlyphCache){0};
+  state->hb_cache = (RnHarfbuzzCache){0};
+  state->hb_cache.budget = RN_HARFBUZZ_CACHE_BUDGET;
+  state->atlas_generation = 0;
+  state->font_id = 0;
 
   state->init = true;
 
@@ -914,12 +3867,17 @@ rn_init(uint32_t render_w, uint32_t render_h, RnGLLoader loader) {
 
 void 
 rn_terminate(RnState* state) {
+  // Delete the OpenGL objects of the renderer
+  renderer_free(state);
+
   // Free glyph- & harfbuzz-caches
-  DA_FREE(&state->glyph_cache);
-  DA_FREE(&state->hb_cache);
+  glyph_cache_free(&state->glyph_cache);
+  hb_cache_free(&state->hb_cache);
 
   // Terminate freetype
-  FT_Done_FreeType(state->ft);
+  if(state->ft) {
+    FT_Done_FreeType(state->ft);
+  }
 
   free(state);
 }
@@ -987,7 +3945,7 @@ rn_load_texture_base_types(
 
 RnTexture
 rn_load_texture_ex(const char* filepath, bool flip, RnTextureFiltering filter) {
-  RnTexture tex;
+  RnTexture tex = {.format = RN_TEX_FORMAT_RGBA8};
   int width, height, channels;
 
   stbi_set_flip_vertically_on_load(flip);
@@ -1031,14 +3989,19 @@ rn_load_texture_ex(const char* filepath, bool flip, RnTextureFiltering filter) {
 RnFont* rn_load_font_ex(RnState* state, const char* filepath, uint32_t size,
                         uint32_t atlas_w, uint32_t atlas_h, uint32_t tab_w,
                         RnTextureFiltering filter_mode, uint32_t face_idx) {
+  if(!size || !freetype_init(state)) return NULL;
+
   RnFont* font = malloc(sizeof(*font));
+  if(!font) {
+    RN_ERROR("Failed to allocate memory for font.");
+    exit(EXIT_FAILURE);
+  }
   FT_Face face;
 
-  if(!size) return NULL;
-
   // Create a new face from the filepath with freetype
   if(FT_New_Face(state->ft, filepath, face_idx, &face)) {
     RN_ERROR("Failed to load font file '%s'.", filepath);
+    free(font);
     return NULL;
   }
   if (FT_Select_Charmap(face, FT_ENCODING_UNICODE)) {
@@ -1066,6 +4029,8 @@ RnFont* rn_load_font_ex(RnState* state, const char* filepath, uint32_t size,
 
     if (FT_Select_Size(face, best_match)) {
       RN_ERROR("Failed to select bitmap strike.");
+      FT_Done_Face(face);
+      free(font);
       return NULL;
     }
     font->selected_strike_size = face->available_sizes[best_match].height;
@@ -1095,7 +4060,7 @@ RnFont* rn_load_font_ex(RnState* state, const char* filepath, uint32_t size,
   font->filter_mode = filter_mode;
 
   // Create the OpenGL font atlas texture 
-  create_font_atlas(font);
+  create_font_atlas(state, font);
 
   // Get the width of the space character within the 
   // font to know how wide tab character should be.
@@ -1143,7 +4108,7 @@ rn_create_font_from_loaded_data_ex(RnState* state, FT_Face face, hb_font_t* hb_f
   font->filter_mode = filter_mode;
 
   // Create the OpenGL font atlas texture 
-  create_font_atlas(font);
+  create_font_atlas(state, font);
 
   // Use the provided space_w instead of calculating it
   font->space_w = space_w;
@@ -1194,24 +4159,109 @@ rn_set_font_size(RnState* state, RnFont* font, uint32_t size) {
   font->line_h = font->face->size->metrics.height / 64.0f;
 } 
 
-void
-rn_free_texture(RnTexture* tex) {
-  // Delete the OpenGL texture
-  glDeleteTextures(1, &tex->id);
-  // Zero-out the texture handle
-  memset(tex, 0, sizeof(*tex));
+void
+rn_free_texture(RnTexture* tex) {
+  // Delete the OpenGL texture
+  glDeleteTextures(1, &tex->id);
+  // Zero-out the texture handle
+  memset(tex, 0, sizeof(*tex));
+}
+
+void
+rn_texture_free(RnState* state, RnTexture* tex) {
+  renderer_delete_texture(state, &tex->id);
+  memset(tex, 0, sizeof(*tex));
+}
+
+RnTexture 
+rn_texture_create(uint32_t width, uint32_t height, RnTextureFormat format) {
+  RnTexture tex = {.width = width, .height = height, .format = format};
+  glCreateTextures(GL_TEXTURE_2D, 1, &tex.id);
+  glTextureStorage2D(tex.id, 1, GL_RGBA8, width, height);
+  glTextureParameteri(tex.id, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTextureParameteri(tex.id, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTextureParameteri(tex.id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTextureParameteri(tex.id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  if(format == RN_TEX_FORMAT_BGRX8) {
+    glTextureParameteri(tex.id, GL_TEXTURE_SWIZZLE_A, GL_ONE);
+  }
+  glClearTexImage(tex.id, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+  return tex;
+}
+
+void 
+rn_texture_update_region(
+  RnState* state, 
+  RnTexture tex, 
+  RnTextureRect rect, 
+  const void* pixels, 
+  uint32_t stride) {
+  // Only the part of the rect within the texture is updated
+  uint32_t x1 = rect.x + rect.width < tex.width ? rect.x + rect.width : tex.width;
+  uint32_t y1 = rect.y + rect.height < tex.height ? rect.y + rect.height : tex.height;
+  if(rect.x >= x1 || rect.y >= y1) return;
+  const uint32_t width = x1 - rect.x, row_size = width * 4;
+  const GLenum format = tex.format == RN_TEX_FORMAT_RGBA8 ? GL_RGBA : GL_BGRA;
+  const uint8_t* src = (const uint8_t*)pixels + (size_t)rect.y * stride + (size_t)rect.x * 4;
+
+  if(!renderer_upload_map(state)) {
+    // The driver copies the pixels before the call returns. 
+    // Strides that are no multiple of a pixel are updated per row.
+    if(stride % 4 == 0) {
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / 4);
+      glTextureSubImage2D(tex.id, 0, rect.x, rect.y, width, y1 - rect.y, 
+                          format, GL_UNSIGNED_BYTE, src);
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    } else {
+      for(uint32_t y = rect.y; y < y1; y++) {
+        glTextureSubImage2D(tex.id, 0, rect.x, y, width, 1, format, GL_UNSIGNED_BYTE, 
+                            src + (size_t)(y - rect.y) * stride);
+      }
+    }
+    state->render.upload.bytes += (uint64_t)(y1 - rect.y) * row_size;
+    return;
+  }
+
+  // Rects that exceed a segment of the ring are 
+  // staged in bands of rows that fit into one 
+  const uint32_t max_rows = (RN_UPLOAD_RING_SIZE / RN_UPLOAD_SEGMENTS) / row_size;
+  for(uint32_t y = rect.y; y < y1;) {
+    uint32_t rows = y1 - y < max_rows ? y1 - y : max_rows;
+    uint32_t offset = renderer_upload_alloc(state, rows * row_size);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, state->render.upload.pbo);
+
+    // The rows are read straight from the source, which is the 
+    // only copy on the CPU even if it is shared memory of a client
+    uint8_t* dst = state->render.upload.ptr + offset;
+    if(stride == row_size) {
+      memcpy(dst, src, (size_t)rows * row_size);
+    } else {
+      for(uint32_t i = 0; i < rows; i++) {
+        memcpy(dst + (size_t)i * row_size, src + (size_t)i * stride, row_size);
+      }
+    }
+    glTextureSubImage2D(tex.id, 0, rect.x, y, width, rows, format, GL_UNSIGNED_BYTE, 
+                        (const void*)(uintptr_t)offset);
+    src += (size_t)rows * stride;
+    y += rows;
+  }
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
 
 void
 rn_free_font(RnState* state, RnFont* font) {
-  (void)state;
+  // Drop the cached glyphs & texts of the font
+  glyph_cache_remove_font(&state->glyph_cache, font->id);
+  hb_cache_remove_font(&state->hb_cache, font->id);
+
   // Cleanup the freetype font handle
   FT_Done_Face(font->face);
   // Destroy the harfbuzz font handle
   hb_font_destroy(font->hb_font);
 
   // Delete the font's atlas texture
-  glDeleteTextures(1, &font->atlas_id);
+  state->atlas_bytes -= (uint64_t)font->atlas_w * font->atlas_h * 4;
+  renderer_delete_texture(state, &font->atlas_id);
 
   free(font);
 }
@@ -1248,18 +4298,78 @@ rn_clear_color_base_types(
 
 void
 rn_begin_batch(RnState* state) {
+  // Clips do not outlive the frame they were pushed in
+  state->render.clips.n_clips = 0;
   renderer_begin(state);
   state->drawcalls = 0;
+  state->bytes_uploaded = 0;
+  state->culled_instances = 0;
+  state->clipped_instances = 0;
+
+  state->stats = (RnFrameStats){.frame = state->stats.frame};
+  state->glyph_hits_begin = state->glyph_cache.hits;
+  state->glyph_misses_begin = state->glyph_cache.misses;
+  state->hb_hits_begin = state->hb_cache.hits;
+  state->hb_misses_begin = state->hb_cache.misses;
 }
 
 void rn_begin(RnState* state) {
   rn_begin_batch(state); 
 }
 
+void 
+rn_push_clip(RnState* state, vec2s pos, vec2s size, float corner_radius) {
+  RnClipStack* stack = &state->render.clips;
+  if(stack->depth >= RN_MAX_CLIP_DEPTH) {
+    RN_WARN("Cannot push more than %i clips.", RN_MAX_CLIP_DEPTH);
+    return;
+  }
+  stack->clips = array_reserve(stack->clips, &stack->clips_cap, 
+                               stack->n_clips + 1, sizeof(RnClip));
+  uint32_t parent = stack->depth > stack->base ? stack->stack[stack->depth - 1] : 0;
+  stack->clips[stack->n_clips++] = (RnClip){
+    .rect = {pos.x, pos.y, pos.x + size.x, pos.y + size.y},
+    .corner_radius = corner_radius,
+    .parent = parent
+  };
+
+  // Cull everything outside of the clip (and of 
+  // the cull box that was set before)
+  vec2s start = state->cull_start, end = state->cull_end;
+  stack->saved_cull_start[stack->depth] = start;
+  stack->saved_cull_end[stack->depth] = end;
+  state->cull_start = (vec2s){
+    start.x != -1 ? fmaxf(start.x, pos.x) : pos.x, 
+    start.y != -1 ? fmaxf(start.y, pos.y) : pos.y
+  };
+  state->cull_end = (vec2s){
+    end.x != -1 ? fminf(end.x, pos.x + size.x) : pos.x + size.x, 
+    end.y != -1 ? fminf(end.y, pos.y + size.y) : pos.y + size.y
+  };
+
+  stack->stack[stack->depth++] = stack->n_clips;
+}
+
+void 
+rn_pop_clip(RnState* state) {
+  RnClipStack* stack = &state->render.clips;
+  if(stack->depth <= stack->base) {
+    RN_WARN("No clip to pop.");
+    return;
+  }
+  stack->depth--;
+  state->cull_start = stack->saved_cull_start[stack->depth];
+  state->cull_end = stack->saved_cull_end[stack->depth];
+}
+
 void
 rn_next_batch(RnState* state) {
-  // End the current batch
-  renderer_flush(state);
+  // End the current batch and draw it, so that state that 
+  // is changed between batches (e.g. the scissor rectangle) 
+  // doesn't apply to draws that are still queued
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_EXPLICIT);
+  renderer_submit_draws(state);
   // Begin a new batch
   renderer_begin(state);
 }
@@ -1267,12 +4377,104 @@ rn_next_batch(RnState* state) {
 RnInstance* rn_add_instance(RnState* state,
     vec2s pos, vec2s size, float rotation, RnColor color,
     uint8_t tex_index) {
-  if(state->render.n_instances  + 1 >= RN_MAX_RENDER_BATCH) {
-    renderer_flush(state);
+  if(!cull_rect(state, &pos, &size, rotation, NULL)) {
+    return NULL;
+  }
+  return push_instance(state, pos, size, rotation, color, tex_index);
+}
+
+void 
+rn_instance_set_shape(RnState* state, RnInstance* inst, uint8_t shape, 
+                      RnColor border_color, float border_width, 
+                      float corner_radius) {
+  if(!inst) return;
+  inst->shape = shape;
+  set_instance_shape(inst, border_color, border_width, corner_radius);
+  // The features are derived from the arguments, as the 
+  // instance may live in write-only mapped memory
+  if(shape != RN_SHAPE_RECT || border_width > 0.0f || corner_radius > 0.0f) {
+    state->render.features |= RN_SHADER_FEATURE_SHAPED;
+  }
+}
+
+/* Appends an instance to the current batch without culling 
+ * it, clipped by the clips of the clip stack it is not 
+ * entirely within */
+RnInstance* 
+push_instance(
+  RnState* state,
+  vec2s pos, 
+  vec2s size, 
+  float rotation, 
+  RnColor color,
+  uint8_t tex_index) {
+  uint32_t clip = 0;
+  if(state->render.clips.depth > state->render.clips.base) {
+    clip = clip_for_bounds(&state->render.clips, rect_bounds(pos, size, rotation));
+  }
+  return push_instance_clipped(state, pos, size, rotation, color, tex_index, clip, NULL);
+}
+
+/* Appends an instance to the current batch without culling 
+ * it, clipped by a given clip of the frame (see 
+ * 'renderer_clip_slot()', 0 = unclipped). The slot of 
+ * the clip is written to 'o_clip_slot' if it's not NULL. 
+ * */
+RnInstance* 
+push_instance_clipped(
+  RnState* state,
+  vec2s pos, 
+  vec2s size, 
+  float rotation, 
+  RnColor color,
+  uint8_t tex_index,
+  uint32_t clip, 
+  uint8_t* o_clip_slot) {
+  RnReorder* reorder = &state->render.reorder;
+  if(state->render.recording) {
+    static_batch_reserve(state, state->render.recording);
+  }
+  else if(reorder->enabled && !reorder->emitting) {
+    // Captured until the instances of the frame are reordered
+    uint32_t tex_id = tex_index ? state->render.textures[tex_index - 1].id : 0;
+    return recorder_push(reorder->frame, pos, size, rotation, color, tex_id, clip);
+  }
+  else if(state->render.n_instances  + 1 >= state->render.capacity && 
+          !renderer_grow(state)) {
+    renderer_flush(state, RN_FLUSH_CAPACITY);
+    renderer_submit_draws(state);
+    if(state->render.streaming) {
+      renderer_next_region(state);
+    }
     state->render.n_instances = 0;
   }
+  uint8_t clip_slot = renderer_clip_slot(state, clip);
+  if(o_clip_slot) *o_clip_slot = clip_slot;
   RnInstance* inst = &state->render.instances[state->render.n_instances++];
+  fill_instance(inst, pos, size, rotation, color, tex_index);
+  inst->clip = clip_slot;
+  if(tex_index) {
+    state->render.features |= RN_SHADER_FEATURE_TEXTURED;
+  }
+  if(rotation != 0.0f) {
+    state->render.features |= RN_SHADER_FEATURE_ROTATED;
+  }
+  if(clip_slot) {
+    state->render.features |= RN_SHADER_FEATURE_CLIPPED;
+  }
+  return inst;
+}
 
+/* Writes the given parameters to an instance with 
+ * the full texture and without rounded corners or border */
+void 
+fill_instance(
+  RnInstance* inst,
+  vec2s pos, 
+  vec2s size, 
+  float rotation, 
+  RnColor color,
+  uint8_t tex_index) {
   inst->size[0] = size.x; inst->size[1] = size.y;
   
   inst->pos[0] = pos.x; inst->pos[1] = pos.y;
@@ -1283,34 +4485,822 @@ RnInstance* rn_add_instance(RnState* state,
   inst->color[3] = color.a;
 
   inst->tex_index = tex_index;
+  inst->layer = 0;
+  inst->clip = 0;
+  inst->shape = RN_SHAPE_RECT;
 
   inst->rotation = rotation;
 
-  return inst;
+  // Sample the whole texture by default
+  inst->uv[0] = 0;     inst->uv[1] = 0;
+  inst->uv[2] = 65535; inst->uv[3] = 65535;
+
+  inst->corner_radius = 0.0f;
+  inst->border_width = 0.0f;
+  memset(inst->border_color, 0, sizeof(inst->border_color));
+}
+
+
+RnStaticBatch* 
+rn_batch_create(void) {
+  RnStaticBatch* batch = calloc(1, sizeof(*batch));
+  if(!batch) {
+    RN_ERROR("Failed to allocate memory for static batch.");
+    exit(EXIT_FAILURE);
+  }
+  batch->dirty = true;
+  return batch;
+}
+
+void 
+rn_batch_free(RnStaticBatch* batch) {
+  if(!batch) return;
+  if(batch->vao) glDeleteVertexArrays(1, &batch->vao);
+  if(batch->vbo) glDeleteBuffers(1, &batch->vbo);
+  if(batch->ssbo_ext) glDeleteBuffers(1, &batch->ssbo_ext);
+  if(batch->ssbo_clips) glDeleteBuffers(1, &batch->ssbo_clips);
+  free(batch->instances);
+  free(batch->segments);
+  free(batch->textures);
+  free(batch->clips);
+  free(batch->glyphs);
+  free(batch);
+}
+
+void 
+rn_batch_mark_dirty(RnStaticBatch* batch) {
+  batch->dirty = true;
+}
+
+void 
+rn_batch_record_begin(RnState* state, RnStaticBatch* batch) {
+  RnRenderState* render = &state->render;
+  if(render->recording) {
+    RN_WARN("A static batch is already being recorded.");
+    return;
+  }
+  // Draw everything that was rendered before
+  renderer_flush(state, RN_FLUSH_STATIC_BATCH);
+  renderer_submit_draws(state);
+  renderer_reset_textures(state);
+  renderer_reset_clips(state);
+
+  batch->saved_instances = render->instances;
+  batch->saved_n_instances = render->n_instances;
+  batch->saved_batch_start = render->batch_start;
+
+  batch->n_instances = 0;
+  batch->n_segments = 0;
+  batch->n_textures = 0;
+  batch->n_clips = 0;
+  batch->n_glyphs = 0;
+  batch->atlas_generation = state->atlas_generation;
+
+  render->recording = batch;
+  render->n_instances = 0;
+  render->batch_start = 0;
+  static_batch_reserve(state, batch);
+}
+
+void 
+rn_batch_record_end(RnState* state, RnStaticBatch* batch) {
+  RnRenderState* render = &state->render;
+  if(render->recording != batch) {
+    RN_WARN("The static batch is not being recorded.");
+    return;
+  }
+  // Close the last segment
+  renderer_flush(state, RN_FLUSH_STATIC_BATCH);
+  batch->n_instances = render->n_instances;
+
+  render->recording = NULL;
+  render->instances = batch->saved_instances;
+  render->n_instances = batch->saved_n_instances;
+  render->batch_start = batch->saved_batch_start;
+  renderer_reset_textures(state);
+  renderer_reset_clips(state);
+
+  // An atlas was recreated while recording
+  if(batch->atlas_generation != state->atlas_generation) {
+    static_batch_patch_glyphs(state, batch);
+  }
+  static_batch_upload(state, batch);
+  batch->dirty = false;
+}
+
+void 
+rn_batch_draw(RnState* state, RnStaticBatch* batch, vec2s offset) {
+  RnRenderState* render = &state->render;
+  if(!batch->n_instances || render->recording) return;
+
+  if(batch->atlas_generation != state->atlas_generation) {
+    static_batch_patch_glyphs(state, batch);
+    static_batch_upload(state, batch);
+  }
+
+  // Keep the order with instances rendered before the batch
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_STATIC_BATCH);
+  renderer_submit_draws(state);
+  renderer_reset_textures(state);
+
+  glBindVertexArray(batch->vao);
+  renderer_set_offset(state, offset);
+  // The segments of the batch are timed together
+  renderer_timer_begin(state);
+  for(uint32_t i = 0; i < batch->n_segments; i++) {
+    const RnStaticBatchSegment* seg = &batch->segments[i];
+    renderer_bind_textures(state, &batch->textures[seg->tex_first], seg->tex_count);
+    renderer_use_variant(state, seg->features, seg->tex_count);
+    if(seg->n_ext) {
+      glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, batch->ssbo_ext, 
+                        seg->ext_offset, sizeof(RnInstanceExt) * seg->n_ext);
+    }
+    if(seg->n_clips) {
+      glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, batch->ssbo_clips, 
+                        seg->clip_offset, sizeof(RnClipData) * seg->n_clips);
+    }
+    glDrawElementsInstancedBaseInstance(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, 
+                                        seg->count, seg->first);
+    state->drawcalls++;
+  }
+  renderer_timer_end(state);
+  state->stats.instances += batch->n_instances;
+  renderer_set_offset(state, (vec2s){0.0f, 0.0f});
+  glBindVertexArray(render->vao);
+}
+
+RnLayer* 
+rn_layer_create(void) {
+  RnLayer* layer = calloc(1, sizeof(*layer));
+  if(!layer) {
+    RN_ERROR("Failed to allocate memory for layer.");
+    exit(EXIT_FAILURE);
+  }
+  layer->dirty = true;
+  return layer;
+}
+
+void 
+rn_layer_free(RnState* state, RnLayer* layer) {
+  if(!layer) return;
+  if(state->render.layer == layer) {
+    rn_end_layer(state, layer);
+  }
+  renderer_release_target(state, &layer->target);
+  free(layer);
+}
+
+void 
+rn_layer_mark_dirty(RnLayer* layer) {
+  layer->dirty = true;
+}
+
+void 
+rn_begin_layer(RnState* state, RnLayer* layer, uint32_t width, uint32_t height) {
+  RnRenderState* render = &state->render;
+  if(render->recording) {
+    RN_WARN("Cannot render to a layer while a static batch is recorded.");
+    return;
+  }
+  if(render->layer == layer) {
+    RN_WARN("The layer is already being rendered to.");
+    return;
+  }
+  if(!width || !height) {
+    RN_WARN("Cannot render to a layer of %ux%u pixels.", width, height);
+    return;
+  }
+  // Draw everything that was rendered before 
+  // into the target that was rendered to
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_LAYER);
+  renderer_submit_draws(state);
+  renderer_reset_textures(state);
+  renderer_reset_clips(state);
+
+  // Keep the target if the layer stays within it's size class
+  if(layer->target.texture.id && 
+     (layer->target.texture.width != layer_size_class(width) || 
+      layer->target.texture.height != layer_size_class(height))) {
+    renderer_release_target(state, &layer->target);
+  }
+  if(!layer->target.texture.id) {
+    layer->target = renderer_acquire_target(state, width, height);
+  }
+  layer->width = width;
+  layer->height = height;
+
+  layer->parent = render->layer;
+  if(render->layer) {
+    layer->saved_fbo = render->layer->target.fbo;
+  } else {
+    int32_t fbo = 0;
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &fbo);
+    layer->saved_fbo = (uint32_t)fbo;
+  }
+  layer->saved_render_w = render->render_w;
+  layer->saved_render_h = render->render_h;
+  layer->saved_cull_start = state->cull_start;
+  layer->saved_cull_end = state->cull_end;
+  layer->saved_clip_base = render->clips.base;
+  layer->saved_n_submitted = render->n_submitted;
+  layer->saved_scissor = glIsEnabled(GL_SCISSOR_TEST);
+
+  // Clips that were pushed before do not apply 
+  // and everything outside of the layer is culled
+  render->clips.base = render->clips.depth;
+  state->cull_start = (vec2s){0.0f, 0.0f};
+  state->cull_end = (vec2s){(float)width, (float)height};
+
+  render->layer = layer;
+  render->render_w = width;
+  render->render_h = height;
+  glBindFramebuffer(GL_FRAMEBUFFER, layer->target.fbo);
+  glDisable(GL_SCISSOR_TEST);
+  glViewport(0, 0, width, height);
+  set_projection_matrix(state);
+  const float clear[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+  glClearNamedFramebufferfv(layer->target.fbo, GL_COLOR, 0, clear);
+}
+
+void 
+rn_end_layer(RnState* state, RnLayer* layer) {
+  RnRenderState* render = &state->render;
+  if(render->layer != layer) {
+    RN_WARN("The layer is not being rendered to.");
+    return;
+  }
+  if(render->clips.depth > render->clips.base) {
+    RN_WARN("%u clips were not popped before the end of the layer.", 
+            render->clips.depth - render->clips.base);
+    while(render->clips.depth > render->clips.base) {
+      rn_pop_clip(state);
+    }
+  }
+  // Draw the content of the layer
+  renderer_merge_recorders(state, layer->saved_n_submitted);
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_LAYER);
+  renderer_submit_draws(state);
+  renderer_reset_textures(state);
+  renderer_reset_clips(state);
+
+  render->layer = layer->parent;
+  render->render_w = layer->saved_render_w;
+  render->render_h = layer->saved_render_h;
+  render->clips.base = layer->saved_clip_base;
+  state->cull_start = layer->saved_cull_start;
+  state->cull_end = layer->saved_cull_end;
+  glBindFramebuffer(GL_FRAMEBUFFER, layer->saved_fbo);
+  if(layer->saved_scissor) {
+    glEnable(GL_SCISSOR_TEST);
+  }
+  glViewport(0, 0, render->render_w, render->render_h);
+  set_projection_matrix(state);
+
+  layer->parent = NULL;
+  layer->dirty = false;
+}
+
+void 
+rn_layer_render(RnState* state, RnLayer* layer, vec2s pos, RnColor color) {
+  if(!layer->target.texture.id) return;
+  // The texture of a layer cannot be sampled while it is rendered to
+  for(const RnLayer* l = state->render.layer; l; l = l->parent) {
+    if(l == layer) {
+      RN_WARN("Cannot render a layer into itself.");
+      return;
+    }
+  }
+  // Only the part of the target that the content covers is sampled
+  RnTexture tex = layer->target.texture;
+  add_textured_instance(state, pos, (vec2s){(float)layer->width, (float)layer->height}, 
+                        0.0f, color, tex, 
+                        (vec4s){0.0f, 0.0f, 
+                        (float)layer->width / tex.width, 
+                        (float)layer->height / tex.height}, true);
+}
+
+/* Creates the compute program of the downsampling and 
+ * upsampling passes of background blurs (dual Kawase filter) */
+void 
+renderer_create_blur_program(RnState* state) {
+  RnBlurState* blur = &state->render.blur;
+  const char* src =
+    "#version 460 core\n"
+    "layout(local_size_x = 8, local_size_y = 8) in;\n"
+    "\n"
+    "layout(binding = 0) uniform sampler2D u_src;\n"
+    "layout(rgba8, binding = 0) writeonly uniform image2D u_dst;\n"
+    "// The size of a texel of the source texture, the size of\n"
+    "// it's content and the size of the written content\n"
+    "uniform vec2 u_texel;\n"
+    "uniform vec2 u_src_size;\n"
+    "uniform ivec2 u_dst_size;\n"
+    "// The distance of the samples (in source texels)\n"
+    "uniform float u_offset;\n"
+    "uniform bool u_upsample;\n"
+    "\n"
+    "// Samples the source, pooled targets are only\n"
+    "// defined within their content\n"
+    "vec4 rn_tap(vec2 p)\n"
+    "{\n"
+    "    return textureLod(u_src, clamp(p, vec2(0.5), u_src_size - 0.5) * u_texel, 0.0);\n"
+    "}\n"
+    "\n"
+    "void main()\n"
+    "{\n"
+    "    ivec2 id = ivec2(gl_GlobalInvocationID.xy);\n"
+    "    if (any(greaterThanEqual(id, u_dst_size))) {\n"
+    "        return;\n"
+    "    }\n"
+    "    vec2 p = (vec2(id) + 0.5) * u_src_size / vec2(u_dst_size);\n"
+    "    float o = u_offset;\n"
+    "    vec4 sum;\n"
+    "    if (u_upsample) {\n"
+    "        sum  = rn_tap(p + vec2(-2.0 * o, 0.0));\n"
+    "        sum += rn_tap(p + vec2( 2.0 * o, 0.0));\n"
+    "        sum += rn_tap(p + vec2(0.0, -2.0 * o));\n"
+    "        sum += rn_tap(p + vec2(0.0,  2.0 * o));\n"
+    "        sum += rn_tap(p + vec2(-o, -o)) * 2.0;\n"
+    "        sum += rn_tap(p + vec2( o, -o)) * 2.0;\n"
+    "        sum += rn_tap(p + vec2(-o,  o)) * 2.0;\n"
+    "        sum += rn_tap(p + vec2( o,  o)) * 2.0;\n"
+    "        sum /= 12.0;\n"
+    "    } else {\n"
+    "        sum  = rn_tap(p) * 4.0;\n"
+    "        sum += rn_tap(p + vec2(-o, -o));\n"
+    "        sum += rn_tap(p + vec2( o, -o));\n"
+    "        sum += rn_tap(p + vec2(-o,  o));\n"
+    "        sum += rn_tap(p + vec2( o,  o));\n"
+    "        sum /= 8.0;\n"
+    "    }\n"
+    "    imageStore(u_dst, id, sum);\n"
+    "}\n";
+  blur->program = create_compute_program(src);
+  blur->texel_loc = glGetUniformLocation(blur->program, "u_texel");
+  blur->src_size_loc = glGetUniformLocation(blur->program, "u_src_size");
+  blur->dst_size_loc = glGetUniformLocation(blur->program, "u_dst_size");
+  blur->offset_loc = glGetUniformLocation(blur->program, "u_offset");
+  blur->upsample_loc = glGetUniformLocation(blur->program, "u_upsample");
+}
+
+/* Runs a downsampling or upsampling pass of a background 
+ * blur from the content of 'src' into the content of 'dst' */
+void 
+renderer_blur_pass(
+  RnState* state, 
+  const RnRenderTarget* src, 
+  uint32_t src_w, 
+  uint32_t src_h, 
+  const RnRenderTarget* dst, 
+  uint32_t dst_w, 
+  uint32_t dst_h, 
+  float offset, 
+  bool upsample) {
+  RnBlurState* blur = &state->render.blur;
+  glProgramUniform2f(blur->program, blur->texel_loc, 
+                     1.0f / src->texture.width, 1.0f / src->texture.height);
+  glProgramUniform2f(blur->program, blur->src_size_loc, (float)src_w, (float)src_h);
+  glProgramUniform2i(blur->program, blur->dst_size_loc, (int32_t)dst_w, (int32_t)dst_h);
+  glProgramUniform1f(blur->program, blur->offset_loc, offset);
+  glProgramUniform1i(blur->program, blur->upsample_loc, upsample);
+  glBindTextureUnit(0, src->texture.id);
+  glBindImageTexture(0, dst->texture.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+  glDispatchCompute((dst_w + 7) / 8, (dst_h + 7) / 8, 1);
+  // The next pass or the composited instance samples the result
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+void 
+rn_background_blur_render(
+  RnState* state, 
+  vec2s pos, 
+  vec2s size, 
+  float radius,
+  float corner_radius,
+  RnColor color) {
+  RnRenderState* render = &state->render;
+  if(render->recording) {
+    RN_WARN("Cannot blur the background while a static batch is recorded.");
+    return;
+  }
+  if(radius <= 0.0f) return;
+
+  // Only the visible part of the rect is blurred, the captured 
+  // area extends by the radius so that the edges are blurred 
+  // with their surroundings
+  float x0 = fmaxf(pos.x, 0.0f), y0 = fmaxf(pos.y, 0.0f);
+  float x1 = fminf(pos.x + size.x, (float)render->render_w);
+  float y1 = fminf(pos.y + size.y, (float)render->render_h);
+  if(x1 <= x0 || y1 <= y0) return;
+  int32_t cx0 = (int32_t)fmaxf(floorf(x0 - radius), 0.0f);
+  int32_t cy0 = (int32_t)fmaxf(floorf(y0 - radius), 0.0f);
+  int32_t cx1 = (int32_t)fminf(ceilf(x1 + radius), (float)render->render_w);
+  int32_t cy1 = (int32_t)fminf(ceilf(y1 + radius), (float)render->render_h);
+  uint32_t cw = cx1 - cx0, ch = cy1 - cy0;
+
+  // Draw everything that is behind the blur, recorders that 
+  // were submitted to the current target included
+  renderer_merge_recorders(state, render->layer ? render->layer->saved_n_submitted : 0);
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_BLUR);
+  renderer_submit_draws(state);
+  renderer_reset_textures(state);
+  renderer_reset_clips(state);
+
+  if(!render->blur.program) {
+    renderer_create_blur_program(state);
+  }
+
+  // Every pass halves the resolution, the offset of the 
+  // samples covers the rest of the radius
+  uint32_t passes = 1;
+  while(passes < RN_BLUR_MAX_PASSES && radius > (float)(2u << passes)) {
+    passes++;
+  }
+  float offset = radius / (float)(1u << passes);
+
+  // The captured area and it's downsampled levels
+  render->blur.targets = array_reserve(render->blur.targets, &render->blur.targets_cap, 
+                                       render->blur.n_targets + passes + 1, 
+                                       sizeof(RnRenderTarget));
+  RnRenderTarget* levels = &render->blur.targets[render->blur.n_targets];
+  uint32_t widths[RN_BLUR_MAX_PASSES + 1], heights[RN_BLUR_MAX_PASSES + 1];
+  for(uint32_t i = 0; i <= passes; i++) {
+    widths[i] = i ? (widths[i - 1] + 1) / 2 : cw;
+    heights[i] = i ? (heights[i - 1] + 1) / 2 : ch;
+    levels[i] = renderer_acquire_target(state, widths[i], heights[i]);
+  }
+  render->blur.n_targets += passes + 1;
+
+  // Copy the area from the rendered target, layers 
+  // are rendered with the Y axis flipped 
+  int32_t src_fbo = 0;
+  if(render->layer) {
+    src_fbo = (int32_t)render->layer->target.fbo;
+  } else {
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &src_fbo);
+  }
+  int32_t sy0 = render->layer ? cy0 : (int32_t)render->render_h - cy1;
+  bool scissor = glIsEnabled(GL_SCISSOR_TEST);
+  glDisable(GL_SCISSOR_TEST);
+  glBlitNamedFramebuffer((uint32_t)src_fbo, levels[0].fbo, 
+                         cx0, sy0, cx1, sy0 + (int32_t)ch, 
+                         0, 0, cw, ch, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+  if(scissor) {
+    glEnable(GL_SCISSOR_TEST);
+  }
+
+  renderer_timer_begin(state);
+  glUseProgram(render->blur.program);
+  for(uint32_t i = 1; i <= passes; i++) {
+    renderer_blur_pass(state, &levels[i - 1], widths[i - 1], heights[i - 1], 
+                       &levels[i], widths[i], heights[i], offset, false);
+  }
+  for(uint32_t i = passes; i > 1; i--) {
+    renderer_blur_pass(state, &levels[i], widths[i], heights[i], 
+                       &levels[i - 1], widths[i - 1], heights[i - 1], offset, true);
+  }
+  renderer_timer_end(state);
+  // Bind the batch shader again with the next draw
+  render->variant = UINT32_MAX;
+
+  // Composite the first downsampled level, which holds the 
+  // blurred area at half the resolution
+  const RnTexture tex = levels[1].texture;
+  float scale_x = (float)widths[1] / cw / tex.width;
+  float scale_y = (float)heights[1] / ch / tex.height;
+  vec4s uv = {(x0 - cx0) * scale_x, (y0 - cy0) * scale_y, 
+              (x1 - cx0) * scale_x, (y1 - cy0) * scale_y};
+  if(!render->layer) {
+    // Rows of the display are captured bottom to top
+    float v_end = ch * scale_y;
+    uv = (vec4s){uv.x, v_end - uv.y, uv.z, v_end - uv.w};
+  }
+  RnInstance* inst = add_textured_instance(state, (vec2s){x0, y0}, 
+                                           (vec2s){x1 - x0, y1 - y0}, 0.0f, 
+                                           color, tex, uv, true);
+  if(inst && corner_radius > 0.0f) {
+    set_instance_shape(inst, RN_NO_COLOR, 0.0f, corner_radius);
+    render->features |= RN_SHADER_FEATURE_SHAPED;
+  }
+}
+
+RnRecorder* 
+rn_recorder_create(RnState* state) {
+  RnRecorder* rec = calloc(1, sizeof(*rec));
+  if(!rec) {
+    RN_ERROR("Failed to allocate memory for recorder.");
+    exit(EXIT_FAILURE);
+  }
+  rec->state = state;
+  return rec;
+}
+
+void 
+rn_recorder_free(RnRecorder* rec) {
+  if(!rec) return;
+  free(rec->instances);
+  free(rec->tex_ids);
+  free(rec->clip_ids);
+  free(rec->texts);
+  free(rec->strings);
+  free(rec->glyphs);
+  free(rec->hb_hits);
+  free(rec);
+}
+
+void 
+rn_recorder_begin(RnRecorder* rec) {
+  rec->n_instances = 0;
+  rec->n_texts = 0;
+  rec->strings_len = 0;
+  rec->n_glyphs = 0;
+  rec->n_hb_hits = 0;
+  rec->culled_instances = 0;
+  rec->clipped_instances = 0;
+  rec->cull_start = rec->state->cull_start;
+  rec->cull_end = rec->state->cull_end;
+  rec->atlas_generation = rec->state->atlas_generation;
+}
+
+void 
+rn_recorder_rect_render_ex(
+  RnRecorder* rec, 
+  vec2s pos, 
+  vec2s size, 
+  float rotation_angle, 
+  RnColor color, 
+  RnColor border_color, 
+  float border_width, 
+  float corner_radius) {
+  vec4s uv = {0.0f, 0.0f, 1.0f, 1.0f};
+  bool clip = corner_radius <= 0.0f && border_width <= 0.0f;
+  if(!cull_rect_box(rec->cull_start, rec->cull_end, &pos, &size, rotation_angle, 
+                    clip ? &uv : NULL, &rec->culled_instances, &rec->clipped_instances)) {
+    return;
+  }
+  RnInstance* inst = recorder_push(rec, pos, size, rotation_angle, color, 0, 0);
+  set_instance_shape(inst, border_color, border_width, corner_radius);
+}
+
+void 
+rn_recorder_rect_render(
+  RnRecorder* rec, 
+  vec2s pos, 
+  vec2s size, 
+  RnColor color) {
+  rn_recorder_rect_render_ex(rec, pos, size, 0.0f, color, RN_NO_COLOR, 0.0f, 0.0f);
+}
+
+void 
+rn_recorder_image_render_ex(
+  RnRecorder* rec, 
+  vec2s pos, 
+  float rotation_angle,
+  RnColor color, 
+  RnTexture tex,
+  RnColor border_color,
+  float border_width, 
+  float corner_radius) {
+  vec2s size = {tex.width, tex.height};
+  vec4s uv = {0.0f, 0.0f, 1.0f, 1.0f};
+  bool clip = corner_radius <= 0.0f && border_width <= 0.0f;
+  if(!cull_rect_box(rec->cull_start, rec->cull_end, &pos, &size, rotation_angle, 
+                    clip ? &uv : NULL, &rec->culled_instances, &rec->clipped_instances)) {
+    return;
+  }
+  RnInstance* inst = recorder_push(rec, pos, size, rotation_angle, color, tex.id, 0);
+  set_instance_uv(inst, uv);
+  set_instance_shape(inst, border_color, border_width, corner_radius);
+}
+
+void 
+rn_recorder_image_render(
+  RnRecorder* rec, 
+  vec2s pos, 
+  RnColor color, 
+  RnTexture tex) {
+  rn_recorder_image_render_ex(rec, pos, 0.0f, color, tex, RN_NO_COLOR, 0.0f, 0.0f);
+}
+
+void 
+rn_recorder_text_render(
+  RnRecorder* rec, 
+  const char* text, 
+  RnFont* font, 
+  vec2s pos, 
+  RnColor color) {
+  // Lay the text out right away if it is fully cached
+  RnHarfbuzzText* hb_text = get_hb_text_from_str(&rec->state->hb_cache, *font, text);
+  RnTextProps props;
+  if(hb_text && text_layout(rec->state, rec, hb_text, text, font, pos, color, 0.0f, true, &props)) {
+    // Only the key is kept, the GL thread may evict the 
+    // text before the recorder is submitted
+    rec->hb_hits = array_reserve(rec->hb_hits, &rec->hb_hits_cap, 
+                                 rec->n_hb_hits + 1, sizeof(RnHarfbuzzKey));
+    rec->hb_hits[rec->n_hb_hits++] = (RnHarfbuzzKey){
+      .hash = hb_text->hash, .font_id = hb_text->font_id, .len = hb_text->len};
+    return;
+  }
+
+  // Otherwise it is rendered during the merge
+  uint32_t len = strlen(text) + 1;
+  rec->strings = array_reserve(rec->strings, &rec->strings_cap, 
+                               rec->strings_len + len, sizeof(char));
+  memcpy(rec->strings + rec->strings_len, text, len);
+
+  rec->texts = array_reserve(rec->texts, &rec->texts_cap, 
+                             rec->n_texts + 1, sizeof(RnRecordedText));
+  rec->texts[rec->n_texts++] = (RnRecordedText){
+    .first = rec->n_instances, 
+    .str_offset = rec->strings_len,
+    .font = font, 
+    .pos = pos,
+    .color = {color.r, color.g, color.b, color.a},
+    .line_height = 0.0f
+  };
+  rec->strings_len += len;
+}
+
+void 
+rn_submit_recorder(RnState* state, RnRecorder* rec) {
+  RnRenderState* render = &state->render;
+  render->submitted = array_reserve(render->submitted, &render->submitted_cap, 
+                                    render->n_submitted + 1, sizeof(RnRecorder*));
+  render->submitted[render->n_submitted++] = rec;
+
+  // Keep the texts the recorder used from being evicted
+  for(uint32_t i = 0; i < rec->n_hb_hits; i++) {
+    RnHarfbuzzText* text = hb_cache_find_key(&state->hb_cache, rec->hb_hits[i]);
+    if(text) {
+      hb_cache_touch(&state->hb_cache, text);
+    }
+  }
+}
+
+void 
+rn_set_multi_draw(RnState* state, bool multi_draw) {
+  RnMultiDraw* md = &state->render.multi_draw;
+  if(md->enabled == multi_draw) return;
+  if(multi_draw && !GLAD_GL_VERSION_4_3) {
+    RN_WARN("Multi-draw mode requires OpenGL 4.3.");
+    return;
+  }
+  if(multi_draw) {
+    if(!md->ibo_commands) {
+      glCreateBuffers(1, &md->ibo_commands);
+      glCreateBuffers(1, &md->ssbo_table);
+    }
+    // Draw the current batch as it was rendered
+    renderer_flush(state, RN_FLUSH_EXPLICIT);
+  } else {
+    rn_submit_draws(state);
+  }
+  md->enabled = multi_draw;
+}
+
+void 
+rn_submit_draws(RnState* state) {
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_EXPLICIT);
+  renderer_submit_draws(state);
+}
+
+RnFrameStats 
+rn_get_frame_stats(const RnState* state) {
+  return state->last_stats;
+}
+
+void 
+rn_recorder_set_layer(RnRecorder* rec, uint8_t layer) {
+  rec->layer = layer;
+}
 
+void 
+rn_set_reorder(RnState* state, bool reorder) {
+  RnReorder* r = &state->render.reorder;
+  if(r->enabled == reorder) return;
+  if(reorder) {
+    if(!r->frame) {
+      r->frame = rn_recorder_create(state);
+    }
+    rn_recorder_begin(r->frame);
+    r->frame->layer = r->layer;
+  } else {
+    // Instances captured so far keep their order 
+    // with instances that are rendered afterwards
+    renderer_emit_reordered(state);
+  }
+  r->enabled = reorder;
 }
 
+void 
+rn_set_layer(RnState* state, uint8_t layer) {
+  RnReorder* r = &state->render.reorder;
+  r->layer = layer;
+  if(r->frame) {
+    r->frame->layer = layer;
+  }
+}
 
 uint8_t rn_tex_index_from_tex(RnState* state, RnTexture tex) {
-  uint8_t tex_index = 0; 
-  for (uint32_t i = 0; i < state->render.tex_count; ++i) {
-    if (tex.id == state->render.textures[i].id) {
-      tex_index = i + 1;
-      break;
+  RnRenderState* render = &state->render;
+  uint32_t mask = RN_TEX_SLOT_TABLE_SIZE - 1;
+  uint32_t i = (tex.id * 2654435761u) & mask;
+  // Entries of older generations terminate the probe
+  while(render->tex_slots[i].gen == render->tex_slots_gen) {
+    if(render->tex_slots[i].id == tex.id) {
+      return (uint8_t)render->tex_slots[i].slot;
     }
+    i = (i + 1) & mask;
   }
-  return tex_index;
+  return 0;
 }
 
 void
 rn_add_tex_to_batch(RnState* state, RnTexture tex) {
-  state->render.textures[state->render.tex_count++] = tex;
-  state->render.tex_index++;
+  RnRenderState* render = &state->render;
+  // Start a new batch if all texture slots are used
+  if(render->tex_count >= render->max_textures) {
+    renderer_flush(state, RN_FLUSH_TEXTURES);
+    renderer_reset_textures(state);
+  }
+  render->textures[render->tex_count++] = tex;
+  render->tex_index++;
+
+  uint32_t mask = RN_TEX_SLOT_TABLE_SIZE - 1;
+  uint32_t i = (tex.id * 2654435761u) & mask;
+  while(render->tex_slots[i].gen == render->tex_slots_gen) {
+    i = (i + 1) & mask;
+  }
+  render->tex_slots[i] = (RnTexSlot){
+    .id = tex.id, 
+    .gen = render->tex_slots_gen, 
+    .slot = render->tex_count
+  };
 }
 
 void
 rn_end_batch(RnState* state) {
-  renderer_flush(state);
+  while(state->render.layer) {
+    RN_WARN("A layer was not ended before the end of the frame.");
+    rn_end_layer(state, state->render.layer);
+  }
+  if(state->render.clips.depth) {
+    RN_WARN("%u clips were not popped before the end of the frame.", 
+            state->render.clips.depth);
+    while(state->render.clips.depth) {
+      rn_pop_clip(state);
+    }
+  }
+  renderer_merge_recorders(state, 0);
+  renderer_emit_reordered(state);
+  renderer_flush(state, RN_FLUSH_END);
+  renderer_submit_draws(state);
+  // Start the next frame in a fresh region 
+  if(state->render.streaming && state->render.n_instances) {
+    renderer_next_region(state);
+  }
+  renderer_timer_end_frame(state);
+  // The blurs of the frame were drawn
+  for(uint32_t i = 0; i < state->render.blur.n_targets; i++) {
+    renderer_release_target(state, &state->render.blur.targets[i]);
+  }
+  state->render.blur.n_targets = 0;
+  renderer_trim_targets(state);
+
+  RnFrameStats* stats = &state->stats;
+  stats->drawcalls = state->drawcalls;
+  stats->bytes_uploaded = state->bytes_uploaded;
+  stats->texture_bytes_uploaded = state->render.upload.bytes;
+  stats->texture_upload_waits = state->render.upload.waits;
+  state->render.upload.bytes = 0;
+  state->render.upload.waits = 0;
+  stats->culled_instances = state->culled_instances;
+  stats->clipped_instances = state->clipped_instances;
+  stats->atlas_bytes = state->atlas_bytes;
+  stats->glyph_cache_hits = (uint32_t)(state->glyph_cache.hits - state->glyph_hits_begin);
+  stats->glyph_cache_misses = (uint32_t)(state->glyph_cache.misses - state->glyph_misses_begin);
+  stats->shaping_cache_hits = (uint32_t)(state->hb_cache.hits - state->hb_hits_begin);
+  stats->shaping_cache_misses = (uint32_t)(state->hb_cache.misses - state->hb_misses_begin);
+
+  const RnGpuTimer* timer = &state->render.timer;
+  stats->gpu_valid = timer->has_result;
+  if(timer->has_result) {
+    stats->gpu_frame = timer->result_frame;
+    stats->gpu_draws = timer->n_results;
+    stats->gpu_ms = 0.0f;
+    for(uint32_t i = 0; i < timer->n_results; i++) {
+      stats->gpu_draw_ms[i] = timer->results_ms[i];
+      stats->gpu_ms += timer->results_ms[i];
+    }
+  }
+
+  state->last_stats = *stats;
+  stats->frame++;
 }
 
 void 
@@ -1320,36 +5310,33 @@ rn_end(RnState* state) {
 
 void
 rn_reload_font_glyph_cache(RnState* state, RnFont* font) {
-  RnGlyph* glyph = NULL, *tmp = NULL;
-
-  font->atlas_w = 1024;
-  font->atlas_h = 1024;
   font->atlas_row_h = 0;
   font->atlas_x = 0;
   font->atlas_y = 0;
 
-  glDeleteTextures(1, &font->atlas_id);
-  create_font_atlas(font);
-
-  for(uint32_t i = 0; i < state->glyph_cache.len; i++) {
-    RnGlyph* glyph = &state->glyph_cache.data[i];
-    if(glyph->font_id == font->id) {
-      *glyph = load_colr_glyph_from_codepoint(font, glyph->codepoint);
-    }
+  state->atlas_bytes -= (uint64_t)font->atlas_w * font->atlas_h * 4;
+  renderer_delete_texture(state, &font->atlas_id);
+  font->atlas_w = 1024;
+  font->atlas_h = 1024;
+  create_font_atlas(state, font);
+
+  RnGlyphCache* cache = &state->glyph_cache;
+  for(uint32_t i = 0; i < cache->cap; i++) {
+    if(cache->keys[i] == RN_GLYPH_CACHE_EMPTY || 
+      cache->glyphs[i].font_id != font->id) continue;
+    glyph_cache_set(cache, i, 
+                    load_colr_glyph_from_codepoint(state, font, cache->glyphs[i].codepoint));
   }
 }
 
 void 
 rn_reload_font_harfbuzz_cache(RnState* state, RnFont font) {
-  RnHarfbuzzText* text = NULL, *tmp = NULL;
-  for(uint32_t i = 0; i < state->hb_cache.len; i++) {
-    RnHarfbuzzText* text = state->hb_cache.data[i];
+  // Reshape the texts in place so that their 
+  // position within the cache stays the same
+  for(RnHarfbuzzText* text = state->hb_cache.lru_head; text; text = text->lru_next) {
     if(text->font_id == font.id) {
-      hb_buffer_destroy(text->buf);
-      char* tmp_str = strdup(text->str);
-      free(text);
-      text = load_hb_text_from_str(font, tmp_str); 
-      free(tmp_str);
+      hb_text_shape(text, font);
+      hb_cache_account(&state->hb_cache, text);
     }
   }
 }
@@ -1364,7 +5351,18 @@ rn_rect_render_ex(
   RnColor border_color, 
   float border_width,
   float corner_radius) {
-  rn_add_instance(state, pos, size, rotation_angle, color,0); 
+  // Plain rects are clipped to the cull box, the shape 
+  // of rounded or bordered rects would change
+  vec4s uv = {0.0f, 0.0f, 1.0f, 1.0f};
+  bool clip = corner_radius <= 0.0f && border_width <= 0.0f;
+  if(!cull_rect(state, &pos, &size, rotation_angle, clip ? &uv : NULL)) {
+    return;
+  }
+  RnInstance* inst = push_instance(state, pos, size, rotation_angle, color, 0); 
+  set_instance_shape(inst, border_color, border_width, corner_radius);
+  if(!clip) {
+    state->render.features |= RN_SHADER_FEATURE_SHAPED;
+  }
 }
 
 void rn_rect_render(
@@ -1393,6 +5391,406 @@ void rn_rect_render_base_types(
                            RN_NO_COLOR, 0.0f, 0.0f);
 }
 
+/* Adds the instance of a line from 'p0' to 'p1' with 
+ * the given round caps (RN_SHAPE_ROUND_START/END).
+ *
+ * Returns NULL if the line was culled.
+ * */
+RnInstance* 
+line_instance(
+  RnState* state, 
+  vec2s p0, 
+  vec2s p1, 
+  float width, 
+  RnColor color, 
+  uint8_t caps) {
+  if(width <= 0.0f) return NULL;
+  vec2s d = {p1.x - p0.x, p1.y - p0.y};
+  float len = sqrtf(d.x * d.x + d.y * d.y);
+  float c = len > 0.0f ? d.x / len : 1.0f;
+  float s = len > 0.0f ? -d.y / len : 0.0f;
+
+  // The quad covers the caps and the anti-aliased edges 
+  // (lines thinner than a pixel are one pixel wide)
+  float half_h = fmaxf(width * 0.5f, 0.5f) + RN_SHAPE_AA_PAD;
+  vec2s pos = {p0.x - half_h * (c + s), p0.y + half_h * (s - c)};
+  vec2s size = {len + half_h * 2.0f, half_h * 2.0f};
+  RnInstance* inst = rn_add_instance(state, pos, size, atan2f(s, c), color, 0);
+  if(!inst) return NULL;
+  inst->shape = RN_SHAPE_LINE | caps;
+  inst->corner_radius = width * 0.5f;
+  state->render.features |= RN_SHADER_FEATURE_SHAPED;
+  return inst;
+}
+
+void rn_line_render_ex(
+  RnState* state, 
+  vec2s p0, 
+  vec2s p1, 
+  float width,
+  RnColor color,
+  RnLineCap cap) {
+  if(cap == RN_LINE_CAP_SQUARE) {
+    // Square caps are butt caps of an extended line
+    vec2s d = {p1.x - p0.x, p1.y - p0.y};
+    float len = sqrtf(d.x * d.x + d.y * d.y);
+    if(len > 0.0f) {
+      vec2s ext = {d.x / len * width * 0.5f, d.y / len * width * 0.5f};
+      p0 = (vec2s){p0.x - ext.x, p0.y - ext.y};
+      p1 = (vec2s){p1.x + ext.x, p1.y + ext.y};
+    }
+  }
+  line_instance(state, p0, p1, width, color, cap == RN_LINE_CAP_ROUND ? 
+                RN_SHAPE_ROUND_START | RN_SHAPE_ROUND_END : 0);
+}
+
+void rn_line_render(
+  RnState* state, 
+  vec2s p0, 
+  vec2s p1, 
+  float width,
+  RnColor color) {
+  rn_line_render_ex(state, p0, p1, width, color, RN_LINE_CAP_BUTT);
+}
+
+void rn_polyline_render_ex(
+  RnState* state, 
+  const vec2s* points, 
+  uint32_t n_points, 
+  float width,
+  RnColor color,
+  RnLineCap cap, 
+  bool closed) {
+  if(n_points < 2) return;
+  uint32_t n_segments = closed ? n_points : n_points - 1;
+  for(uint32_t i = 0; i < n_segments; i++) {
+    vec2s p0 = points[i], p1 = points[(i + 1) % n_points];
+    bool first = !closed && i == 0, last = !closed && i == n_segments - 1;
+
+    // Every segment covers the join with the next segment with 
+    // a round cap, the ends of open polylines get the given cap. 
+    // The cap overlaps the next segment, so translucent joins 
+    // are blended twice (see the docs of this function).
+    uint8_t caps = last ? 0 : RN_SHAPE_ROUND_END;
+    if(cap == RN_LINE_CAP_ROUND) {
+      if(first) caps |= RN_SHAPE_ROUND_START;
+      if(last) caps |= RN_SHAPE_ROUND_END;
+    }
+    else if(cap == RN_LINE_CAP_SQUARE && (first || last)) {
+      vec2s d = {p1.x - p0.x, p1.y - p0.y};
+      float len = sqrtf(d.x * d.x + d.y * d.y);
+      if(len > 0.0f) {
+        vec2s ext = {d.x / len * width * 0.5f, d.y / len * width * 0.5f};
+        if(first) p0 = (vec2s){p0.x - ext.x, p0.y - ext.y};
+        if(last) p1 = (vec2s){p1.x + ext.x, p1.y + ext.y};
+      }
+    }
+    line_instance(state, p0, p1, width, color, caps);
+  }
+}
+
+void rn_polyline_render(
+  RnState* state, 
+  const vec2s* points, 
+  uint32_t n_points, 
+  float width,
+  RnColor color) {
+  rn_polyline_render_ex(state, points, n_points, width, color, RN_LINE_CAP_BUTT, false);
+}
+
+/* Adds the instance of a shape that is inscribed in the 
+ * ellipse around 'center' (RN_SHAPE_ELLIPSE, RN_SHAPE_ARC).
+ *
+ * Returns NULL if the shape was culled.
+ * */
+RnInstance* 
+ellipse_instance(
+  RnState* state, 
+  vec2s center, 
+  vec2s radii, 
+  RnColor color, 
+  uint8_t shape) {
+  if(radii.x <= 0.0f || radii.y <= 0.0f) return NULL;
+  // The quad covers the anti-aliased edges
+  vec2s half_size = {radii.x + RN_SHAPE_AA_PAD, radii.y + RN_SHAPE_AA_PAD};
+  vec2s pos = {center.x - half_size.x, center.y - half_size.y};
+  vec2s size = {half_size.x * 2.0f, half_size.y * 2.0f};
+  RnInstance* inst = rn_add_instance(state, pos, size, 0.0f, color, 0);
+  if(!inst) return NULL;
+  inst->shape = shape;
+  state->render.features |= RN_SHADER_FEATURE_SHAPED;
+  return inst;
+}
+
+void rn_circle_render(
+  RnState* state, 
+  vec2s center, 
+  float radius,
+  RnColor color) {
+  rn_ellipse_render_ex(state, center, (vec2s){radius, radius}, color, RN_NO_COLOR, 0.0f);
+}
+
+void rn_ellipse_render_ex(
+  RnState* state, 
+  vec2s center, 
+  vec2s radii,
+  RnColor color,
+  RnColor border_color,
+  float border_width) {
+  RnInstance* inst = ellipse_instance(state, center, radii, color, RN_SHAPE_ELLIPSE);
+  if(!inst) return;
+  set_instance_shape(inst, border_color, border_width, 0.0f);
+}
+
+void rn_ellipse_render(
+  RnState* state, 
+  vec2s center, 
+  vec2s radii,
+  RnColor color) {
+  rn_ellipse_render_ex(state, center, radii, color, RN_NO_COLOR, 0.0f);
+}
+
+void rn_arc_render_ex(
+  RnState* state, 
+  vec2s center, 
+  float radius,
+  float thickness,
+  float start_angle,
+  float sweep_angle,
+  RnColor color,
+  RnLineCap cap) {
+  if(thickness <= 0.0f || sweep_angle == 0.0f) return;
+  if(sweep_angle < 0.0f) {
+    start_angle += sweep_angle;
+    sweep_angle = -sweep_angle;
+  }
+  if(cap == RN_LINE_CAP_SQUARE) {
+    // Square caps extend the arc by half it's 
+    // thickness along the middle of the arc
+    float half_thickness = fminf(thickness, radius) * 0.5f;
+    float mid = radius - half_thickness;
+    if(mid > 0.0f) {
+      start_angle -= half_thickness / mid;
+      sweep_angle += half_thickness / mid * 2.0f;
+    }
+  }
+
+  // The angles are stored as fractions of a turn 
+  // within the texture rect of the instance
+  const float turn = 2.0f * GLM_PIf;
+  float start = fmodf(start_angle, turn);
+  if(start < 0.0f) start += turn;
+  RnInstance* inst = ellipse_instance(state, center, (vec2s){radius, radius}, color, 
+                                      RN_SHAPE_ARC | (cap == RN_LINE_CAP_ROUND ? 
+                                      RN_SHAPE_ROUND_START | RN_SHAPE_ROUND_END : 0));
+  if(!inst) return;
+  inst->corner_radius = thickness;
+  set_instance_uv(inst, (vec4s){start / turn, fminf(sweep_angle / turn, 1.0f), 0.0f, 0.0f});
+}
+
+void rn_arc_render(
+  RnState* state, 
+  vec2s center, 
+  float radius,
+  float thickness,
+  float start_angle,
+  float sweep_angle,
+  RnColor color) {
+  rn_arc_render_ex(state, center, radius, thickness, start_angle, 
+                   sweep_angle, color, RN_LINE_CAP_BUTT);
+}
+
+void rn_ring_render(
+  RnState* state, 
+  vec2s center, 
+  float radius,
+  float thickness,
+  RnColor color) {
+  rn_arc_render(state, center, radius, thickness, 0.0f, 2.0f * GLM_PIf, color);
+}
+
+void rn_pie_render(
+  RnState* state, 
+  vec2s center, 
+  float radius,
+  float start_angle,
+  float sweep_angle,
+  RnColor color) {
+  rn_arc_render(state, center, radius, radius, start_angle, sweep_angle, color);
+}
+
+/* Creates a gradient paint in the first free slot of the 
+ * paint table and uploads it. Returns the ID of the paint 
+ * (0 if the paint has no stops).
+ * */
+uint32_t 
+paint_create(
+  RnState* state, 
+  RnPaintType type, 
+  vec2s p0, 
+  vec2s p1, 
+  const RnGradientStop* stops, 
+  uint32_t n_stops) {
+  RnPaintTable* table = &state->render.paints;
+  if(!n_stops) {
+    RN_WARN("Cannot create a gradient without color stops.");
+    return 0;
+  }
+  if(n_stops > RN_PAINT_MAX_STOPS) {
+    RN_WARN("Gradients are limited to %i color stops.", RN_PAINT_MAX_STOPS);
+    n_stops = RN_PAINT_MAX_STOPS;
+  }
+
+  // Reuse the slot of a freed paint
+  uint32_t slot = 0;
+  while(slot < table->n_paints && table->paints[slot].type != RN_PAINT_NONE) {
+    slot++;
+  }
+  if(slot == table->n_paints && table->n_paints == table->paints_cap) {
+    uint32_t cap = table->paints_cap ? table->paints_cap * 2 : 16;
+    RnPaint* paints = realloc(table->paints, sizeof(*paints) * cap);
+    if(!paints) {
+      RN_ERROR("Failed to allocate memory for paints.");
+      exit(EXIT_FAILURE);
+    }
+    table->paints = paints;
+    RnGradientStop* all_stops = realloc(table->stops, 
+                                        sizeof(*all_stops) * cap * RN_PAINT_MAX_STOPS);
+    if(!all_stops) {
+      RN_ERROR("Failed to allocate memory for paints.");
+      exit(EXIT_FAILURE);
+    }
+    table->stops = all_stops;
+    table->paints_cap = cap;
+
+    // Reallocate the buffers with the existing paints
+    glNamedBufferData(table->ssbo_paints, sizeof(RnPaint) * cap, NULL, GL_DYNAMIC_DRAW);
+    glNamedBufferData(table->ssbo_stops, sizeof(RnGradientStop) * cap * RN_PAINT_MAX_STOPS, 
+                      NULL, GL_DYNAMIC_DRAW);
+    if(table->n_paints) {
+      glNamedBufferSubData(table->ssbo_paints, 0, sizeof(RnPaint) * table->n_paints, 
+                           table->paints);
+      glNamedBufferSubData(table->ssbo_stops, 0, sizeof(RnGradientStop) * 
+                           table->n_paints * RN_PAINT_MAX_STOPS, table->stops);
+    }
+  }
+  if(slot == table->n_paints) {
+    table->n_paints++;
+    renderer_bind_paints(state);
+  }
+
+  RnPaint* paint = &table->paints[slot];
+  memset(paint, 0, sizeof(*paint));
+  paint->type = type;
+  paint->stop_start = slot * RN_PAINT_MAX_STOPS;
+  paint->n_stops = n_stops;
+  paint->p0x = p0.x; paint->p0y = p0.y;
+  paint->p1x = p1.x; paint->p1y = p1.y;
+  memcpy(&table->stops[paint->stop_start], stops, sizeof(*stops) * n_stops);
+
+  glNamedBufferSubData(table->ssbo_paints, sizeof(RnPaint) * slot, sizeof(RnPaint), paint);
+  glNamedBufferSubData(table->ssbo_stops, sizeof(RnGradientStop) * paint->stop_start, 
+                       sizeof(RnGradientStop) * n_stops, &table->stops[paint->stop_start]);
+  state->bytes_uploaded += sizeof(RnPaint) + sizeof(RnGradientStop) * n_stops;
+  return slot + 1;
+}
+
+uint32_t 
+rn_paint_create_linear(
+  RnState* state, 
+  vec2s p0, 
+  vec2s p1, 
+  const RnGradientStop* stops, 
+  uint32_t n_stops) {
+  return paint_create(state, RN_PAINT_LINEAR_GRADIENT, p0, p1, stops, n_stops);
+}
+
+uint32_t 
+rn_paint_create_radial(
+  RnState* state, 
+  vec2s center, 
+  vec2s radii, 
+  const RnGradientStop* stops, 
+  uint32_t n_stops) {
+  return paint_create(state, RN_PAINT_RADIAL_GRADIENT, center, radii, stops, n_stops);
+}
+
+void 
+rn_paint_free(RnState* state, uint32_t paint) {
+  RnPaintTable* table = &state->render.paints;
+  if(!paint || paint > table->n_paints) return;
+  // The slot is reused by the next paint, the buffers 
+  // are only written when it is
+  table->paints[paint - 1].type = RN_PAINT_NONE;
+}
+
+void 
+rn_instance_set_paint(RnState* state, RnInstance* inst, uint32_t paint, 
+                      uint8_t shape) {
+  RnPaintTable* table = &state->render.paints;
+  if(!inst || !paint || paint > table->n_paints || 
+     table->paints[paint - 1].type == RN_PAINT_NONE) {
+    return;
+  }
+  // The ID is unpacked from the color in the shader (packUnorm4x8)
+  inst->shape = shape | RN_SHAPE_PAINTED;
+  inst->color[0] = paint & 0xFF;
+  inst->color[1] = (paint >> 8) & 0xFF;
+  inst->color[2] = (paint >> 16) & 0xFF;
+  inst->color[3] = (paint >> 24) & 0xFF;
+  state->render.features |= RN_SHADER_FEATURE_SHAPED;
+}
+
+void 
+rn_rect_render_paint(
+  RnState* state, 
+  vec2s pos, 
+  vec2s size, 
+  float rotation_angle,
+  uint32_t paint, 
+  RnColor border_color, 
+  float border_width,
+  float corner_radius) {
+  // Not clipped to the cull box as the 
+  // gradient is relative to the size 
+  if(!cull_rect(state, &pos, &size, rotation_angle, NULL)) {
+    return;
+  }
+  RnInstance* inst = push_instance(state, pos, size, rotation_angle, RN_NO_COLOR, 0); 
+  set_instance_shape(inst, border_color, border_width, corner_radius);
+  rn_instance_set_paint(state, inst, paint, RN_SHAPE_RECT);
+  state->render.features |= RN_SHADER_FEATURE_SHAPED;
+}
+
+void 
+rn_box_shadow_render(
+  RnState* state, 
+  vec2s pos, 
+  vec2s size, 
+  float radius,
+  float blur,
+  float spread,
+  RnColor color) {
+  // The spread grows the rect and it's corners
+  vec2s box_pos = {pos.x - spread, pos.y - spread};
+  vec2s box_size = {size.x + spread * 2.0f, size.y + spread * 2.0f};
+  if(box_size.x <= 0.0f || box_size.y <= 0.0f) return;
+  float corner_radius = radius > 0.0f ? fmaxf(radius + spread, 0.0f) : 0.0f;
+
+  // The quad covers three standard deviations of the blur
+  float sigma = blur > 0.0f ? blur * 0.5f : 0.0f;
+  float extent = sigma * 3.0f;
+  RnInstance* inst = rn_add_instance(state, 
+                                     (vec2s){box_pos.x - extent, box_pos.y - extent}, 
+                                     (vec2s){box_size.x + extent * 2.0f, box_size.y + extent * 2.0f}, 
+                                     0.0f, color, 0);
+  if(!inst) return;
+  inst->shape = RN_SHAPE_SHADOW;
+  inst->corner_radius = corner_radius;
+  inst->border_width = sigma;
+  state->render.features |= RN_SHADER_FEATURE_SHAPED;
+}
+
 void rn_image_render_adv(
   RnState* state, 
   vec2s pos, 
@@ -1404,15 +5802,34 @@ void rn_image_render_adv(
   RnColor border_color,
   float border_width, 
   float corner_radius) {
-  // Find or add texture and get it's index
-  uint8_t tex_index = rn_tex_index_from_tex(state, tex);
-
-  if (tex_index == 0) {
-    rn_add_tex_to_batch(state, tex);
-    tex_index = (float)state->render.tex_count;
+  // texcoords[0] is the minimum and texcoords[2] the 
+  // maximum corner, the whole texture is rendered without them
+  vec4s uv = texcoords ? 
+    (vec4s){texcoords[0].x, texcoords[0].y, texcoords[2].x, texcoords[2].y} : 
+    (vec4s){0.0f, 0.0f, 1.0f, 1.0f};
+  RnInstance* inst = add_textured_instance(state, pos, (vec2s){tex.width, tex.height}, 
+                        rotation_angle, color, tex, uv,
+                        corner_radius <= 0.0f && border_width <= 0.0f);
+  if(inst) {
+    set_instance_shape(inst, border_color, border_width, corner_radius);
+    if(corner_radius > 0.0f || border_width > 0.0f) {
+      state->render.features |= RN_SHADER_FEATURE_SHAPED;
+    }
   }
+}
 
-  rn_add_instance(state, pos, (vec2s){tex.width, tex.height}, 0.0f, color, tex_index);
+void rn_image_render_sub(
+  RnState* state, 
+  vec2s pos, 
+  vec2s size,
+  RnColor color, 
+  RnTexture tex,
+  RnAABB src) {
+  if(!tex.width || !tex.height) return;
+  float w = (float)tex.width, h = (float)tex.height;
+  add_textured_instance(state, pos, size, 0.0f, color, tex, 
+                        (vec4s){src.minx / w, src.miny / h, 
+                        src.maxx / w, src.maxy / h}, true);
 }
 
 void rn_image_render_ex(
@@ -1502,18 +5919,47 @@ RnTextProps rn_text_render_ex(RnState* state,
   // Get the harfbuzz text information for the string
   RnHarfbuzzText* hb_text = rn_hb_text_from_str(state, *font, text);
 
+  RnTextProps props;
+  text_layout(state, NULL, hb_text, text, font, pos, color, line_height, render, &props);
+  return props;
+}
+
+/* Lays out the glyphs of a shaped text and renders them to 
+ * the current batch or, if 'rec' is given, to a recorder. 
+ *
+ * With a recorder, the caches are only read (so that it is safe 
+ * to call from recording threads) and false is returned without 
+ * recording anything if a glyph of the text is not cached yet.
+ * */
+bool 
+text_layout(
+  RnState* state, 
+  RnRecorder* rec,
+  RnHarfbuzzText* hb_text,
+  const char* text, 
+  RnFont* font, 
+  vec2s pos, 
+  RnColor color, 
+  float line_height,
+  bool render,
+  RnTextProps* props) {
+
   // Retrieve highest bearing if 
   // it was not retrived yet.
+  if(!hb_text->highest_bearing && rec) {
+    return false;
+  }
   if(!hb_text->highest_bearing) {
     for (unsigned int i = 0; i < hb_text->glyph_count; i++) {
       // Get the glyph from the glyph index 
-      RnGlyph glyph =  rn_glyph_from_codepoint(
+      uint32_t slot = get_glyph_from_cache(
         state, font,
         hb_text->glyph_info[i].codepoint);
+      const RnGlyphRenderData* glyph = &state->glyph_cache.hot[slot];
       // Check if the glyph's bearing is higher 
       // than the current highest bearing
-      if(glyph.bearing_y > hb_text->highest_bearing) {
-        hb_text->highest_bearing = glyph.bearing_y;
+      if(glyph->bearing_y > hb_text->highest_bearing) {
+        hb_text->highest_bearing = glyph->bearing_y;
       }
     }
   }
@@ -1531,13 +5977,29 @@ RnTextProps rn_text_render_ex(RnState* state,
   float scale = 1.0f;
   if (font->selected_strike_size)
     scale = ((float)font->size / (float)font->selected_strike_size);
+  uint32_t text_length = strlen(text);
+  uint32_t rec_instances = rec ? rec->n_instances : 0;
+  uint32_t rec_glyphs = rec ? rec->n_glyphs : 0;
   for (unsigned int i = 0; i < hb_text->glyph_count; i++) {
     // Get the glyph from the glyph index
-    RnGlyph glyph =  rn_glyph_from_codepoint(
-      state, font,
-      hb_text->glyph_info[i].codepoint); 
+    uint32_t slot;
+    if(rec) {
+      int32_t cached = get_glyph_from_codepoint(&state->glyph_cache, *font, 
+                                                hb_text->glyph_info[i].codepoint);
+      if(cached == -1) {
+        // Discard the glyphs recorded so far
+        rec->n_instances = rec_instances;
+        rec->n_glyphs = rec_glyphs;
+        return false;
+      }
+      slot = (uint32_t)cached;
+    } else {
+      slot = get_glyph_from_cache(
+        state, font,
+        hb_text->glyph_info[i].codepoint); 
+    }
+    const RnGlyphRenderData* glyph = &state->glyph_cache.hot[slot];
 
-    uint32_t text_length = strlen(text);
     uint32_t codepoint = rn_utf8_to_codepoint(text, hb_text->glyph_info[i].cluster, text_length);
     // Check if the unicode codepoint is a new line and advance 
     // to the next line if so
@@ -1573,12 +6035,16 @@ RnTextProps rn_text_render_ex(RnState* state,
     };
 
     // Render the glyph
-    if(render) {
-      rn_glyph_render(state, glyph, *font, glyph_pos, color);
+    if(render && rec) {
+      recorder_glyph_render(rec, glyph, font->atlas_id, state->glyph_cache.keys[slot], 
+                            glyph_pos, color);
+    } else if(render) {
+      glyph_render(state, glyph, font->atlas_id, state->glyph_cache.keys[slot], 
+                   glyph_pos, color);
     }
 
-    if(glyph.height > textheight) {
-      textheight = glyph.height;
+    if(glyph->height > textheight) {
+      textheight = glyph->height;
     }
 
     // Advance to the next glyph
@@ -1586,11 +6052,12 @@ RnTextProps rn_text_render_ex(RnState* state,
     pos.y += y_advance;
   }
 
-  return (RnTextProps){
+  *props = (RnTextProps){
     .width = pos.x - start_pos.x, 
     .height = textheight,
     .paragraph_pos = pos
   };
+  return true;
 }
 
 
@@ -1719,11 +6186,14 @@ rn_text_render_paragraph_ex(
   char* paragraph_copy = strdup(const_paragraph);  
   char* paragraph = trimspaces(paragraph_copy);
   RnHarfbuzzText* hb_text = rn_hb_text_from_str(state, *font, paragraph);
+  // Measuring the words below shapes more texts, which 
+  // must not evict the paragraph while it is in use
+  hb_text->pins++;
 
   if (!hb_text->highest_bearing) {
     for (unsigned int i = 0; i < hb_text->glyph_count; i++) {
-      RnGlyph glyph = rn_glyph_from_codepoint(state, font, hb_text->glyph_info[i].codepoint);
-      hb_text->highest_bearing = fmaxf(hb_text->highest_bearing, glyph.bearing_y);
+      uint32_t slot = get_glyph_from_cache(state, font, hb_text->glyph_info[i].codepoint);
+      hb_text->highest_bearing = fmaxf(hb_text->highest_bearing, state->glyph_cache.hot[slot].bearing_y);
     }
   }
 
@@ -1733,10 +6203,16 @@ rn_text_render_paragraph_ex(
   uint32_t nwords = hb_text->nwords;
 
   if (!hb_text->words || !nwords) {
+    free(hb_text->words);
     hb_text->words = splitwords((char*)paragraph, &nwords);
+    hb_text->nwords = nwords;
+    hb_cache_account(&state->hb_cache, hb_text);
+  }
+  if(!nwords) {
+    hb_text->pins--;
+    free(paragraph_copy);
+    return (RnTextProps){0};
   }
-  hb_text->nwords = nwords;
-  if(!nwords) return (RnTextProps){0};
 
   float word_ys[nwords];
   memset(word_ys, 0, sizeof(word_ys));
@@ -1794,11 +6270,12 @@ rn_text_render_paragraph_ex(
 
 
   _it = 1;
+  uint32_t paragraph_len = strlen(paragraph);
   for (uint32_t i = 0; i < hb_text->glyph_count; i++) {
     bool wrapped = false;
     if (!hb_text->glyph_info[i].codepoint) 
       continue;
-    RnGlyph glyph = rn_glyph_from_codepoint(state, font, hb_text->glyph_info[i].codepoint);
+    uint32_t slot = get_glyph_from_cache(state, font, hb_text->glyph_info[i].codepoint);
     hb_glyph_position_t hbpos = hb_text->glyph_pos[i];
     float xadv = hbpos.x_advance / 64.0f;
     float yadv = hbpos.y_advance / 64.0f;
@@ -1808,7 +6285,7 @@ rn_text_render_paragraph_ex(
     uint32_t codepoint_idx = hb_text->glyph_info[i].cluster;
     char codepoint = paragraph[codepoint_idx];
 
-    if (codepoint_idx != strlen(paragraph) - 1 && 
+    if (codepoint_idx != paragraph_len - 1 && 
       ((codepoint == ' ' && paragraph[codepoint_idx + 1] != ' ') || 
       (codepoint == '\t' && paragraph[codepoint_idx + 1] != '\t') || 
       (codepoint == '\n' && paragraph[codepoint_idx + 1] != '\n')) &&
@@ -1846,7 +6323,8 @@ rn_text_render_paragraph_ex(
     };
 
     if (render) {
-      rn_glyph_render(state, glyph, *font, glyph_pos, color);
+      glyph_render(state, &state->glyph_cache.hot[slot], font->atlas_id, 
+                   state->glyph_cache.keys[slot], glyph_pos, color);
     }
 
     pos.x += xadv;
@@ -1854,20 +6332,212 @@ rn_text_render_paragraph_ex(
     linew += xadv;
 
     textw = fmaxf(textw, linew);
-    maxasc = fmaxf(maxasc, glyph.ascender);
-    maxdec = fminf(maxdec, glyph.descender);
+    maxasc = fmaxf(maxasc, state->glyph_cache.glyphs[slot].ascender);
+    maxdec = fminf(maxdec, state->glyph_cache.glyphs[slot].descender);
   }
 
   float last_line_h = maxasc + abs(maxdec);
+  hb_text->pins--;
+  free(paragraph_copy);
+
   return (RnTextProps){
     .width = textw, 
     .height = (nwraps > 0) ? (nwraps * font->line_h + last_line_h) : last_line_h, 
     .paragraph_pos = paragraph_pos
   };
+}
 
-  free(paragraph_copy);
+
+/* Sets the rounded corners and the border of an 
+ * instance, evaluated in the fragment shader.
+ * */
+void 
+set_instance_shape(
+  RnInstance* inst, 
+  RnColor border_color, 
+  float border_width, 
+  float corner_radius) {
+  inst->corner_radius = corner_radius > 0.0f ? corner_radius : 0.0f;
+  inst->border_width = border_width > 0.0f ? border_width : 0.0f;
+  inst->border_color[0] = border_color.r;
+  inst->border_color[1] = border_color.g;
+  inst->border_color[2] = border_color.b;
+  inst->border_color[3] = border_color.a;
+}
+
+/* Sets the sampled texture rectangle of an instance 
+ * (u0, v0, u1, v1 in [0, 1])
+ * */
+void 
+set_instance_uv(RnInstance* inst, vec4s uv) {
+  for(uint32_t i = 0; i < 4; i++) {
+    float c = uv.raw[i] < 0.0f ? 0.0f : (uv.raw[i] > 1.0f ? 1.0f : uv.raw[i]);
+    inst->uv[i] = (uint16_t)(c * 65535.0f + 0.5f);
+  }
+}
+
+/* Tests a rectangle (rotated around 'pos') against the 
+ * active cull box. Returns false if the rectangle lies 
+ * completely outside of the box. 
+ *
+ * If 'uv' is given, unrotated rectangles that are partially 
+ * outside are clipped to the box, adjusting their texture 
+ * rectangle. Instances of static batches are never culled, 
+ * as they may be drawn at any offset.
+ * */
+bool 
+cull_rect(RnState* state, vec2s* pos, vec2s* size, float rotation, vec4s* uv) {
+  if(state->render.recording) return true;
+  return cull_rect_box(state->cull_start, state->cull_end, pos, size, rotation, uv, 
+                       &state->culled_instances, &state->clipped_instances);
+}
+
+/* Returns the bounding box of a (rotated) rectangle */
+RnAABB 
+rect_bounds(vec2s pos, vec2s size, float rotation) {
+  RnAABB bounds = {pos.x, pos.y, pos.x + size.x, pos.y + size.y};
+  if(rotation == 0.0f) return bounds;
+
+  // Bounding box of the rotated corners (same 
+  // rotation as within the vertex shader)
+  float c = cosf(rotation), s = sinf(rotation);
+  vec2s corners[3] = {
+    {size.x, 0.0f}, {0.0f, size.y}, {size.x, size.y}
+  };
+  bounds.maxx = pos.x; bounds.maxy = pos.y;
+  for(uint32_t i = 0; i < 3; i++) {
+    float x = pos.x + c * corners[i].x + s * corners[i].y;
+    float y = pos.y - s * corners[i].x + c * corners[i].y;
+    bounds.minx = fminf(bounds.minx, x); bounds.maxx = fmaxf(bounds.maxx, x);
+    bounds.miny = fminf(bounds.miny, y); bounds.maxy = fmaxf(bounds.maxy, y);
+  }
+  return bounds;
+}
+
+/* Tests a rectangle against the cull box given by 
+ * 'start' and 'end' (see 'cull_rect()'), counting 
+ * culled and clipped rectangles.
+ * */
+bool 
+cull_rect_box(vec2s start, vec2s end, vec2s* pos, vec2s* size, float rotation, 
+              vec4s* uv, uint32_t* culled, uint32_t* clipped) {
+  // Every side of the cull box is optional (-1 if unset)
+  bool has_x0 = start.x != -1, has_y0 = start.y != -1;
+  bool has_x1 = end.x != -1,   has_y1 = end.y != -1;
+  if(!has_x0 && !has_y0 && !has_x1 && !has_y1) return true;
+
+  RnAABB bounds = rect_bounds(*pos, *size, rotation);
+  float minx = bounds.minx, miny = bounds.miny;
+  float maxx = bounds.maxx, maxy = bounds.maxy;
+
+  if((has_x0 && maxx <= start.x) || (has_x1 && minx >= end.x) ||
+    (has_y0 && maxy <= start.y) || (has_y1 && miny >= end.y)) {
+    (*culled)++;
+    return false;
+  }
+
+  if(!uv || rotation != 0.0f || size->x <= 0.0f || size->y <= 0.0f) return true;
+
+  float x0 = has_x0 ? fmaxf(minx, start.x) : minx;
+  float y0 = has_y0 ? fmaxf(miny, start.y) : miny;
+  float x1 = has_x1 ? fminf(maxx, end.x) : maxx;
+  float y1 = has_y1 ? fminf(maxy, end.y) : maxy;
+  if(x0 == minx && y0 == miny && x1 == maxx && y1 == maxy) return true;
+
+  // Clip the texture rectangle by the same fractions
+  float du = (uv->z - uv->x) / size->x, dv = (uv->w - uv->y) / size->y;
+  *uv = (vec4s){
+    uv->x + (x0 - minx) * du, uv->y + (y0 - miny) * dv,
+    uv->z - (maxx - x1) * du, uv->w - (maxy - y1) * dv
+  };
+  *pos = (vec2s){x0, y0};
+  *size = (vec2s){x1 - x0, y1 - y0};
+  (*clipped)++;
+  return true;
+}
+
+/* Adds an instance that samples the rectangle 'uv' 
+ * (u0, v0, u1, v1 in [0, 1]) of a given texture, 
+ * adding the texture to the batch if it is not 
+ * part of it yet. If 'clip' is set, the instance is 
+ * clipped to the cull box. 
+ *
+ * Returns NULL if the instance was culled.
+ * */
+RnInstance* 
+add_textured_instance(
+  RnState* state, 
+  vec2s pos, 
+  vec2s size, 
+  float rotation,
+  RnColor color, 
+  RnTexture tex, 
+  vec4s uv,
+  bool clip) {
+  if(!cull_rect(state, &pos, &size, rotation, clip ? &uv : NULL)) {
+    return NULL;
+  }
+  return push_textured_instance(state, pos, size, rotation, color, tex, uv);
+}
+
+/* Adds an instance that samples the rectangle 'uv' of 
+ * a given texture without culling it (see 
+ * 'add_textured_instance()').
+ * */
+RnInstance* 
+push_textured_instance(
+  RnState* state, 
+  vec2s pos, 
+  vec2s size, 
+  float rotation,
+  RnColor color, 
+  RnTexture tex, 
+  vec4s uv) {
+  // Find or add texture and get it's index
+  uint8_t tex_index = rn_tex_index_from_tex(state, tex);
+
+  if (tex_index == 0) {
+    rn_add_tex_to_batch(state, tex);
+    tex_index = (uint8_t)state->render.tex_count;
+  }
+
+  RnInstance* inst = push_instance(state, pos, size, rotation, color, tex_index);
+  set_instance_uv(inst, uv);
+  return inst;
 }
 
+/* Renders a glyph from it's cached render data with 
+ * the atlas texture of it's font. 'key' is the key of 
+ * the glyph within the glyph cache.
+ * */
+void glyph_render(
+  RnState* state, 
+  const RnGlyphRenderData* glyph, 
+  uint32_t atlas_id, 
+  uint64_t key,
+  vec2s pos, 
+  RnColor color) {
+
+  vec2s glyph_pos = {pos.x + glyph->bearing_x, pos.y - glyph->bearing_y};
+  vec2s size = {glyph->width, glyph->height};
+  vec4s uv = {glyph->u0, glyph->v0, glyph->u1, glyph->v1};
+  if(!cull_rect(state, &glyph_pos, &size, 0.0f, &uv)) {
+    return;
+  }
+  RnInstance* inst = push_textured_instance(state, glyph_pos, size, 0.0f, 
+                                            color, (RnTexture){.id = atlas_id}, uv);
+
+  // Static batches patch their glyphs when the atlas is recreated
+  if(inst && state->render.recording) {
+    static_batch_add_glyph(state->render.recording, 
+                           state->render.n_instances - 1, key);
+  }
+  // And so do captured instances of a reordered frame
+  else if(inst && state->render.reorder.enabled && !state->render.reorder.emitting) {
+    RnRecorder* frame = state->render.reorder.frame;
+    recorder_add_glyph(frame, frame->n_instances - 1, key, glyph_uv_clip(glyph, uv));
+  }
+}
 
 void rn_glyph_render(
   RnState* state,
@@ -1875,27 +6545,17 @@ void rn_glyph_render(
   RnFont font,
   vec2s pos,
   RnColor color) {
-
-  vec2s texcoords[4] = { 
-    (vec2s){glyph.u0, glyph.v0}, // Bottom-left
-    (vec2s){glyph.u1, glyph.v0}, // Bottom-right
-    (vec2s){glyph.u1, glyph.v1}, // Top-right
-    (vec2s){glyph.u0, glyph.v1}  // Top-left
+  RnGlyphRenderData data = {
+    .u0 = glyph.u0, .v0 = glyph.v0, 
+    .u1 = glyph.u1, .v1 = glyph.v1,
+    .width = glyph.width, 
+    .height = glyph.height,
+    .bearing_x = glyph.bearing_x, 
+    .bearing_y = glyph.bearing_y,
+    .advance = glyph.advance
   };
-
-  float xpos = pos.x + glyph.bearing_x;
-  float ypos = pos.y - glyph.bearing_y;
-
-  RnTexture tex = (RnTexture){
-    .id = font.atlas_id,
-    .width = glyph.width,
-    .height = glyph.height 
-  };
-
-  rn_image_render_adv(state, (vec2s){xpos, ypos}, 0.0f,
-                      color, tex, texcoords, true,
-                      RN_NO_COLOR, 0.0f,
-                      0.0f);
+  glyph_render(state, &data, font.atlas_id, 
+               glyph_cache_key(font.id, glyph.codepoint), pos, color);
 }
 
 RnGlyph rn_glyph_from_codepoint(
@@ -1903,7 +6563,8 @@ RnGlyph rn_glyph_from_codepoint(
   RnFont* font, 
   uint64_t codepoint
 ) {
-  return get_glyph_from_cache(&state->glyph_cache, font, codepoint);
+  uint32_t slot = get_glyph_from_cache(state, font, codepoint);
+  return state->glyph_cache.glyphs[slot];
 }
 RnHarfbuzzText* rn_hb_text_from_str(
   RnState* state,
@@ -1914,6 +6575,14 @@ RnHarfbuzzText* rn_hb_text_from_str(
 }
 
 
+void rn_set_harfbuzz_cache_budget(
+  RnState* state, 
+  size_t budget
+) {
+  state->hb_cache.budget = budget;
+  hb_cache_trim(&state->hb_cache);
+}
+
 void rn_set_cull_end_x(RnState* state, float x) {
   state->cull_end.x = x; 
 }